@@ -19,6 +19,7 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include <algorithm>
+#include <SDL.h>
 #include "AggroBAIState.h"
 #include "ProjectileFlyBState.h"
 #include "../Savegame/BattleUnit.h"
@@ -26,6 +27,7 @@
 #include "../Savegame/SavedBattleGame.h"
 #include "../Battlescape/TileEngine.h"
 #include "../Savegame/Tile.h"
+#include "../Savegame/SerializationHelper.h"
 #include "../Battlescape/Pathfinding.h"
 #include "../Engine/RNG.h"
 #include "../Engine/Options.h"
@@ -66,6 +68,7 @@ AggroBAIState::AggroBAIState(SavedBattleGame *game, BattleUnit *unit) : BattleAI
     }
 	
 	charge = false;
+	_coverSearch.active = false;
 }
 
 /**
@@ -141,6 +144,45 @@ void AggroBAIState::save(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the AI state from binary.
+ * @param buffer Pointer to the state data, after its name.
+ * @param end End of the save data.
+ */
+void AggroBAIState::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	int aggroTargetID = unserializeInt(buffer, end);
+	int lastKnownTargetID = unserializeInt(buffer, end);
+	for (std::vector<BattleUnit*>::iterator j = _game->getUnits()->begin(); j != _game->getUnits()->end(); ++j)
+	{
+		if ((*j)->getId() == aggroTargetID)
+			_aggroTarget = (*j);
+		if ((*j)->getId() == lastKnownTargetID)
+			_lastKnownTarget = (*j);
+	}
+	_lastKnownPosition.x = unserializeInt(buffer, end);
+	_lastKnownPosition.y = unserializeInt(buffer, end);
+	_lastKnownPosition.z = unserializeInt(buffer, end);
+	_timesNotSeen = unserializeInt(buffer, end);
+	charge = unserializeInt(buffer, end) != 0;
+}
+
+/**
+ * Saves the AI state to binary.
+ * @param buffer Buffer to add the state to.
+ */
+void AggroBAIState::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeString(buffer, "AGGRO");
+	serializeInt(buffer, _aggroTarget ? _aggroTarget->getId() : -1);
+	serializeInt(buffer, _lastKnownTarget ? _lastKnownTarget->getId() : -1);
+	serializeInt(buffer, _lastKnownPosition.x);
+	serializeInt(buffer, _lastKnownPosition.y);
+	serializeInt(buffer, _lastKnownPosition.z);
+	serializeInt(buffer, _timesNotSeen);
+	serializeInt(buffer, charge);
+}
+
 /**
  * Enters the current AI state.
  */
@@ -166,6 +208,21 @@ void AggroBAIState::exit()
  */
 void AggroBAIState::think(BattleAction *action)
 {
+	if (_coverSearch.active && _coverSearch.number == action->number)
+	{
+		// carry on looking for cover where the last frame stopped
+		*action = _coverSearch.action;
+		if (searchCover(action) && endCoverSearch(action))
+		{
+			if (_aggroTarget != 0)
+				setAggroTarget(_aggroTarget);
+			if (charge)
+				action->desperate = true;
+		}
+		return;
+	}
+	_coverSearch.active = false;
+
 	if (Options::getBool("traceAI")) { Log(LOG_INFO) << "AggroBAIState::think() #" << action->number << (charge ? " [charging]": " "); }
 	
  	action->type = BA_RETHINK;
@@ -430,6 +487,7 @@ void AggroBAIState::think(BattleAction *action)
 					int distance = 200;
 					int size = action->actor->getArmor()->getSize(); //-1;
 					int targetsize = _aggroTarget->getArmor()->getSize(); //-1;
+					const ReachabilityMap &reachable = _game->getPathfinding()->getReachabilityMap(action->actor, Pathfinding::UNLIMITED_TU);
 					for (int x = 0 - size; x <= targetsize; ++x)
 					{
 						for (int y = 0 - size; y <= targetsize; ++y)
@@ -437,10 +495,9 @@ void AggroBAIState::think(BattleAction *action)
 							if (!(x == 0 && y == 0))
 							{
 								Position checkPath = _aggroTarget->getPosition() + Position (x, y, 0);
-								_game->getPathfinding()->calculate(action->actor, checkPath, 0);
 								int newDistance = _game->getTileEngine()->distance(action->actor->getPosition(), checkPath);
 								bool valid = _game->getTileEngine()->validMeleeRange(checkPath, -1, action->actor->getArmor()->getSize(), action->actor->getHeight(), _aggroTarget);
-								if (_game->getPathfinding()->getStartDirection() != -1  &&  valid  &&
+								if (checkPath != action->actor->getPosition() && reachable.isReachable(checkPath)  &&  valid  &&
 									newDistance < distance)
 								{
 									// CHAAAAAAARGE!
@@ -451,7 +508,6 @@ void AggroBAIState::think(BattleAction *action)
 									_unit->setCharging(_aggroTarget);
 									distance = newDistance;
 								}
-								_game->getPathfinding()->abortPath();
 							}
 						}
 					}
@@ -487,7 +543,7 @@ void AggroBAIState::think(BattleAction *action)
 				// distance must be more than X tiles, otherwise it's too dangerous to play with explosives
 				if (grenade && explosiveEfficacy(_aggroTarget->getPosition(), _unit, (grenade->getRules()->getPower()/10)+1, action->diff))
 				{
-					if((_unit->getFaction() == FACTION_NEUTRAL && _aggroTarget->getFaction() == FACTION_HOSTILE) || _unit->getFaction() == FACTION_HOSTILE)
+					if (isEnemy(_aggroTarget))
 					{
 						action->weapon = grenade;
 						tu += _unit->getActionTUs(BA_PRIME, grenade);
@@ -516,7 +572,7 @@ void AggroBAIState::think(BattleAction *action)
 					}
 					else
 					{
-						if(action->weapon->getAmmoItem() && ((_unit->getFaction() == FACTION_NEUTRAL && _aggroTarget->getFaction() == FACTION_HOSTILE) || _unit->getFaction() == FACTION_HOSTILE))
+						if(action->weapon->getAmmoItem() && isEnemy(_aggroTarget))
 						{
 							if (action->weapon->getAmmoItem()->getRules()->getDamageType() != DT_HE || explosiveEfficacy(_aggroTarget->getPosition(), _unit, (action->weapon->getAmmoItem()->getRules()->getPower() / 10) +1, action->diff))
 							{
@@ -549,202 +605,32 @@ void AggroBAIState::think(BattleAction *action)
 				// if there is no such tile, we run away from the target.
 				action->type = BA_WALK;
 				_unit->_hidingForTurn = true;
-				int tries = 0;
-				bool coverFound = false;
 				int x_search_sign = RNG::generate(0, 1) ? 1 : -1; // randomize the direction of the search for lack of a better heuristic
 				int y_search_sign = RNG::generate(0, 1) ? 1 : -1;
 				int dx = _unit->getPosition().x - _aggroTarget->getPosition().x; // 2d vector in the direction away from the aggro target
 				int dy = _unit->getPosition().y - _aggroTarget->getPosition().y;
 				int dist = _game->getTileEngine()->distance(_unit->getPosition(), _aggroTarget->getPosition());
-                Vector3i run;
-				run.x = (dx * 5) / dist;
-				run.y = (dy * 5) / dist;
-                run.z = 0;
-				
-				int bestTileScore = -100000;
-				int score = -100000;
-				Position bestTile(0, 0, 0);
+				_coverSearch.run.x = (dx * 5) / dist;
+				_coverSearch.run.y = (dy * 5) / dist;
+				_coverSearch.run.z = 0;
+				_coverSearch.dist = dist;
+				_coverSearch.unitsSpottingMe = unitsSpottingMe;
+				_coverSearch.number = action->number;
+				_coverSearch.tries = 0;
+				_coverSearch.coverFound = false;
+				_coverSearch.bestTileScore = -100000;
+				_coverSearch.score = -100000;
+				_coverSearch.bestTile = Position(0, 0, 0);
+				_coverSearch.traceSpammed = false;
                 ++_randomTileSearchAge;
 				if (action->number > 1) action->desperate = true;
-				
-				Tile *tile = 0;
-				
-				bool traceSpammed = false;
-				
-				// weights of various factors in choosing a tile to which to withdraw
-				const int EXPOSURE_PENALTY = 20;
-				const int WINDOW_PENALTY = 30;
-				const int WALL_BONUS = 1;
-				const int FIRE_PENALTY = 40;
-				const int FRIEND_BONUS = 10;
-				const int SMOKE_PENALTY = 5;
-				const int OVERREACH_PENALTY = EXPOSURE_PENALTY*3;
-				const int MELEE_TUNNELVISION_BONUS = 1000;
-				const int DIRECT_PATH_PENALTY = 10;
-				const int DIRECT_PATH_TO_TARGET_PENALTY = 30;
-				const int BASE_SYSTEMATIC_SUCCESS = 100;
-				const int BASE_DESPERATE_SUCCESS = 110;
-				const int FAST_PASS_THRESHOLD = 120; // a score that's good engouh to quit the while loop early; it's subjective, hand-tuned and may need tweaking
-				const int MAX_ALLY_DISTANCE = 25; // distance^2 actually
-				const int MIN_ALLY_DISTANCE = 4; // don't clump up too much and get grenaded, OK?
-				const int ALLY_BONUS = 4;
-				
-				while (tries < 150 && !coverFound)
-				{
-					tries++;
-					action->target = _unit->getPosition() + run; // start looking in a direction away from the enemy
-					
-					if (!_game->getTile(action->target))
-					{
-						action->target = _unit->getPosition(); // cornered at the edge of the map perhaps? 
-					}
-					
-					if (tries < 121) 
-					{
-						// looking for cover
-						action->target.x += _randomTileSearch[tries].x;
-						action->target.y += _randomTileSearch[tries].y;
-						if (action->target == _unit->getPosition() && action->number == 1 &&  unitsSpottingMe > 0)
-						{
-							// don't even think about staying in the same spot. Move!
-							action->target.x += RNG::generate(-20,20);
-							action->target.y += RNG::generate(-20,20);
-						}
-						//score = _game->getTileEngine()->visible(_aggroTarget, _game->getTile(action->target)) ? 0 : 100;
-						score = BASE_SYSTEMATIC_SUCCESS; // no need for visible here, the TileEngine code will take care of it
-					}
-					else
-					{
-                        if (tries == 121) 
-						{ 
-							action->reckless = true; 
-							if (Options::getBool("traceAI")) 
-							{
-								Log(LOG_INFO) << _unit->getId() << " best score after systematic search was: " << bestTileScore; 
-							}
-						}
-						
-						score = BASE_DESPERATE_SUCCESS; // ruuuuuuun
-                        action->target = _unit->getPosition() + run*3;
-						action->target.x += RNG::generate(-10,10);
-						action->target.y += RNG::generate(-10,10);
-						action->target.z = _unit->getPosition().z + RNG::generate(-1,1);
-						if (action->target.z < 0)
-                        {
-                            action->target.z = 0;
-                        }
-                        else if (action->target.z >= _game->getMapSizeZ()) 
-                        {
-                            action->target.z = _unit->getPosition().z;
-                        }
-					}
 
-					// THINK, DAMN YOU
-					tile = _game->getTile(action->target);
-					if (!tile) 
-					{
-						score = -100000; // no you can't quit the battlefield by running off the map. 
-					}
-					else
-					{
-						_game->getTileEngine()->surveyXComThreatToTile(tile, action->target, _unit);
-						
-						if (tile->soldiersVisible == -1) continue; // you can't go there.
-						
-						if (tile->soldiersVisible && tile->closestSoldierDSqr <= 100 && tile->closestSoldierDSqr > 0) 
-						{
-							score -= (100/tile->closestSoldierDSqr);
-						}
-						
-						if (tile->soldiersVisible && tile->meanSoldierDSqr <= 200 && tile->meanSoldierDSqr > 0) 
-						{
-							score -= (50/tile->meanSoldierDSqr); // less important than above
-						}
-						
-						//if (!tile->_soldiersVisible) { Log(LOG_WARNING) << "No soldiers visible? Really?"; }
-						
-						if (!tile->soldiersVisible)
-						{
-							score += dist*4; // hooray! (4 because it's about 4 TUs to walk a tile?)
-						} else
-						{						
-							score -= tile->soldiersVisible * EXPOSURE_PENALTY;
-							score += (dist > 9) ? 4 : dist; 
-						}
-						
-						if (_unit->getMainHandWeapon() && _unit->getMainHandWeapon()->getRules()->getBattleType() == BT_MELEE
-							 && _unit->getUnitRules() && _unit->getHealth() > _unit->getStats()->health/2)
-						{
-							// did you say "not charge?" KOMPRESSOR BREAK YOUR GLOWSTICK AND KOMPRESSOR EAT YOUR CANDY
-							score -= (dist-1) * MELEE_TUNNELVISION_BONUS;
-							if (score < -90000) score = -90000;
-							charge = true;
-							if (Options::getBool("traceAI") && !traceSpammed) { Log(LOG_INFO) << "Trying to get melee unit to do something."; traceSpammed = true; }
-						}
-						
-						// strength in numbers but not in "grenade us!" huddles:
-						if (tile->closestAlienDSqr < MAX_ALLY_DISTANCE && tile->closestAlienDSqr > MIN_ALLY_DISTANCE) score += ALLY_BONUS;
-						if (tile->closestAlienDSqr <= MIN_ALLY_DISTANCE) score -= ALLY_BONUS;
-						
-						_game->getPathfinding()->setUnit(_unit); // because we can't just pass this around as a paramater, can we... no, that would be too simple
-						
-						if (tile->soldiersVisible && _game->getPathfinding()->bresenhamPath(tile->_closestSoldierPos, action->target, 0, false))
-						{
-							score -= DIRECT_PATH_TO_TARGET_PENALTY; // not even partial cover?
-						}
-						_game->getPathfinding()->abortPath(); // clean up hypothetical path data
-						
-						if (_game->getPathfinding()->bresenhamPath(_aggroTarget->getPosition(), action->target, 0, false)) score -= DIRECT_PATH_PENALTY; // come on partial cover?
-						_game->getPathfinding()->abortPath();						
-						
-						if (tile->getFire()) score -= FIRE_PENALTY; // maybe stop, drop, and roll?
-						
-						if (tile->getSmoke()) score -= SMOKE_PENALTY; // *cough* *cough*
-						
-						if (tile->getMapData(MapData::O_NORTHWALL) || tile->getMapData(MapData::O_WESTWALL)) score += WALL_BONUS; // hug the walls
-						
-						if (_game->getTileEngine()->faceWindow(action->target) != -1) score -= WINDOW_PENALTY; // a window is not cover.
-					}
-
-
-					if (score > bestTileScore)
-					{
-						// check if we can reach this tile
-						_game->getPathfinding()->calculate(_unit, action->target);
-						if (_game->getPathfinding()->getTotalTUCost() > _unit->getTimeUnits())
-						{
-							score -= OVERREACH_PENALTY; // not gonna make it
-						} else
-						{
-							if (tile->soldiersVisible == 0) score += _unit->getTimeUnits() - _game->getPathfinding()->getTotalTUCost(); // conserve TU if possible
-						}
-						if (score > bestTileScore && _game->getPathfinding()->getStartDirection() != -1)
-						{
-							// yay, we can get there and the overreach penalty didn't kill the score
-							bestTileScore = score;
-							bestTile = action->target;
-						}
-						_game->getPathfinding()->abortPath();
-						if (bestTileScore > FAST_PASS_THRESHOLD) coverFound = true; // good enough, gogogo
-					}
-				}
-				if (Options::getBool("traceAI"))
+				if (!searchCover(action))
 				{
-					Log(LOG_INFO) << _unit->getId() << " Taking cover with score " << bestTileScore << " after " << tries << " tries, at a tile spotted by " << ((tile=_game->getTile(bestTile)) ? tile->soldiersVisible : -666) << ". Action #" << action->number;
-					//Log(LOG_INFO) << "Walking " << _game->getTileEngine()->distance(_unit->getPosition(), bestTile) << " squares or so.";
-
+					return; // still looking, carry on next frame
 				}
-				action->target = bestTile;
-				
-				if (_aggroTarget != 0)
-					setAggroTarget(_aggroTarget);
-
-				
-				if (score <= -100000) 
+				if (!endCoverSearch(action))
 				{
-					coverFound = false;
-					action->type = BA_NONE;
-					action->TU = 0;
 					return;
 				}
 			}
@@ -758,6 +644,241 @@ void AggroBAIState::think(BattleAction *action)
 		action->desperate = true;
 }
 
+/**
+ * Looks at tiles around the unit for the best one to take cover at, scoring how exposed
+ * each is, until a good enough one is found or all tries are used up.
+ * With the battleAIFrameBudget option set, the search stops when it runs over that many
+ * milliseconds and sets the action to BA_THINK; the next think carries on where it stopped.
+ * Nothing in the battle changes in between, so it ends up with the same tile either way.
+ * @param action The action being worked out.
+ * @return True when the search is done.
+ */
+bool AggroBAIState::searchCover(BattleAction *action)
+{
+	// weights of various factors in choosing a tile to which to withdraw
+	const int EXPOSURE_PENALTY = 20;
+	const int WINDOW_PENALTY = 30;
+	const int WALL_BONUS = 1;
+	const int FIRE_PENALTY = 40;
+	const int FRIEND_BONUS = 10;
+	const int SMOKE_PENALTY = 5;
+	const int OVERREACH_PENALTY = EXPOSURE_PENALTY*3;
+	const int MELEE_TUNNELVISION_BONUS = 1000;
+	const int DIRECT_PATH_PENALTY = 10;
+	const int DIRECT_PATH_TO_TARGET_PENALTY = 30;
+	const int BASE_SYSTEMATIC_SUCCESS = 100;
+	const int BASE_DESPERATE_SUCCESS = 110;
+	const int FAST_PASS_THRESHOLD = 120; // a score that's good engouh to quit the while loop early; it's subjective, hand-tuned and may need tweaking
+	const int MAX_ALLY_DISTANCE = 25; // distance^2 actually
+	const int MIN_ALLY_DISTANCE = 4; // don't clump up too much and get grenaded, OK?
+	const int ALLY_BONUS = 4;
+	
+	int &tries = _coverSearch.tries;
+	bool &coverFound = _coverSearch.coverFound;
+	int &bestTileScore = _coverSearch.bestTileScore;
+	int &score = _coverSearch.score;
+	Position &bestTile = _coverSearch.bestTile;
+	bool &traceSpammed = _coverSearch.traceSpammed;
+	const Vector3i &run = _coverSearch.run;
+	int dist = _coverSearch.dist;
+	int unitsSpottingMe = _coverSearch.unitsSpottingMe;
+	Tile *tile = 0;
+
+	int budget = Options::getInt("battleAIFrameBudget");
+	Uint32 start = SDL_GetTicks();
+	int firstTry = tries;
+
+	// one search for the cost to every tile around, instead of one per tile we look at
+	const ReachabilityMap &reachable = _game->getPathfinding()->getReachabilityMap(_unit, Pathfinding::UNLIMITED_TU);
+
+	while (tries < 150 && !coverFound)
+	{
+		if (budget > 0 && tries > firstTry && SDL_GetTicks() - start >= (Uint32)budget)
+		{
+			// out of time for this frame, pick up from here next time
+			_coverSearch.active = true;
+			_coverSearch.action = *action;
+			action->type = BA_THINK;
+			return false;
+		}
+		tries++;
+		action->target = _unit->getPosition() + run; // start looking in a direction away from the enemy
+		
+		if (!_game->getTile(action->target))
+		{
+			action->target = _unit->getPosition(); // cornered at the edge of the map perhaps? 
+		}
+		
+		if (tries < 121) 
+		{
+			// looking for cover
+			action->target.x += _randomTileSearch[tries].x;
+			action->target.y += _randomTileSearch[tries].y;
+			if (action->target == _unit->getPosition() && action->number == 1 &&  unitsSpottingMe > 0)
+			{
+				// don't even think about staying in the same spot. Move!
+				action->target.x += RNG::generate(-20,20);
+				action->target.y += RNG::generate(-20,20);
+			}
+			//score = _game->getTileEngine()->visible(_aggroTarget, _game->getTile(action->target)) ? 0 : 100;
+			score = BASE_SYSTEMATIC_SUCCESS; // no need for visible here, the TileEngine code will take care of it
+		}
+		else
+		{
+            if (tries == 121) 
+			{ 
+				action->reckless = true; 
+				if (Options::getBool("traceAI")) 
+				{
+					Log(LOG_INFO) << _unit->getId() << " best score after systematic search was: " << bestTileScore; 
+				}
+			}
+			
+			score = BASE_DESPERATE_SUCCESS; // ruuuuuuun
+            action->target = _unit->getPosition() + run*3;
+			action->target.x += RNG::generate(-10,10);
+			action->target.y += RNG::generate(-10,10);
+			action->target.z = _unit->getPosition().z + RNG::generate(-1,1);
+			if (action->target.z < 0)
+            {
+                action->target.z = 0;
+            }
+            else if (action->target.z >= _game->getMapSizeZ()) 
+            {
+                action->target.z = _unit->getPosition().z;
+            }
+		}
+
+		// THINK, DAMN YOU
+		tile = _game->getTile(action->target);
+		if (!tile) 
+		{
+			score = -100000; // no you can't quit the battlefield by running off the map. 
+		}
+		else
+		{
+			_game->getTileEngine()->surveyXComThreatToTile(tile, action->target, _unit);
+			
+			if (tile->soldiersVisible == -1) continue; // you can't go there.
+			
+			if (tile->soldiersVisible && tile->closestSoldierDSqr <= 100 && tile->closestSoldierDSqr > 0) 
+			{
+				score -= (100/tile->closestSoldierDSqr);
+			}
+			
+			if (tile->soldiersVisible && tile->meanSoldierDSqr <= 200 && tile->meanSoldierDSqr > 0) 
+			{
+				score -= (50/tile->meanSoldierDSqr); // less important than above
+			}
+			
+			//if (!tile->_soldiersVisible) { Log(LOG_WARNING) << "No soldiers visible? Really?"; }
+			
+			if (!tile->soldiersVisible)
+			{
+				score += dist*4; // hooray! (4 because it's about 4 TUs to walk a tile?)
+			} else
+			{						
+				score -= tile->soldiersVisible * EXPOSURE_PENALTY;
+				score += (dist > 9) ? 4 : dist; 
+			}
+			
+			if (_unit->getMainHandWeapon() && _unit->getMainHandWeapon()->getRules()->getBattleType() == BT_MELEE
+				 && _unit->getUnitRules() && _unit->getHealth() > _unit->getStats()->health/2)
+			{
+				// did you say "not charge?" KOMPRESSOR BREAK YOUR GLOWSTICK AND KOMPRESSOR EAT YOUR CANDY
+				score -= (dist-1) * MELEE_TUNNELVISION_BONUS;
+				if (score < -90000) score = -90000;
+				charge = true;
+				if (Options::getBool("traceAI") && !traceSpammed) { Log(LOG_INFO) << "Trying to get melee unit to do something."; traceSpammed = true; }
+			}
+			
+			// strength in numbers but not in "grenade us!" huddles:
+			if (tile->closestAlienDSqr < MAX_ALLY_DISTANCE && tile->closestAlienDSqr > MIN_ALLY_DISTANCE) score += ALLY_BONUS;
+			if (tile->closestAlienDSqr <= MIN_ALLY_DISTANCE) score -= ALLY_BONUS;
+			
+			_game->getPathfinding()->setUnit(_unit); // because we can't just pass this around as a paramater, can we... no, that would be too simple
+			
+			if (tile->soldiersVisible && _game->getPathfinding()->bresenhamPath(tile->_closestSoldierPos, action->target, 0, false))
+			{
+				score -= DIRECT_PATH_TO_TARGET_PENALTY; // not even partial cover?
+			}
+			_game->getPathfinding()->abortPath(); // clean up hypothetical path data
+			
+			if (_game->getPathfinding()->bresenhamPath(_aggroTarget->getPosition(), action->target, 0, false)) score -= DIRECT_PATH_PENALTY; // come on partial cover?
+			_game->getPathfinding()->abortPath();						
+			
+			if (tile->getFire()) score -= FIRE_PENALTY; // maybe stop, drop, and roll?
+			
+			if (tile->getSmoke()) score -= SMOKE_PENALTY; // *cough* *cough*
+			
+			if (tile->getMapData(MapData::O_NORTHWALL) || tile->getMapData(MapData::O_WESTWALL)) score += WALL_BONUS; // hug the walls
+			
+			if (_game->getTileEngine()->faceWindow(action->target) != -1) score -= WINDOW_PENALTY; // a window is not cover.
+		}
+
+
+		if (score > bestTileScore)
+		{
+			// check if we can reach this tile
+			int tuCost = reachable.getTUCost(action->target);
+			if (tuCost > _unit->getTimeUnits())
+			{
+				score -= OVERREACH_PENALTY; // not gonna make it
+			} else
+			{
+				if (tile->soldiersVisible == 0) score += _unit->getTimeUnits() - tuCost; // conserve TU if possible
+			}
+			if (score > bestTileScore && tuCost != -1 && action->target != _unit->getPosition())
+			{
+				// yay, we can get there and the overreach penalty didn't kill the score
+				bestTileScore = score;
+				bestTile = action->target;
+			}
+			if (bestTileScore > FAST_PASS_THRESHOLD) coverFound = true; // good enough, gogogo
+		}
+	}
+	_coverSearch.active = false;
+	return true;
+}
+
+/**
+ * Sends the unit to the tile the cover search found.
+ * @param action The action being worked out.
+ * @return False if there's nowhere to go, and the unit does nothing.
+ */
+bool AggroBAIState::endCoverSearch(BattleAction *action)
+{
+	if (Options::getBool("traceAI"))
+	{
+		Tile *tile = _game->getTile(_coverSearch.bestTile);
+		Log(LOG_INFO) << _unit->getId() << " Taking cover with score " << _coverSearch.bestTileScore << " after " << _coverSearch.tries << " tries, at a tile spotted by " << (tile ? tile->soldiersVisible : -666) << ". Action #" << action->number;
+	}
+	action->target = _coverSearch.bestTile;
+
+	if (_aggroTarget != 0)
+		setAggroTarget(_aggroTarget);
+
+	if (_coverSearch.score <= -100000)
+	{
+		action->type = BA_NONE;
+		action->TU = 0;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Checks if a unit is on the other side from this unit, so it may be shot at.
+ * The player's units and the civilians are on one side and the aliens on the other,
+ * whichever side the AI is playing.
+ * @param unit Pointer to the unit.
+ * @return True if the unit is an enemy.
+ */
+bool AggroBAIState::isEnemy(BattleUnit *unit) const
+{
+	return (_unit->getFaction() == FACTION_HOSTILE) != (unit->getFaction() == FACTION_HOSTILE);
+}
+
 /**
  * Sets the aggro target to be used by the AI.
  * Note that this does not mean the AI will chase the unit, it will just walk towards this position.
@@ -43,6 +43,24 @@ protected:
     static std::vector<Position> _randomTileSearch;
     static int _randomTileSearchAge;
 	bool charge;
+	/// Where a search for cover that ran over a frame's time got to.
+	struct CoverSearch
+	{
+		bool active;
+		int number;
+		BattleAction action;
+		int tries, bestTileScore, score, dist, unitsSpottingMe;
+		bool coverFound, traceSpammed;
+		Position bestTile;
+		Vector3i run;
+	};
+	CoverSearch _coverSearch;
+	/// Looks for a tile to take cover at, for as long as a frame allows.
+	bool searchCover(BattleAction *action);
+	/// Sends the unit to the tile the cover search found.
+	bool endCoverSearch(BattleAction *action);
+	/// Checks if a unit is on the other side from this unit.
+	bool isEnemy(BattleUnit *unit) const;
 public:
 	/// Creates a new AggroBAIState linked to the game and a certain unit.
 	AggroBAIState(SavedBattleGame *game, BattleUnit *unit);
@@ -52,6 +70,10 @@ public:
 	void load(const YAML::Node& node);
 	/// Saves the AI state to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads the AI state from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the AI state to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Enters the state.
 	void enter();
 	/// Exits the state.
@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "BattleAIState.h"
+#include "../Savegame/SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -53,6 +54,25 @@ void BattleAIState::save(YAML::Emitter &) const
 {
 }
 
+/**
+ * Loads the AI state from binary.
+ * @param buffer Pointer to the state data, after its name.
+ * @param end End of the save data.
+ */
+void BattleAIState::loadBinary(Uint8 **, const Uint8 *)
+{
+}
+
+/**
+ * Saves the AI state to binary, starting with its name,
+ * which is empty for a state that keeps nothing.
+ * @param buffer Buffer to add the state to.
+ */
+void BattleAIState::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeString(buffer, "");
+}
+
 
 /**
  * Enters the current AI state.
@@ -19,6 +19,8 @@
 #ifndef OPENXCOM_BATTLEAISTATE_H
 #define OPENXCOM_BATTLEAISTATE_H
 
+#include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
 #include "BattlescapeGame.h"
 
@@ -46,6 +48,10 @@ public:
 	virtual void load(const YAML::Node& node);
 	/// Saves the AI state to YAML.
 	virtual void save(YAML::Emitter& out) const;
+	/// Loads the AI state from binary.
+	virtual void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the AI state to binary.
+	virtual void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Enters the state.
 	virtual void enter();
 	/// Exits the state.
@@ -0,0 +1,579 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "BattleSimulator.h"
+#include <list>
+#include "TileEngine.h"
+#include "Pathfinding.h"
+#include "Projectile.h"
+#include "PatrolBAIState.h"
+#include "AggroBAIState.h"
+#include "UnitWalkBState.h"
+#include "ProjectileFlyBState.h"
+#include "ExplosionBState.h"
+#include "../Engine/CrossPlatform.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Savegame/BattleUnit.h"
+#include "../Savegame/BattleItem.h"
+#include "../Savegame/Tile.h"
+#include "../Ruleset/Ruleset.h"
+#include "../Ruleset/RuleItem.h"
+#include "../Ruleset/Armor.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Creates a simulator for a battle. The battle's map resources have to be loaded already.
+ * @param save Pointer to the battle.
+ * @param rules Pointer to the ruleset.
+ * @param res Pointer to the resource pack the projectiles use.
+ * @param difficulty The difficulty the AI plays at.
+ */
+BattleSimulator::BattleSimulator(SavedBattleGame *save, Ruleset *rules, ResourcePack *res, GameDifficulty difficulty) : _save(save), _rules(rules), _res(res), _difficulty(difficulty), _aiTime(0), _pathfindingTime(0), _fovTime(0), _explosionTime(0), _plans(0), _planHits(0), _planMisses(0)
+{
+}
+
+/**
+ * Cleans up the simulator.
+ */
+BattleSimulator::~BattleSimulator()
+{
+}
+
+/**
+ * Plays the battle side turn by side turn, like the AI turns of the battlescape,
+ * until one side has no units left standing or the turn limit is reached.
+ * @param maxTurns The last turn to play.
+ */
+void BattleSimulator::run(int maxTurns)
+{
+	while (!isOver() && _save->getTurn() <= maxTurns)
+	{
+		double start = CrossPlatform::getTime();
+		prepareSide();
+
+		// units taken over or knocked out during the turn don't get to move
+		UnitFaction side = _save->getSide();
+		std::vector<BattleUnit*> units;
+		for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
+		{
+			if ((*i)->getFaction() == side && !(*i)->isOut())
+			{
+				units.push_back(*i);
+			}
+		}
+		for (std::vector<BattleUnit*>::iterator i = units.begin(); i != units.end() && !isOver(); ++i)
+		{
+			if ((*i)->getFaction() == side && !(*i)->isOut())
+			{
+				playUnit(*i);
+			}
+		}
+
+		_save->getTileEngine()->closeUfoDoors();
+		double fov = CrossPlatform::getTime();
+		_save->endTurn();
+		_fovTime += CrossPlatform::getTime() - fov;
+		explodeTerrain();
+		checkForCasualties();
+
+		_turnTimes.push_back(CrossPlatform::getTime() - start);
+	}
+	_planHits += _save->getPathfinding()->getPlanHits();
+	_planMisses += _save->getPathfinding()->getPlanMisses();
+}
+
+/**
+ * Resets the AI's scratch data on the tiles and works out where the units of
+ * the side to move can walk to, like BattlescapeGame::resetSituationForAI does
+ * for the aliens.
+ */
+void BattleSimulator::prepareSide()
+{
+	double start = CrossPlatform::getTime();
+	_save->getTileEngine()->updateThreatSurvey(_save->getSide(), true);
+	_aiTime += CrossPlatform::getTime() - start;
+
+	std::vector<BattleUnit*> units;
+	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
+	{
+		if ((*i)->getFaction() == _save->getSide() && !(*i)->isOut() && dynamic_cast<AggroBAIState*>((*i)->getCurrentAIState()))
+		{
+			units.push_back(*i);
+		}
+	}
+	Pathfinding *pf = _save->getPathfinding();
+	_plans += units.size();
+	_planHits += pf->getPlanHits();
+	_planMisses += pf->getPlanMisses();
+	start = CrossPlatform::getTime();
+	pf->planReachability(units, Pathfinding::UNLIMITED_TU);
+	_pathfindingTime += CrossPlatform::getTime() - start;
+}
+
+/**
+ * Lets the AI of a unit think and act until it is idle or has had its four
+ * actions, switching between patrolling and aggro the way BattlescapeGame::handleAI does.
+ * @param unit Pointer to the unit.
+ */
+void BattleSimulator::playUnit(BattleUnit *unit)
+{
+	unit->_hidingForTurn = false;
+	unit->_desperatelySeekingCover = false;
+	for (int number = 1; !unit->isOut() && !isOver(); ++number)
+	{
+		if (!unit->getCurrentAIState())
+		{
+			unit->setAIState(new PatrolBAIState(_save, unit, 0));
+		}
+		AggroBAIState *aggro = dynamic_cast<AggroBAIState*>(unit->getCurrentAIState());
+		if (unit->getStats()->psiSkill
+			|| (unit->getMainHandWeapon() && unit->getMainHandWeapon()->getRules()->isWaypoint())
+			|| number > 2)
+		{
+			if (aggro == 0)
+			{
+				aggro = new AggroBAIState(_save, unit);
+				unit->setAIState(aggro);
+			}
+		}
+
+		BattleAction action;
+		action.diff = _difficulty;
+		action.number = number;
+		double start = CrossPlatform::getTime();
+		_save->getTileEngine()->updateThreatSurvey(unit->getFaction(), false);
+		// there is no frame to give back to, so a sliced cover search just carries on
+		do
+		{
+			unit->think(&action);
+		}
+		while (action.type == BA_THINK);
+		if (action.type == BA_RETHINK)
+		{
+			unit->setAIState(new PatrolBAIState(_save, unit, 0));
+			unit->think(&action);
+		}
+		_aiTime += CrossPlatform::getTime() - start;
+
+		if (action.type == BA_NONE)
+		{
+			if (aggro != 0)
+			{
+				unit->setAIState(new PatrolBAIState(_save, unit, 0));
+			}
+			break;
+		}
+
+		execute(action);
+		unit->spendTimeUnits(action.TU);
+		checkForCasualties();
+		if (number > 3)
+		{
+			break;
+		}
+	}
+}
+
+/**
+ * Carries out an action straight away. The checks and the damage are left to the
+ * same code the battle states use, only the animations are skipped.
+ * @param action The action to carry out.
+ */
+void BattleSimulator::execute(BattleAction &action)
+{
+	BattleUnit *unit = action.actor;
+	if (action.type == BA_WALK)
+	{
+		walk(action);
+		return;
+	}
+	if (!action.weapon || !_save->getTile(action.target) || unit->isOut())
+	{
+		return;
+	}
+
+	unit->lookAt(action.target);
+	while (unit->getStatus() == STATUS_TURNING)
+	{
+		unit->turn();
+	}
+
+	if (action.type == BA_MINDCONTROL || action.type == BA_PANIC)
+	{
+		action.weapon = new BattleItem(_rules->getItem("ALIEN_PSI_WEAPON"), _save->getCurrentItemId());
+		action.TU = action.weapon->getRules()->getTUUse();
+		if (_save->getTile(action.target)->getUnit())
+		{
+			_save->getTileEngine()->psiAttack(&action);
+		}
+		_save->removeItem(action.weapon);
+		return;
+	}
+	if (!ProjectileFlyBState::validateAction(_save->getTileEngine(), &action).empty())
+	{
+		return;
+	}
+
+	switch (action.type)
+	{
+	case BA_SNAPSHOT:
+	case BA_AIMEDSHOT:
+	case BA_AUTOSHOT:
+	case BA_LAUNCH:
+	case BA_THROW:
+		shoot(action);
+		break;
+	case BA_HIT:
+		impact(Position(action.target.x * 16 + 8, action.target.y * 16 + 8, action.target.z * 24 + 10), action.weapon, unit);
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * Walks a unit along the path to the action's target one step at a time, like
+ * UnitWalkBState does: opening doors, setting off proximity grenades, looking around
+ * after every step and stopping when it spots someone new or gets shot at.
+ * @param action The walk action.
+ */
+void BattleSimulator::walk(BattleAction &action)
+{
+	BattleUnit *unit = action.actor;
+	Pathfinding *pf = _save->getPathfinding();
+	TileEngine *engine = _save->getTileEngine();
+
+	double start = CrossPlatform::getTime();
+	pf->calculate(unit, action.target);
+	_pathfindingTime += CrossPlatform::getTime() - start;
+
+	while (pf->getStartDirection() != -1 && !unit->isOut())
+	{
+		int dir = pf->getStartDirection();
+		Position destination;
+		int energy;
+		int tu = UnitWalkBState::getStepCost(pf, unit, dir, action.run, &destination, &energy);
+		if (tu > unit->getTimeUnits() || !_save->setUnitPosition(unit, destination, true))
+		{
+			break;
+		}
+		if (dir < Pathfinding::DIR_UP)
+		{
+			unit->setDirection(dir);
+		}
+		// ufo doors don't need to finish opening, nobody is watching
+		engine->unitOpensDoor(unit);
+		pf->dequeuePath();
+		if (!unit->spendTimeUnits(tu) || !unit->spendEnergy(energy))
+		{
+			break;
+		}
+
+		Position from = unit->getPosition();
+		unit->setPosition(destination);
+		UnitWalkBState::moveOnTiles(_save, unit, from);
+
+		start = CrossPlatform::getTime();
+		engine->calculateUnitLighting();
+		bool spotted = engine->calculateFOV(unit);
+		_fovTime += CrossPlatform::getTime() - start;
+
+		Position voxel;
+		BattleItem *grenade = UnitWalkBState::triggerProximityGrenade(_save, unit, &voxel);
+		if (grenade)
+		{
+			impact(voxel, grenade, grenade->getPreviousOwner());
+			continue;
+		}
+
+		BattleAction reaction;
+		if (!action.reckless && engine->checkReactionFire(unit, &reaction))
+		{
+			execute(reaction);
+			reaction.actor->spendTimeUnits(reaction.TU);
+			checkForCasualties();
+			break;
+		}
+		if (spotted && !action.desperate)
+		{
+			break;
+		}
+	}
+	pf->abortPath();
+}
+
+/**
+ * Fires a shot, a burst or a guided missile, or throws an item, following each
+ * projectile to where it lands and spending the ammo like ProjectileFlyBState does.
+ * @param action The shooting or throwing action.
+ */
+void BattleSimulator::shoot(BattleAction &action)
+{
+	BattleUnit *unit = action.actor;
+	BattleItem *weapon = action.weapon;
+	int shots = action.type == BA_AUTOSHOT ? 3 : 1;
+	Position origin = unit->getPosition();
+	std::list<Position> waypoints = action.waypoints;
+	if (waypoints.empty())
+	{
+		waypoints.push_back(action.target);
+	}
+	for (int shot = 0; shot < shots && !unit->isOut(); ++shot)
+	{
+		BattleItem *ammo = weapon->getAmmoItem();
+		if (action.type != BA_THROW && (ammo == 0 || ammo->getAmmoQuantity() == 0))
+		{
+			return;
+		}
+		action.target = waypoints.front();
+		++action.autoShotCounter;
+		Projectile projectile(_res, _save, action, origin);
+		int impactType = -1;
+		if (action.type == BA_THROW)
+		{
+			if (!projectile.calculateThrow(unit->getThrowingAccuracy()))
+			{
+				return;
+			}
+			weapon->moveToOwner(0);
+		}
+		else if (weapon->getRules()->getArcingShot())
+		{
+			if (!projectile.calculateThrow(unit->getFiringAccuracy(action.type, weapon)))
+			{
+				return;
+			}
+		}
+		else
+		{
+			impactType = projectile.calculateTrajectory(unit->getFiringAccuracy(action.type, weapon));
+			if (impactType == -1 && action.type != BA_LAUNCH)
+			{
+				return;
+			}
+			if (action.type != BA_LAUNCH)
+			{
+				ProjectileFlyBState::spendBullet(_save, weapon, ammo);
+			}
+		}
+		while (projectile.move())
+		{
+		}
+
+		if (action.type == BA_THROW)
+		{
+			// thrown grenades go off where they land, as with the battleInstantGrenade option
+			Position voxel = projectile.getPosition(-1);
+			if (weapon->getRules()->getBattleType() == BT_GRENADE && weapon->getExplodeTurn() > 0)
+			{
+				impact(voxel, weapon, unit);
+				_save->removeItem(weapon);
+			}
+			else
+			{
+				Tile *tile = _save->getTile(Position(voxel.x / 16, voxel.y / 16, voxel.z / 24));
+				if (tile)
+				{
+					tile->addItem(weapon, _rules->getInventory("STR_GROUND"));
+					_save->getTileEngine()->applyItemGravity(tile);
+				}
+			}
+		}
+		else if (action.type == BA_LAUNCH && impactType == -1 && waypoints.size() > 1)
+		{
+			// a guided missile that got to its waypoint carries on to the next one
+			origin = waypoints.front();
+			waypoints.pop_front();
+			--shot;
+		}
+		else
+		{
+			if (action.type == BA_LAUNCH)
+			{
+				ProjectileFlyBState::spendBullet(_save, weapon, ammo);
+			}
+			if (impactType != 5)
+			{
+				impact(projectile.getPosition(ProjectileFlyBState::getImpactOffset(ammo)), ammo, unit);
+			}
+		}
+	}
+}
+
+/**
+ * Sets off an item's damage at a voxel the way ExplosionBState does, without turning
+ * anyone into a zombie, and then whatever terrain it set off.
+ * @param voxel The voxel it hits.
+ * @param item The item doing the damage.
+ * @param unit The unit that used the item.
+ */
+void BattleSimulator::impact(const Position &voxel, BattleItem *item, BattleUnit *unit)
+{
+	double start = CrossPlatform::getTime();
+	ExplosionBState::detonate(_save->getTileEngine(), voxel, item->getRules()->getPower(), item, unit, 0);
+	_explosionTime += CrossPlatform::getTime() - start;
+	explodeTerrain();
+	checkForCasualties();
+}
+
+/**
+ * Sets off every tile that was left waiting to blow up, one after the other
+ * like ExplosionBState does, or all together with the flood fill explosions.
+ */
+void BattleSimulator::explodeTerrain()
+{
+	double start = CrossPlatform::getTime();
+	TileEngine *engine = _save->getTileEngine();
+	Tile *tile;
+	while ((tile = engine->checkForTerrainExplosions()))
+	{
+		Position center(tile->getPosition().x * 16, tile->getPosition().y * 16, tile->getPosition().z * 24);
+		ExplosionBState::detonate(engine, center, tile->getExplosive(), 0, 0, tile);
+	}
+	_explosionTime += CrossPlatform::getTime() - start;
+}
+
+/**
+ * Makes the units that were killed or knocked out fall down and takes them off the map.
+ * Unlike UnitDieBState no corpses or dropped items are left behind,
+ * and there are no morale changes or revenge.
+ */
+void BattleSimulator::checkForCasualties()
+{
+	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
+	{
+		BattleUnit *unit = *i;
+		if (unit->isOut() || (unit->getHealth() > 0 && unit->getStunlevel() < unit->getHealth()))
+		{
+			continue;
+		}
+		unit->startFalling();
+		while (unit->getStatus() == STATUS_COLLAPSING)
+		{
+			unit->keepFalling();
+		}
+		unit->clearVisibleUnits();
+		unit->setTile(0);
+		int size = unit->getArmor()->getSize() - 1;
+		for (int x = size; x >= 0; x--)
+		{
+			for (int y = size; y >= 0; y--)
+			{
+				Tile *tile = _save->getTile(unit->getPosition() + Position(x,y,0));
+				if (tile && tile->getUnit() == unit)
+				{
+					tile->setUnit(0);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Checks if a faction has units left standing, counting the units by the side they started on.
+ * @param faction The faction.
+ * @return True if any of its units can still fight.
+ */
+bool BattleSimulator::isAlive(UnitFaction faction) const
+{
+	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
+	{
+		if ((*i)->getOriginalFaction() == faction && (*i)->getHealth() > 0 && (*i)->getHealth() > (*i)->getStunlevel())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Checks if one side has won, which is when the player or the aliens have nobody left standing.
+ * @return True if the battle is over.
+ */
+bool BattleSimulator::isOver() const
+{
+	return !isAlive(FACTION_PLAYER) || !isAlive(FACTION_HOSTILE);
+}
+
+/**
+ * Gets how long each side's turn took, including the end of the turn.
+ * @return The turn times in seconds, in the order they were played.
+ */
+const std::vector<double> &BattleSimulator::getTurnTimes() const
+{
+	return _turnTimes;
+}
+
+/**
+ * Gets the time spent in the AI deciding what to do, including
+ * the path searches and line of fire checks it does while thinking.
+ * @return Time in seconds.
+ */
+double BattleSimulator::getAITime() const
+{
+	return _aiTime;
+}
+
+/**
+ * Gets the time spent finding paths for the units that walk
+ * and planning where every unit can walk to at the start of a turn.
+ * @return Time in seconds.
+ */
+double BattleSimulator::getPathfindingTime() const
+{
+	return _pathfindingTime;
+}
+
+/**
+ * Gets the time spent working out what units see, after every step
+ * and for everyone at the end of every turn.
+ * @return Time in seconds.
+ */
+double BattleSimulator::getFOVTime() const
+{
+	return _fovTime;
+}
+
+/**
+ * Gets the time spent in explosions, hits and the terrain they set off.
+ * @return Time in seconds.
+ */
+double BattleSimulator::getExplosionTime() const
+{
+	return _explosionTime;
+}
+
+/**
+ * Gets how the reachability maps planned at the start of each side's turn
+ * worked out: how many were planned, how many times the AI used one,
+ * and how many times one had to be worked out again because an earlier
+ * move changed the tiles it depended on.
+ * @param plans Returns the number of maps planned.
+ * @param hits Returns the number of times a planned map was used.
+ * @param misses Returns the number of times a planned map was worked out again.
+ */
+void BattleSimulator::getPlanCounts(int *plans, int *hits, int *misses) const
+{
+	*plans = _plans;
+	*hits = _planHits;
+	*misses = _planMisses;
+}
+
+}
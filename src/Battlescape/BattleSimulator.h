@@ -0,0 +1,94 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_BATTLESIMULATOR_H
+#define OPENXCOM_BATTLESIMULATOR_H
+
+#include <vector>
+#include "BattlescapeGame.h"
+#include "../Savegame/SavedGame.h"
+#include "../Savegame/BattleUnit.h"
+
+namespace OpenXcom
+{
+
+class SavedBattleGame;
+class Ruleset;
+class ResourcePack;
+class BattleItem;
+
+/**
+ * Plays a battle to the end with every side run by the AI and no screen,
+ * for measuring how fast the AI and the tile engine are.
+ * Actions happen at once instead of going through the animated battle states,
+ * and the time spent in the AI, pathfinding, field of view and explosions is added up.
+ */
+class BattleSimulator
+{
+private:
+	SavedBattleGame *_save;
+	Ruleset *_rules;
+	ResourcePack *_res;
+	GameDifficulty _difficulty;
+	std::vector<double> _turnTimes;
+	double _aiTime, _pathfindingTime, _fovTime, _explosionTime;
+	int _plans, _planHits, _planMisses;
+	/// Gets the AI of the side to move ready for its turn.
+	void prepareSide();
+	/// Lets the AI of a unit act until it is done for the turn.
+	void playUnit(BattleUnit *unit);
+	/// Carries out an action.
+	void execute(BattleAction &action);
+	/// Walks a unit along its path.
+	void walk(BattleAction &action);
+	/// Fires a weapon or throws an item.
+	void shoot(BattleAction &action);
+	/// Sets off an item's damage at a voxel.
+	void impact(const Position &voxel, BattleItem *item, BattleUnit *unit);
+	/// Sets off the terrain that is waiting to blow up.
+	void explodeTerrain();
+	/// Takes the units that went down off the map.
+	void checkForCasualties();
+	/// Checks if a faction has units left standing.
+	bool isAlive(UnitFaction faction) const;
+public:
+	/// Creates a simulator for a battle.
+	BattleSimulator(SavedBattleGame *save, Ruleset *rules, ResourcePack *res, GameDifficulty difficulty);
+	/// Cleans up the simulator.
+	~BattleSimulator();
+	/// Plays the battle until it is over or runs out of turns.
+	void run(int maxTurns);
+	/// Checks if one side has won.
+	bool isOver() const;
+	/// Gets how long each side's turn took, in seconds.
+	const std::vector<double> &getTurnTimes() const;
+	/// Gets the time spent in the AI deciding what to do.
+	double getAITime() const;
+	/// Gets the time spent finding paths.
+	double getPathfindingTime() const;
+	/// Gets the time spent working out what units see.
+	double getFOVTime() const;
+	/// Gets the time spent in explosions and hits.
+	double getExplosionTime() const;
+	/// Gets how many reachability maps were planned ahead, used and worked out again.
+	void getPlanCounts(int *plans, int *hits, int *misses) const;
+};
+
+}
+
+#endif
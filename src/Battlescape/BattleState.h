@@ -21,6 +21,7 @@
 
 #include <string>
 #include "BattlescapeGame.h"
+#include "../Engine/MemoryPool.h"
 
 namespace OpenXcom
 {
@@ -42,6 +43,10 @@ public:
 	BattleState(BattlescapeGame *parent);
 	/// Cleans up the BattleState.
 	virtual ~BattleState();
+	/// Gets the memory for a battle state from the pool.
+	static void *operator new(size_t size) { return MemoryPool::allocate(size); }
+	/// Gives the memory of a battle state back to the pool.
+	static void operator delete(void *p, size_t size) { MemoryPool::deallocate(p, size); }
 	/// Initializes the state.
 	virtual void init();
 	/// Handles a cancels request.
@@ -58,6 +58,7 @@
 #include "../Interface/ImageButton.h"
 #include "../Interface/NumberText.h"
 #include "../Savegame/SavedGame.h"
+#include "../Savegame/SaveWriter.h"
 #include "../Savegame/SavedBattleGame.h"
 #include "../Savegame/Tile.h"
 #include "../Savegame/BattleUnit.h"
@@ -93,6 +94,7 @@ BattlescapeGame::BattlescapeGame(SavedBattleGame *save, BattlescapeState *parent
 	_debugPlay = false;
 	_playerPanicHandled = true;
 	_AIActionCounter = 0;
+	_AIThinking = false;
 	_currentAction.actor = 0;
 
 	checkForCasualties(0, 0, true);
@@ -184,16 +186,22 @@ void BattlescapeGame::handleAI(BattleUnit *unit)
 		unit->setAIState(new PatrolBAIState(_save, unit, 0));
 		ai = unit->getCurrentAIState();
 	}
-	_AIActionCounter++;
-	if (_AIActionCounter == 1 && _playedAggroSound)
+	// an action the unit is still thinking about from the last frame doesn't count as a new one
+	if (!_AIThinking)
 	{
-		_playedAggroSound = false;
-	}
-	if(_AIActionCounter == 1)
-	{
-		unit->_hidingForTurn = 0;
-		unit->_desperatelySeekingCover = 0;
-		if (Options::getBool("traceAI")) { Log(LOG_INFO) << "#" << unit->getId() << "--" << unit->getType(); }
+		_AIActionCounter++;
+		if (_AIActionCounter == 1 && _playedAggroSound)
+		{
+			_playedAggroSound = false;
+		}
+		if(_AIActionCounter == 1)
+		{
+			unit->_hidingForTurn = 0;
+			unit->_desperatelySeekingCover = 0;
+			if (Options::getBool("traceAI")) { Log(LOG_INFO) << "#" << unit->getId() << "--" << unit->getType(); }
+		}
+		// the last action may have moved units into or out of the other side's lines of fire
+		getTileEngine()->updateThreatSurvey(unit->getFaction(), false);
 	}
 	AggroBAIState *aggro = dynamic_cast<AggroBAIState*>(ai); // this cast only works when ai was already AggroBAIState at heart
 	
@@ -216,6 +224,13 @@ void BattlescapeGame::handleAI(BattleUnit *unit)
 	action.diff = _parentState->getGame()->getSavedGame()->getDifficulty();
     action.number = _AIActionCounter;
 	unit->think(&action);
+
+	// the AI ran out of time for this frame, let the screen update and carry on next frame
+	_AIThinking = action.type == BA_THINK;
+	if (_AIThinking)
+	{
+		return;
+	}
 	
 	if (action.type == BA_RETHINK)
 	{
@@ -407,6 +422,10 @@ void BattlescapeGame::endTurn()
 
 	if (liveAliens > 0 && liveSoldiers > 0)
 	{
+		if (_save->getSide() == FACTION_PLAYER && Options::getBool("autosave"))
+		{
+			_parentState->getGame()->getSaveWriter()->save(_parentState->getGame()->getSavedGame(), "autosave_battlescape", true);
+		}
 		showInfoBoxQueue();
 
 		_parentState->updateSoldierInfo();
@@ -1481,19 +1500,20 @@ const Ruleset *BattlescapeGame::getRuleset() const
  */
 void BattlescapeGame::resetSituationForAI()
 {
-    int w = _save->getMapSizeX();
-    int h = _save->getMapSizeZ();
-    int l = _save->getMapSizeY();
-
-    Tile **tiles = _save->getTiles();
-
-    // Log(LOG_INFO) << w*h*l << " tiles!";
+    // only the soldiers that moved since last turn get their lines of fire traced again
+    getTileEngine()->updateThreatSurvey(_save->getSide(), true);
 
-    for (int i = 0; i < w * l * h; ++i)
+    // work out where the aliens can walk to on the battle threads, before they start thinking one by one;
+    // only aggro units ask for it, and a plan is only worked out again if an earlier move gets in its way
+    std::vector<BattleUnit*> aliens;
+    for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
     {
-       tiles[i]->soldiersVisible = -1;    // -1 for "not calculated"; actual calculations will take place as needed
-       tiles[i]->closestSoldierDSqr = -1; // for most of the tiles most of the time, this data is not needed
+       if ((*i)->getFaction() == FACTION_HOSTILE && !(*i)->isOut() && dynamic_cast<AggroBAIState*>((*i)->getCurrentAIState()))
+       {
+          aliens.push_back(*i);
+       }
     }
+    _save->getPathfinding()->planReachability(aliens, Pathfinding::UNLIMITED_TU);
 }
 
 
@@ -40,7 +40,7 @@ class Pathfinding;
 class Ruleset;
 class InfoboxOKState;
 
-enum BattleActionType { BA_NONE, BA_TURN, BA_WALK, BA_PRIME, BA_THROW, BA_AUTOSHOT, BA_SNAPSHOT, BA_AIMEDSHOT, BA_STUN, BA_HIT, BA_USE, BA_LAUNCH, BA_MINDCONTROL, BA_PANIC, BA_RETHINK };
+enum BattleActionType { BA_NONE, BA_TURN, BA_WALK, BA_PRIME, BA_THROW, BA_AUTOSHOT, BA_SNAPSHOT, BA_AIMEDSHOT, BA_STUN, BA_HIT, BA_USE, BA_LAUNCH, BA_MINDCONTROL, BA_PANIC, BA_RETHINK, BA_THINK };
 
 struct BattleAction
 {
@@ -75,6 +75,7 @@ private:
 	BattleActionType _tuReserved;
 	bool _playerPanicHandled;
 	int _AIActionCounter;
+	bool _AIThinking;
 	BattleAction _currentAction;
 
 	void selectNextPlayerUnit(bool checkReselect);
@@ -20,6 +20,8 @@
 #include <sstream>
 #include "BattlescapeGenerator.h"
 #include "TileEngine.h"
+#include "Pathfinding.h"
+#include "ThreatMap.h"
 #include "../Savegame/SavedGame.h"
 #include "../Savegame/SavedBattleGame.h"
 #include "../Savegame/Tile.h"
@@ -193,6 +195,10 @@ void BattlescapeGenerator::nextStage()
 
 	_save->initMap(_mapsize_x, _mapsize_y, _mapsize_z);
 	generateMap();
+	_save->getTileEngine()->invalidateFOVCache();
+	_save->getTileEngine()->invalidateLighting();
+	_save->getPathfinding()->invalidateMoveCosts();
+	_save->getTileEngine()->invalidateThreatMaps();
 
 	for (std::vector<BattleUnit*>::iterator j = _save->getUnits()->begin(); j != _save->getUnits()->end(); ++j)
 	{
@@ -202,7 +208,6 @@ void BattlescapeGenerator::nextStage()
 			if (node)
 			{
 				_save->setUnitPosition((*j), node->getPosition());
-				(*j)->getVisibleTiles()->clear();
 			}
 		}
 	}
@@ -214,9 +219,10 @@ void BattlescapeGenerator::nextStage()
 	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
 	{
 		if (_save->getTiles()[i]->getMapData(MapData::O_FLOOR) && _save->getTiles()[i]->getMapData(MapData::O_FLOOR)->getSpecialType() == START_POINT)
-			_save->getTiles()[i]->setDiscovered(true, 2);
+			_save->setTileDiscovered(_save->getTiles()[i], true, 2);
 	}
 	_save->setGlobalShade(_worldShade);
+	_save->getTileEngine()->calculateVoxelShapes();
 	_save->getTileEngine()->calculateSunShading();
 	_save->getTileEngine()->calculateTerrainLighting();
 	_save->getTileEngine()->calculateUnitLighting();
@@ -455,7 +461,7 @@ void BattlescapeGenerator::run()
 	{
 		for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
 		{
-			_save->getTiles()[i]->setDiscovered(true, 2);
+			_save->setTileDiscovered(_save->getTiles()[i], true, 2);
 		}
 	}
 
@@ -468,7 +474,7 @@ void BattlescapeGenerator::run()
 				(_save->getTiles()[i]->getPosition().z == 1 &&
 				_save->getTiles()[i]->getMapData(MapData::O_FLOOR)->isGravLift() &&
 				_save->getTiles()[i]->getMapData(MapData::O_OBJECT))))
-				_save->getTiles()[i]->setDiscovered(true, 2);
+				_save->setTileDiscovered(_save->getTiles()[i], true, 2);
 		}
 	}
 
@@ -476,6 +482,7 @@ void BattlescapeGenerator::run()
 	// set shade (alien bases are a little darker, sites depend on worldshade)
 	_save->setGlobalShade(_worldShade);
 
+	_save->getTileEngine()->calculateVoxelShapes();
 	_save->getTileEngine()->calculateSunShading();
 	_save->getTileEngine()->calculateTerrainLighting();
 	_save->getTileEngine()->calculateUnitLighting();
@@ -1524,7 +1531,7 @@ int BattlescapeGenerator::loadMAP(MapBlock *mapblock, int xoff, int yoff, RuleTe
 				_save->getTile(Position(x, y, z))->setMapData(0, -1, -1, part);
 			}
 		}
-		_save->getTile(Position(x, y, z))->setDiscovered(discovered, 2);
+		_save->setTileDiscovered(_save->getTile(Position(x, y, z)), discovered, 2);
 
 		x++;
 
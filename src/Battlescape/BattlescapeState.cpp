@@ -57,6 +57,8 @@
 #include "../Interface/ImageButton.h"
 #include "../Interface/NumberText.h"
 #include "../Savegame/SavedGame.h"
+#include "../Savegame/SaveWriter.h"
+#include "../Menu/ErrorMessageState.h"
 #include "../Savegame/SavedBattleGame.h"
 #include "../Savegame/Tile.h"
 #include "../Savegame/BattleUnit.h"
@@ -390,6 +392,14 @@ void BattlescapeState::think()
 {
 	static bool popped = false;
 
+	std::string error;
+	if (_game->getSaveWriter()->update(&error))
+	{
+		std::wstringstream message;
+		message << _game->getLanguage()->getString("STR_SAVE_UNSUCCESSFUL") << L'\x02' << Language::utf8ToWstr(error);
+		_popups.push_back(new ErrorMessageState(_game, message.str(), Palette::blockOffset(0), "TAC00.SCR", -1));
+	}
+
 	if (_gameTimer->isRunning())
 	{
 		if (_popups.empty())
@@ -1255,9 +1265,9 @@ void BattlescapeState::SaveVoxelView()
 			{
 				tile = _save->getTile(Position(_trajectory.at(0).x/16, _trajectory.at(0).y/16, _trajectory.at(0).z/24));
 				if (_debug
-					|| (tile->isDiscovered(0) && test == 2)
-					|| (tile->isDiscovered(1) && test == 3)
-					|| (tile->isDiscovered(2) && (test == 1 || test == 4))
+					|| (_save->isTileDiscovered(tile->getPosition(), 0) && test == 2)
+					|| (_save->isTileDiscovered(tile->getPosition(), 1) && test == 3)
+					|| (_save->isTileDiscovered(tile->getPosition(), 2) && (test == 1 || test == 4))
 					|| test==5
 					)
 				{
@@ -21,6 +21,7 @@
 
 #include <vector>
 #include "Position.h"
+#include "../Engine/MemoryPool.h"
 
 namespace OpenXcom
 {
@@ -47,6 +48,10 @@ public:
 	Explosion(Position _position, int startFrame, bool big, bool hit = false);
 	/// Cleans up the Explosion.
 	~Explosion();
+	/// Gets the memory for an explosion from the pool.
+	static void *operator new(size_t size) { return MemoryPool::allocate(size); }
+	/// Gives the memory of an explosion back to the pool.
+	static void operator delete(void *p, size_t size) { MemoryPool::deallocate(p, size); }
 	/// Move the Explosion one frame.
 	bool animate();
 	/// Get the current position in voxel space.
@@ -35,6 +35,7 @@
 #include "../Ruleset/RuleItem.h"
 #include "../Ruleset/Armor.h"
 #include "../Engine/RNG.h"
+#include "../Engine/Options.h"
 
 namespace OpenXcom
 {
@@ -70,14 +71,7 @@ void ExplosionBState::init()
 	if (_item)
 	{
 		_power = _item->getRules()->getPower();
-		// heavy explosions, incendiary, smoke or stun bombs create AOE explosions
-		// all the rest hits one point:
-		// AP, melee (stun or AP), laser, plasma, acid
-		_areaOfEffect = _item->getRules()->getBattleType() != BT_MELEE && 
-						(_item->getRules()->getDamageType() == DT_HE 
-						|| _item->getRules()->getDamageType() == DT_IN 
-						|| _item->getRules()->getDamageType() == DT_SMOKE
-						|| _item->getRules()->getDamageType() == DT_STUN);
+		_areaOfEffect = isAreaOfEffect(_item->getRules());
 	}
 	else if (_tile && _tile->getExplosive())
 	{
@@ -109,7 +103,7 @@ void ExplosionBState::init()
 			_parent->getResourcePack()->getSound("BATTLE.CAT", 12)->play();
 		else
 			_parent->getResourcePack()->getSound("BATTLE.CAT", 5)->play();
-		if (t->isDiscovered(0))
+		if (_parent->getSave()->isTileDiscovered(t->getPosition(), 0))
 			_parent->getMap()->getCamera()->centerOnPosition(t->getPosition());
 	}
 	else
@@ -157,35 +151,16 @@ void ExplosionBState::cancel()
 
 void ExplosionBState::explode()
 {
-	bool terrainExplosion = false;
+	// explosion not caused by terrain or an item, must be by a unit (cyberdisc)
+	bool terrainExplosion = !_tile && !_item;
 	SavedBattleGame *save = _parent->getSave();
 	// after the animation is done, the real explosion/hit takes place
-	if (_item)
-	{
-		if (_areaOfEffect)
-		{
-			save->getTileEngine()->explode(_center, _power, _item->getRules()->getDamageType(), _item->getRules()->getExplosionRadius(), _unit);
-		}
-		else
-		{
-			BattleUnit *victim = save->getTileEngine()->hit(_center, _power, _item->getRules()->getDamageType(), _unit);
-			// check if this unit turns others into zombies
-			if (!_unit->getZombieUnit().empty() && victim && victim->getArmor()->getSize() == 1)
-			{
-				// converts the victim to a zombie
-				_parent->convertUnit(victim, _unit->getZombieUnit());
-			}
-		}
-	}
-	if (_tile)
+	BattleUnit *victim = detonate(save->getTileEngine(), _center, _power, _item, _unit, _tile);
+	// check if this unit turns others into zombies
+	if (victim && !_unit->getZombieUnit().empty() && victim->getArmor()->getSize() == 1)
 	{
-		save->getTileEngine()->explode(_center, _power, DT_HE, _power/10);
-	}
-	if (!_tile && !_item)
-	{
-		// explosion not caused by terrain or an item, must be by a unit (cyberdisc)
-		save->getTileEngine()->explode(_center, _power, DT_HE, 6);
-		terrainExplosion = true;
+		// converts the victim to a zombie
+		_parent->convertUnit(victim, _unit->getZombieUnit());
 	}
 
 	// now check for new casualties
@@ -209,4 +184,64 @@ void ExplosionBState::explode()
 
 }
 
+/**
+ * Checks if an item's damage spreads over an area: heavy explosions, incendiary,
+ * smoke or stun bombs create AOE explosions, all the rest hits one point:
+ * AP, melee (stun or AP), laser, plasma, acid.
+ * @param rules The rules of the item doing the damage.
+ * @return True for an explosion.
+ */
+bool ExplosionBState::isAreaOfEffect(RuleItem *rules)
+{
+	return rules->getBattleType() != BT_MELEE &&
+			(rules->getDamageType() == DT_HE
+			|| rules->getDamageType() == DT_IN
+			|| rules->getDamageType() == DT_SMOKE
+			|| rules->getDamageType() == DT_STUN);
+}
+
+/**
+ * Does the damage of an explosion or a hit once its animation is over.
+ * The battle simulator calls this straight away, so both go by the same rules.
+ * @param engine Pointer to the tile engine.
+ * @param center Center position in voxelspace.
+ * @param power Power of the explosion.
+ * @param item Item involved in the explosion, 0 for none.
+ * @param unit Unit involved in the explosion.
+ * @param tile Tile blowing up, 0 for none.
+ * @return The unit that was hit, if the item hits one point.
+ */
+BattleUnit *ExplosionBState::detonate(TileEngine *engine, const Position &center, int power, BattleItem *item, BattleUnit *unit, Tile *tile)
+{
+	BattleUnit *victim = 0;
+	if (item)
+	{
+		if (isAreaOfEffect(item->getRules()))
+		{
+			engine->explode(center, power, item->getRules()->getDamageType(), item->getRules()->getExplosionRadius(), unit);
+		}
+		else
+		{
+			victim = engine->hit(center, power, item->getRules()->getDamageType(), unit);
+		}
+	}
+	if (tile)
+	{
+		if (Options::getBool("battleExplosionFloodFill"))
+		{
+			// all the terrain waiting to blow up goes off together
+			engine->explodeTerrain();
+		}
+		else
+		{
+			engine->explode(center, power, DT_HE, power/10);
+		}
+	}
+	if (!tile && !item)
+	{
+		engine->explode(center, power, DT_HE, 6);
+	}
+	return victim;
+}
+
 }
@@ -29,6 +29,8 @@ class BattlescapeGame;
 class BattleUnit;
 class BattleItem;
 class Tile;
+class TileEngine;
+class RuleItem;
 
 /* Explosion state not only handles explosions, but also bullet impacts! */
 /* Refactoring tip : ImpactBState */
@@ -56,6 +58,10 @@ public:
 	void think();
 	/// Get the result of the state.
 	std::string getResult() const;
+	/// Checks if an item's damage spreads over an area instead of hitting one point.
+	static bool isAreaOfEffect(RuleItem *rules);
+	/// Does the damage of an explosion or a hit, without the animation.
+	static BattleUnit *detonate(TileEngine *engine, const Position &center, int power, BattleItem *item, BattleUnit *unit, Tile *tile);
 
 };
 
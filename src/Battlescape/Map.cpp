@@ -155,7 +155,7 @@ void Map::draw()
 	if (_projectile)
 	{
 		t = _save->getTile(Position(_projectile->getPosition(0).x/16, _projectile->getPosition(0).y/16, _projectile->getPosition(0).z/24));
-		if (_save->getSide() == FACTION_PLAYER || (t && t->getVisible()))
+		if (_save->getSide() == FACTION_PLAYER || (t && _save->isTileVisible(FACTION_PLAYER, t->getPosition())))
 		{
 			projectileInFOV = true;
 		}
@@ -165,7 +165,7 @@ void Map::draw()
 	{
 		std::set<Explosion*>::iterator i = _explosions.begin();
 		t = _save->getTile(Position((*i)->getPosition().x/16, (*i)->getPosition().y/16, (*i)->getPosition().z/24));
-		if (t && (((*i)->isBig() && t->isDiscovered(0)) || t->getVisible()))
+		if (t && (((*i)->isBig() && _save->isTileDiscovered(t->getPosition(), 0)) || _save->isTileVisible(FACTION_PLAYER, t->getPosition())))
 		{
 			explosionInFOV = true;
 		}
@@ -350,7 +350,7 @@ void Map::drawTerrain(Surface *surface)
 
 					if (!tile) continue;
 
-					if (tile->isDiscovered(2))
+					if (_save->isTileDiscovered(mapPosition, 2))
 					{
 						tileShade = tile->getShade();
 					}
@@ -405,7 +405,7 @@ void Map::drawTerrain(Surface *surface)
 						if (tmpSurface)
 						{
 							if ((tile->getMapData(MapData::O_WESTWALL)->isDoor() || tile->getMapData(MapData::O_WESTWALL)->isUFODoor())
-								 && (tile->isDiscovered(0) || tile->isDiscovered(1)))
+								 && (_save->isTileDiscovered(mapPosition, 0) || _save->isTileDiscovered(mapPosition, 1)))
 								wallShade = 0;
 							else
 								wallShade = tileShade;
@@ -416,7 +416,7 @@ void Map::drawTerrain(Surface *surface)
 						if (tmpSurface)
 						{
 							if ((tile->getMapData(MapData::O_NORTHWALL)->isDoor() || tile->getMapData(MapData::O_NORTHWALL)->isUFODoor())
-								 && (tile->isDiscovered(0) || tile->isDiscovered(1)))
+								 && (_save->isTileDiscovered(mapPosition, 0) || _save->isTileDiscovered(mapPosition, 1)))
 								wallShade = 0;
 							else
 								wallShade = tileShade;
@@ -547,7 +547,7 @@ void Map::drawTerrain(Surface *surface)
 					{
 						BattleUnit *tunit = _save->selectUnit(Position(itX, itY, itZ-1));
 						Tile *ttile = _save->getTile(Position(itX, itY, itZ-1));
-						if (tunit && tunit->getVisible() && ttile->getTerrainLevel() < 0 && ttile->isDiscovered(2))
+						if (tunit && tunit->getVisible() && ttile->getTerrainLevel() < 0 && _save->isTileDiscovered(ttile->getPosition(), 2))
 						{
 							// the part is 0 for small units, large units have parts 1,2 & 3 depending on the relative x/y position of this tile vs the actual unit position.
 							int part = 0;
@@ -626,7 +626,7 @@ void Map::drawTerrain(Surface *surface)
 
 
 					// Draw smoke/fire
-					if (tile->getFire() && tile->isDiscovered(2))
+					if (tile->getFire() && _save->isTileDiscovered(mapPosition, 2))
 					{
 						frameNumber = 0; // see http://www.ufopaedia.org/images/c/cb/Smoke.gif
 						if ((_animFrame / 2) + tile->getAnimationOffset() > 3)
@@ -640,7 +640,7 @@ void Map::drawTerrain(Surface *surface)
 						tmpSurface = _res->getSurfaceSet("SMOKE.PCK")->getFrame(frameNumber);
 						tmpSurface->blitNShade(surface, screenPosition.x, screenPosition.y, 0);
 					}
-					if (tile->getSmoke() && tile->isDiscovered(2))
+					if (tile->getSmoke() && _save->isTileDiscovered(mapPosition, 2))
 					{
 						frameNumber = 8 + int(floor((tile->getSmoke() / 5.0) - 0.1)); // see http://www.ufopaedia.org/images/c/cb/Smoke.gif
 						if ((_animFrame / 2) + tile->getAnimationOffset() > 3)
@@ -89,7 +89,7 @@ void MiniMapView::draw()
 					continue;
 				}
 				int tileShade = 16;
-				if (t->isDiscovered(2))
+				if (_battleGame->isTileDiscovered(p, 2))
 				{
 					tileShade = t->getShade();
 				}
@@ -119,7 +119,7 @@ void MiniMapView::draw()
 					s->blitNShade(this, x, y, 0);
 				}
 				// perhaps (at least one) item on this tile?
-				if (t->isDiscovered(2) && !t->getInventory()->empty())
+				if (_battleGame->isTileDiscovered(p, 2) && !t->getInventory()->empty())
 				{
 					int frame = 9 + _frame;
 					Surface * s = _set->getFrame(frame);
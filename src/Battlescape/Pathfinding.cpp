@@ -17,27 +17,48 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <list>
+#include <algorithm>
+#include <fstream>
+#include <queue>
+#include <SDL.h>
 #include "Pathfinding.h"
 #include "PathfindingNode.h"
 #include "PathfindingOpenSet.h"
 #include "../Savegame/SavedBattleGame.h"
 #include "../Savegame/Tile.h"
+#include "../Savegame/TileArena.h"
 #include "../Ruleset/MapData.h"
 #include "../Ruleset/Armor.h"
 #include "../Savegame/BattleUnit.h"
+#include "TileEngine.h"
+#include "../Engine/ThreadPool.h"
 #include "../Engine/Options.h"
 #include "../Engine/Game.h"
+#include "../Engine/Logger.h"
 
 namespace OpenXcom
 {
 
+/**
+ * Gets what the pathfinding sees of a unit standing on a tile:
+ * its faction, whether it's visible, and whether it's out.
+ * @param unit Pointer to the unit.
+ * @return The state of the unit.
+ */
+int Pathfinding::getOccupantState(BattleUnit *unit)
+{
+	return unit->getFaction() | (unit->getVisible() << 2) | (unit->isOut() << 3);
+}
+
 /**
  * Sets up a Pathfinding.
  * @param save pointer to SavedBattleGame object.
  */
-Pathfinding::Pathfinding(SavedBattleGame *save) : _save(save), _nodes(), _unit(0), _pathPreviewed(false)
+Pathfinding::Pathfinding(SavedBattleGame *save) : _save(save), _nodes(), _terrainRevision(0), _occupants(getOccupantState), _mapRevision(0), _reachability(save), _planUnits(0), _planTUMax(0), _planHits(0), _planMisses(0), _ignoreUnits(false), _pathLog(0), _unit(0), _pathPreviewed(false)
 {
 	_size = _save->getMapSizeXYZ();
+	_clustersX = (_save->getMapSizeX() + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+	_clustersY = (_save->getMapSizeY() + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
 	// Initialize one node per tile
 	_nodes.reserve(_size);
 	Position p;
@@ -46,6 +67,7 @@ Pathfinding::Pathfinding(SavedBattleGame *save) : _save(save), _nodes(), _unit(0
 		_save->getTileCoords(i, &p.x, &p.y, &p.z);
 		_nodes.push_back(PathfindingNode(p));
 	}
+	_openSet.reserve(_size);
 }
 
 /**
@@ -54,7 +76,11 @@ Pathfinding::Pathfinding(SavedBattleGame *save) : _save(save), _nodes(), _unit(0
  */
 Pathfinding::~Pathfinding()
 {
-	// Nothing more to do here.
+	for (std::vector<Pathfinding*>::iterator i = _planners.begin(); i != _planners.end(); ++i)
+	{
+		delete *i;
+	}
+	delete _pathLog;
 }
 
 /**
@@ -144,6 +170,14 @@ void Pathfinding::calculate(BattleUnit *unit, Position endPosition, BattleUnit *
 		_path.clear(); // if bresenham failed, we shouldn't keep the path it was attempting, in case A* fails too.
 	}
 	// Now try through A*.
+	if (_pathLog)
+	{
+		recordPath(startPosition, endPosition, missileTarget, sneak);
+	}
+	if (Options::getBool("battleHierarchicalPaths") && missileTarget == 0 && !_strafeMove && hierarchicalPath(startPosition, endPosition, sneak))
+	{
+		return;
+	}
 	if (!aStarPath(startPosition, endPosition, missileTarget, sneak))
 	{
 		_path.clear();
@@ -163,11 +197,14 @@ bool Pathfinding::aStarPath(const Position &startPosition, const Position &endPo
 	// reset every node, so we have to check them all
 	for (std::vector<PathfindingNode>::iterator it = _nodes.begin(); it != _nodes.end(); ++it)
 		it->reset();
+	if (_corridor.empty()) // otherwise hierarchicalPath has just done it
+		prepareMoveCosts();
 
 	// start position is the first one in our "open" list
 	PathfindingNode *start = getNode(startPosition);
 	start->connect(0, 0, 0, endPosition);
-	PathfindingOpenSet openList;
+	PathfindingOpenSet &openList = _openSet;
+	openList.clear();
 	openList.push(start);
 
 	// if the open list is empty, we've reached the end
@@ -192,10 +229,12 @@ bool Pathfinding::aStarPath(const Position &startPosition, const Position &endPo
 		for (int direction = 0; direction < 10; direction++)
 		{
 			Position nextPos;
-			int tuCost = getTUCost(currentPos, direction, &nextPos, _unit, missileTarget);
+			int tuCost = getCachedTUCost(currentPos, direction, &nextPos, _unit, missileTarget);
 			if (tuCost >= 255) // Skip unreachable / blocked
 				continue;
-			if (sneak && _save->getTile(nextPos)->getVisible()) tuCost *= 5; // avoid being seen
+			if (sneak && _save->isTileVisible(FACTION_PLAYER, nextPos)) tuCost *= 5; // avoid being seen
+			if (!_corridor.empty() && !_corridor[getCluster(nextPos)]) // Keep to the clusters of a hierarchical path
+				continue;
 			PathfindingNode *nextNode = getNode(nextPos);
 			if (nextNode->isChecked()) // Our algorithm means this node is already at minimum cost.
 				continue;
@@ -254,7 +293,7 @@ int Pathfinding::getTUCost(const Position &startPosition, int direction, Positio
 				return 255;
 
 			// can't walk on top of other units
-			if (_save->getTile(*endPosition + Position(x,y,-1))
+			if (!_ignoreUnits && _save->getTile(*endPosition + Position(x,y,-1))
 				&& _save->getTile(*endPosition + Position(x,y,-1))->getUnit()
 				&& _save->getTile(*endPosition + Position(x,y,-1))->getUnit() != _unit
 				&& !_save->getTile(*endPosition + Position(x,y,-1))->getUnit()->isOut()
@@ -346,7 +385,7 @@ int Pathfinding::getTUCost(const Position &startPosition, int direction, Positio
 			}
 
 			// can't walk on top of other units
-			if (_save->getTile(*endPosition + Position(x,y,-1))
+			if (!_ignoreUnits && _save->getTile(*endPosition + Position(x,y,-1))
 				&& _save->getTile(*endPosition + Position(x,y,-1))->getUnit()
 				&& _save->getTile(*endPosition + Position(x,y,-1))->getUnit() != _unit
 				&& !_save->getTile(*endPosition + Position(x,y,-1))->getUnit()->isOut()
@@ -491,7 +530,7 @@ bool Pathfinding::isBlocked(Tile *tile, const int part, BattleUnit *missileTarge
 			return false;
 	}
 
-	if (part == MapData::O_FLOOR)
+	if (part == MapData::O_FLOOR && !_ignoreUnits)
 	{
 		BattleUnit *unit = tile->getUnit();
 		if (unit == 0 || unit == _unit || unit == missileTarget) return false;
@@ -589,7 +628,7 @@ bool Pathfinding::canFallDown(Tile *here)
 {
 	if (here->getPosition().z == 0)
 		return false;
-	for (int z = 1; z <= here->getPosition().z; ++z)
+	for (int z = 1; z <= here->getPosition().z && !_ignoreUnits; ++z)
 	{
 		if (_save->selectUnit(here->getPosition() - Position(0, 0, z)) &&
 			_save->selectUnit(here->getPosition() - Position(0, 0, z)) != _unit &&
@@ -823,7 +862,7 @@ bool Pathfinding::bresenhamPath(const Position& origin, const Position& target,
 			}
 			int tuCost = getTUCost(lastPoint, dir, &nextPoint, _unit, missileTarget);
 			
-			if (sneak && _save->getTile(nextPoint)->getVisible()) return false;
+			if (sneak && _save->isTileVisible(FACTION_PLAYER, nextPoint)) return false;
 			
 			// delete the following
 			if (nextPoint == realNextPoint && tuCost < 255 && (tuCost == lastTUCost || (dir&1 && tuCost == lastTUCost*1.5) || (!(dir&1) && tuCost*1.5 == lastTUCost) || lastTUCost == -1)
@@ -878,9 +917,11 @@ std::vector<int> Pathfinding::findReachable(BattleUnit *unit, int tuMax)
 	{
 		it->reset();
 	}
+	prepareMoveCosts();
 	PathfindingNode *startNode = getNode(start);
 	startNode->connect(0, 0, 0);
-	PathfindingOpenSet unvisited;
+	PathfindingOpenSet &unvisited = _openSet;
+	unvisited.clear();
 	unvisited.push(startNode);
 	std::vector<PathfindingNode*> reachable;
 	while (!unvisited.empty())
@@ -892,7 +933,7 @@ std::vector<int> Pathfinding::findReachable(BattleUnit *unit, int tuMax)
 		for (int direction = 0; direction < 10; direction++)
 		{
 			Position nextPos;
-			int tuCost = getTUCost(currentPos, direction, &nextPos, unit, 0);
+			int tuCost = getCachedTUCost(currentPos, direction, &nextPos, unit, 0);
 			if (tuCost == 255) // Skip unreachable / blocked
 				continue;
 			if (currentNode->getTUCost(false) + tuCost > tuMax) // Run out of TUs
@@ -921,6 +962,773 @@ std::vector<int> Pathfinding::findReachable(BattleUnit *unit, int tuMax)
 	return tiles;
 }
 
+/**
+ * Gets the cheapest TU cost from a unit to every tile it can reach. The map is kept
+ * and handed out again as long as the unit, where it stands, its TUs and the units it
+ * can see stay the same, and no terrain or unit changed near the tiles it reaches,
+ * and so are the maps planned ahead with planReachability. A unit with a planned map
+ * that went stale gets it worked out again in its place, and only then.
+ * Strafing is not taken into account.
+ * @param unit Pointer to the unit.
+ * @param tuMax The most TUs to spend.
+ * @return The reachability map, valid until the next call.
+ */
+const ReachabilityMap &Pathfinding::getReachabilityMap(BattleUnit *unit, int tuMax)
+{
+	prepareMoveCosts();
+	for (std::vector<ReachabilityMap>::iterator i = _plans.begin(); i != _plans.end(); ++i)
+	{
+		if (i->_unit != unit)
+			continue;
+		if (isCurrent(*i, unit, tuMax))
+		{
+			++_planHits;
+		}
+		else
+		{
+			++_planMisses;
+			buildReachabilityMap(unit, tuMax, *i);
+		}
+		return *i;
+	}
+
+	if (!isCurrent(_reachability, unit, tuMax))
+	{
+		buildReachabilityMap(unit, tuMax, _reachability);
+	}
+	return _reachability;
+}
+
+/**
+ * Checks if a reachability map was built for a unit as it is now, on the map as it is now.
+ * prepareMoveCosts must have been called since the terrain or the units last changed.
+ * @param map The reachability map.
+ * @param unit Pointer to the unit.
+ * @param tuMax The most TUs to spend.
+ * @return True if the map still holds.
+ */
+bool Pathfinding::isCurrent(const ReachabilityMap &map, BattleUnit *unit, int tuMax) const
+{
+	return map._unit == unit && map._origin == unit->getPosition() && map._tuMax == tuMax
+		&& map._movementType == unit->getArmor()->getMovementType() && map._mapRevision == _mapRevision
+		&& map._visibleUnits == *unit->getVisibleUnits();
+}
+
+/**
+ * Checks if a reachability map can depend on a tile that changed. The cost of every
+ * tile on the map only comes from the steps out of the tiles the unit reaches, so it
+ * can only change if one of those steps looks at the tile: for terrain, the steps
+ * forgetMoveCosts drops, for a unit, the steps prepareMoveCosts works out in full.
+ * @param map The reachability map.
+ * @param index Index of the tile that changed.
+ * @param unit True if a unit came, left or changed on the tile, false if the terrain changed.
+ * @return True if the map may not hold anymore.
+ */
+bool Pathfinding::dependsOn(const ReachabilityMap &map, int index, bool unit) const
+{
+	if ((int)map._cost.size() != _size)
+		return true;
+	Position pos = _save->getTiles()[index]->getPosition();
+	int s = map._unit->getArmor()->getSize() - 1;
+	int minX = std::max(0, pos.x - (unit ? 2 : s + 1)), maxX = std::min(_save->getMapSizeX() - 1, pos.x + 1);
+	int minY = std::max(0, pos.y - (unit ? 2 : s + 1)), maxY = std::min(_save->getMapSizeY() - 1, pos.y + 1);
+	int minZ = std::max(0, pos.z - 2), maxZ = unit ? _save->getMapSizeZ() - 1 : std::min(_save->getMapSizeZ() - 1, pos.z + 3);
+	for (int z = minZ; z <= maxZ; ++z)
+		for (int y = minY; y <= maxY; ++y)
+			for (int x = minX; x <= maxX; ++x)
+			{
+				if (map._cost[_save->getTileIndex(Position(x, y, z))] != -1)
+					return true;
+			}
+	return false;
+}
+
+/**
+ * Carries the reachability maps that hold at the current map revision over to the next
+ * one, unless one of the tiles that changed is near the tiles they reach, so one unit
+ * moving doesn't throw away the maps of the units that can't be affected by it.
+ * @param terrain Indexes of the tiles whose terrain changed.
+ * @param units Indexes of the tiles where a unit came, left or changed.
+ */
+void Pathfinding::keepReachabilityMaps(const std::vector<int> &terrain, const std::vector<int> &units)
+{
+	std::vector<ReachabilityMap*> maps;
+	maps.push_back(&_reachability);
+	for (std::vector<ReachabilityMap>::iterator i = _plans.begin(); i != _plans.end(); ++i)
+	{
+		maps.push_back(&*i);
+	}
+	for (std::vector<ReachabilityMap*>::iterator i = maps.begin(); i != maps.end(); ++i)
+	{
+		ReachabilityMap *map = *i;
+		if (map->_unit == 0 || map->_mapRevision != _mapRevision)
+			continue;
+		bool stale = false;
+		for (std::vector<int>::const_iterator j = terrain.begin(); j != terrain.end() && !stale; ++j)
+		{
+			stale = dependsOn(*map, *j, false);
+		}
+		for (std::vector<int>::const_iterator j = units.begin(); j != units.end() && !stale; ++j)
+		{
+			stale = dependsOn(*map, *j, true);
+		}
+		if (!stale)
+		{
+			map->_mapRevision = _mapRevision + 1;
+		}
+	}
+}
+
+/**
+ * Works out the cheapest TU cost from a unit to every tile it can reach.
+ * @param unit Pointer to the unit.
+ * @param tuMax The most TUs to spend.
+ * @param map The reachability map to fill in.
+ */
+void Pathfinding::buildReachabilityMap(BattleUnit *unit, int tuMax, ReachabilityMap &map)
+{
+	bool strafeMove = _strafeMove;
+	_strafeMove = false;
+	_movementType = unit->getArmor()->getMovementType();
+	map._tiles = findReachable(unit, tuMax);
+	_strafeMove = strafeMove;
+
+	map._cost.assign(_size, -1);
+	map._prevTile.assign(_size, -1);
+	map._prevDir.assign(_size, -1);
+	for (std::vector<int>::const_iterator i = map._tiles.begin(); i != map._tiles.end(); ++i)
+	{
+		PathfindingNode *node = &_nodes[*i];
+		map._cost[*i] = node->getTUCost(false);
+		if (node->getPrevNode())
+		{
+			map._prevTile[*i] = _save->getTileIndex(node->getPrevNode()->getPosition());
+			map._prevDir[*i] = node->getPrevDir();
+		}
+	}
+	map._unit = unit;
+	map._origin = unit->getPosition();
+	map._tuMax = tuMax;
+	map._movementType = _movementType;
+	map._mapRevision = _mapRevision;
+	map._visibleUnits = *unit->getVisibleUnits();
+}
+
+/**
+ * Works out the reachability maps of a number of units on the battle threads, each with
+ * a pathfinding of its own, so getReachabilityMap can hand them out later without waiting.
+ * A planned map is only handed out while the unit and the units it sees are the same
+ * as when it was planned and nothing changed near the tiles it reaches; after that
+ * it's worked out again when asked for, for that unit alone. Planning doesn't use random
+ * numbers or change anything but the plans, so it doesn't change what happens in the battle.
+ * @param units The units to plan for.
+ * @param tuMax The most TUs to spend.
+ */
+void Pathfinding::planReachability(const std::vector<BattleUnit*> &units, int tuMax)
+{
+	if (Options::getBool("traceAI") && !_plans.empty())
+	{
+		Log(LOG_INFO) << "Reachability plans: " << _plans.size() << " planned, " << _planHits << " used, " << _planMisses << " worked out again";
+	}
+	_planHits = 0;
+	_planMisses = 0;
+	prepareMoveCosts();
+	ThreadPool *pool = _save->getTileEngine()->getThreadPool();
+	while (_planners.size() < (size_t)pool->getThreads())
+	{
+		_planners.push_back(new Pathfinding(_save));
+	}
+	_plans.resize(units.size(), ReachabilityMap(_save));
+	_planUnits = &units;
+	_planTUMax = tuMax;
+	pool->run(planJob, this, units.size());
+	_planUnits = 0;
+
+	// the planners keep count of map changes their own way
+	for (std::vector<ReachabilityMap>::iterator i = _plans.begin(); i != _plans.end(); ++i)
+	{
+		i->_mapRevision = _mapRevision;
+	}
+}
+
+/**
+ * Works out the reachability map of one unit of a plan.
+ * @param pathfinding Pointer to the pathfinding.
+ * @param index Index of the unit in the plan.
+ * @param thread Number of the thread running the job, which picks the pathfinding to use.
+ */
+void Pathfinding::planJob(void *pathfinding, int index, int thread)
+{
+	Pathfinding *self = (Pathfinding*)pathfinding;
+	self->_planners[thread]->buildReachabilityMap(self->_planUnits->at(index), self->_planTUMax, self->_plans[index]);
+}
+
+/**
+ * Starts recording every A* request of this battle to a log, so they can be replayed
+ * on the same save with openxcom-battlesim. The log starts with the battle's turn
+ * and the name of the save, so it's only replayed on the battle it was recorded on.
+ * @param filename The file to record to. Anything in it is overwritten.
+ * @param save Name of the save the battle was loaded from.
+ */
+void Pathfinding::recordPaths(const std::string &filename, const std::string &save)
+{
+	delete _pathLog;
+	_pathLog = new std::ofstream(filename.c_str());
+	*_pathLog << _save->getTurn() << " " << save << std::endl;
+}
+
+/**
+ * Appends an A* request to the recorded paths.
+ * @param startPosition The position the unit starts from.
+ * @param endPosition The position it wants to reach.
+ * @param missileTarget The target of a guided missile, if any.
+ * @param sneak Whether the path should avoid being seen.
+ */
+void Pathfinding::recordPath(const Position &startPosition, const Position &endPosition, BattleUnit *missileTarget, bool sneak)
+{
+	*_pathLog << _unit->getId() << " "
+		<< startPosition.x << " " << startPosition.y << " " << startPosition.z << " "
+		<< endPosition.x << " " << endPosition.y << " " << endPosition.z << " "
+		<< (missileTarget ? missileTarget->getId() : -1) << " " << sneak << "\n";
+}
+
+/**
+ * Runs recorded A* requests again on this battle, as a benchmark of the pathfinding.
+ * Requests for units that aren't in this battle are skipped.
+ * @param log The recorded requests, after the log's header.
+ * @param paths Gets the number of requests replayed.
+ * @param found Gets the number of them a path was found for.
+ * @return How long the requests took, in milliseconds.
+ */
+int Pathfinding::replayPaths(std::istream &log, int *paths, int *found)
+{
+	std::vector<PathRequest> requests;
+	int unitId, targetId;
+	PathRequest request;
+	while (log >> unitId >> request.start.x >> request.start.y >> request.start.z >> request.end.x >> request.end.y >> request.end.z >> targetId >> request.sneak)
+	{
+		request.unit = request.missileTarget = 0;
+		for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
+		{
+			if ((*i)->getId() == unitId)
+				request.unit = *i;
+			if ((*i)->getId() == targetId)
+				request.missileTarget = *i;
+		}
+		if (request.unit && _save->getTile(request.start) && _save->getTile(request.end))
+		{
+			requests.push_back(request);
+		}
+	}
+	*paths = requests.size();
+	*found = 0;
+
+	std::vector<int> path = _path;
+	BattleUnit *unit = _unit;
+	MovementType movementType = _movementType;
+	int totalTUCost = _totalTUCost;
+	bool hierarchical = Options::getBool("battleHierarchicalPaths");
+	bool strafeMove = _strafeMove;
+	_strafeMove = false;
+	Uint32 startTime = SDL_GetTicks();
+	for (std::vector<PathRequest>::iterator i = requests.begin(); i != requests.end(); ++i)
+	{
+		_unit = i->unit;
+		_movementType = i->missileTarget ? MT_FLY : _unit->getArmor()->getMovementType();
+		if ((hierarchical && i->missileTarget == 0 && hierarchicalPath(i->start, i->end, i->sneak))
+			|| aStarPath(i->start, i->end, i->missileTarget, i->sneak))
+		{
+			++*found;
+		}
+	}
+	Uint32 time = SDL_GetTicks() - startTime;
+	_path = path;
+	_unit = unit;
+	_movementType = movementType;
+	_totalTUCost = totalTUCost;
+	_strafeMove = strafeMove;
+	return time;
+}
+
+/**
+ * Gets ready to use the cached step costs for a search: drops the ones for tiles whose
+ * terrain changed since the last search, and marks the start tiles where a step can be
+ * affected by a unit, as standing there, under the destination or anywhere in the column
+ * a unit could fall down. Steps from those are always worked out in full.
+ * Also bumps the map revision if the terrain or the units changed, carrying the
+ * reachability maps that can't be affected by the tiles that changed over to it.
+ * The tiles are only gone through when the map's terrain revision says one changed,
+ * and the units through the arena's list of occupied tiles, so when nothing changed
+ * this costs next to nothing and can be called before every search.
+ */
+void Pathfinding::prepareMoveCosts()
+{
+	Tile **tiles = _save->getTiles();
+	TileArena *arena = _save->getTileArena();
+	bool reset = false;
+	std::vector<int> terrain, units;
+	if ((int)_terrainRevisions.size() != _size)
+	{
+		invalidateMoveCosts();
+		_terrainRevisions.resize(_size);
+		for (int i = 0; i < _size; ++i)
+		{
+			_terrainRevisions[i] = tiles[i]->getTerrainRevision();
+		}
+		_terrainRevision = arena->getTerrainRevision();
+		_occupants.clear();
+		reset = true;
+	}
+	else if (arena->getTerrainRevision() != _terrainRevision)
+	{
+		for (int i = 0; i < _size; ++i)
+		{
+			Tile *tile = tiles[i];
+			if (tile->getTerrainRevision() != _terrainRevisions[i])
+			{
+				_terrainRevisions[i] = tile->getTerrainRevision();
+				forgetMoveCosts(tile->getPosition());
+				markClustersDirty(tile->getPosition());
+				terrain.push_back(i);
+			}
+		}
+		_terrainRevision = arena->getTerrainRevision();
+	}
+
+	_occupants.update(arena, &units);
+
+	if (!units.empty() || _nearUnits.size() != _size)
+	{
+		_nearUnits.resize(_size);
+		const std::vector<int> &occupied = arena->getOccupiedTiles();
+		for (std::vector<int>::const_iterator i = occupied.begin(); i != occupied.end(); ++i)
+		{
+			const Position &pos = tiles[*i]->getPosition();
+			for (int z = std::max(0, pos.z - 2); z < _save->getMapSizeZ(); ++z)
+				for (int y = std::max(0, pos.y - 2); y <= std::min(_save->getMapSizeY() - 1, pos.y + 1); ++y)
+					for (int x = std::max(0, pos.x - 2); x <= std::min(_save->getMapSizeX() - 1, pos.x + 1); ++x)
+					{
+						_nearUnits.set(_save->getTileIndex(Position(x, y, z)));
+					}
+		}
+	}
+	if (reset || !terrain.empty() || !units.empty())
+	{
+		if (!reset)
+		{
+			keepReachabilityMaps(terrain, units);
+		}
+		++_mapRevision;
+	}
+}
+
+/**
+ * Drops the cached step costs of every step that looks at a tile. A step reads the tiles
+ * of the unit's footprint at the start and end, their neighbours, and up to three levels
+ * below and two above the start.
+ * @param pos Position of the tile that changed.
+ */
+void Pathfinding::forgetMoveCosts(const Position &pos)
+{
+	for (int mt = 0; mt < 3; ++mt)
+		for (int s = 0; s < 2; ++s)
+		{
+			std::vector<MoveCost> &costs = _moveCosts[mt][s];
+			if (costs.empty())
+				continue;
+			for (int z = std::max(0, pos.z - 2); z <= std::min(_save->getMapSizeZ() - 1, pos.z + 3); ++z)
+				for (int y = std::max(0, pos.y - s - 1); y <= std::min(_save->getMapSizeY() - 1, pos.y + 1); ++y)
+					for (int x = std::max(0, pos.x - s - 1); x <= std::min(_save->getMapSizeX() - 1, pos.x + 1); ++x)
+					{
+						int index = _save->getTileIndex(Position(x, y, z)) * 10;
+						for (int direction = 0; direction < 10; ++direction)
+						{
+							costs[index + direction].cost = -1;
+						}
+					}
+		}
+}
+
+/**
+ * Drops all cached step costs, for when the map itself is replaced.
+ */
+void Pathfinding::invalidateMoveCosts()
+{
+	for (int mt = 0; mt < 3; ++mt)
+		for (int s = 0; s < 2; ++s)
+		{
+			_moveCosts[mt][s].clear();
+		}
+	for (int mt = 0; mt < 3; ++mt)
+	{
+		_clusters[mt].clear();
+	}
+	_terrainRevisions.clear();
+	_plans.clear();
+	for (std::vector<Pathfinding*>::iterator i = _planners.begin(); i != _planners.end(); ++i)
+	{
+		delete *i;
+	}
+	_planners.clear();
+}
+
+/**
+ * Gets the TU cost of one step like getTUCost, but remembers the result of steps
+ * that only depend on the terrain, per movement type and unit size.
+ * Steps near units, steps of guided missiles and strafing steps are not cached.
+ * prepareMoveCosts must have been called since the terrain or the units last changed.
+ * @param startPosition
+ * @param direction
+ * @param endPosition pointer
+ * @param unit
+ * @param missileTarget
+ * @return TU cost - 255 if movement impossible
+ */
+int Pathfinding::getCachedTUCost(const Position &startPosition, const int direction, Position *endPosition, BattleUnit *unit, BattleUnit *missileTarget)
+{
+	if (unit == 0 || missileTarget || (_save->getStrafeSetting() && _strafeMove)
+		|| _movementType != unit->getArmor()->getMovementType() || unit->getArmor()->getSize() > 2)
+		return getTUCost(startPosition, direction, endPosition, unit, missileTarget);
+
+	int index = _save->getTileIndex(startPosition);
+	if (_nearUnits.get(index))
+		return getTUCost(startPosition, direction, endPosition, unit, missileTarget);
+
+	std::vector<MoveCost> &costs = _moveCosts[_movementType][unit->getArmor()->getSize() - 1];
+	if (costs.empty())
+	{
+		MoveCost unknown = { -1, 0, 0, 0 };
+		costs.resize(_size * 10, unknown);
+	}
+	MoveCost &step = costs[index * 10 + direction];
+	if (step.cost == -1)
+	{
+		step.cost = getTUCost(startPosition, direction, endPosition, unit, missileTarget);
+		step.dx = endPosition->x - startPosition.x;
+		step.dy = endPosition->y - startPosition.y;
+		step.dz = endPosition->z - startPosition.z;
+		return step.cost;
+	}
+	_unit = unit;
+	*endPosition = startPosition + Position(step.dx, step.dy, step.dz);
+	return step.cost;
+}
+
+/**
+ * Gets the cluster of the hierarchical pathfinding a position is in.
+ * Clusters cover all the levels of the map.
+ * @param pos Position on the map.
+ * @return Cluster index.
+ */
+int Pathfinding::getCluster(const Position &pos) const
+{
+	return (pos.y / CLUSTER_SIZE) * _clustersX + pos.x / CLUSTER_SIZE;
+}
+
+/**
+ * Marks the clusters whose entrances or inner costs can depend on a tile as needing
+ * an update. A step reads the tiles next to it, so this is the tile's own cluster and
+ * those of its neighbours.
+ * @param pos Position of the tile that changed.
+ */
+void Pathfinding::markClustersDirty(const Position &pos)
+{
+	for (int mt = 0; mt < 3; ++mt)
+	{
+		if (_clusters[mt].empty())
+			continue;
+		for (int y = std::max(0, pos.y - 1); y <= std::min(_save->getMapSizeY() - 1, pos.y + 1); ++y)
+			for (int x = std::max(0, pos.x - 1); x <= std::min(_save->getMapSizeX() - 1, pos.x + 1); ++x)
+			{
+				_clusters[mt][getCluster(Position(x, y, 0))].dirty = true;
+			}
+	}
+}
+
+/**
+ * Brings the clusters of the current movement type up to date: finds the entrances
+ * on all the borders of the clusters that changed, then works out the costs between
+ * the portals of those clusters and of their neighbours, whose entrances may have moved.
+ * The first call for a movement type builds all of them.
+ * Units are ignored, they are taken into account when the path is refined.
+ * @return The clusters.
+ */
+std::vector<Pathfinding::Cluster> &Pathfinding::updateClusters()
+{
+	std::vector<Cluster> &clusters = _clusters[_movementType];
+	if (clusters.empty())
+	{
+		clusters.resize(_clustersX * _clustersY);
+	}
+	std::vector<bool> relink(clusters.size(), false);
+	bool changed = false;
+	for (int c = 0; c != (int)clusters.size(); ++c)
+	{
+		if (!clusters[c].dirty)
+			continue;
+		int cx = c % _clustersX, cy = c / _clustersX;
+		relink[c] = true;
+		if (cx + 1 < _clustersX)
+		{
+			findEntrances(c, 1);
+			relink[c + 1] = true;
+		}
+		if (cy + 1 < _clustersY)
+		{
+			findEntrances(c, 2);
+			relink[c + _clustersX] = true;
+		}
+		if (cx > 0)
+		{
+			findEntrances(c - 1, 1);
+			relink[c - 1] = true;
+		}
+		if (cy > 0)
+		{
+			findEntrances(c - _clustersX, 2);
+			relink[c - _clustersX] = true;
+		}
+		clusters[c].dirty = false;
+		changed = true;
+	}
+	if (changed)
+	{
+		for (int c = 0; c != (int)clusters.size(); ++c)
+		{
+			if (relink[c])
+			{
+				linkCluster(c);
+			}
+		}
+	}
+	return clusters;
+}
+
+/**
+ * Finds the entrances on the border between a cluster and the next one to the east or
+ * to the south. Each run of tiles along the border that can be crossed both ways, and
+ * walked along on both sides, gets one entrance in its middle, on each level.
+ * @param cluster Index of the cluster to the west or north of the border.
+ * @param side 1 for the east border, 2 for the south border.
+ */
+void Pathfinding::findEntrances(int cluster, int side)
+{
+	std::vector<Cluster> &clusters = _clusters[_movementType];
+	int other = (side == 1) ? cluster + 1 : cluster + _clustersX;
+	int cx = cluster % _clustersX, cy = cluster / _clustersX;
+	int direction = (side == 1) ? 2 : 4, alongDirection = (side == 1) ? 4 : 2;
+	Position along = (side == 1) ? Position(0, 1, 0) : Position(1, 0, 0);
+	Position across = (side == 1) ? Position(1, 0, 0) : Position(0, 1, 0);
+	Position first = (side == 1) ? Position(cx * CLUSTER_SIZE + CLUSTER_SIZE - 1, cy * CLUSTER_SIZE, 0) : Position(cx * CLUSTER_SIZE, cy * CLUSTER_SIZE + CLUSTER_SIZE - 1, 0);
+	int length = std::min((side == 1) ? _save->getMapSizeY() - first.y : _save->getMapSizeX() - first.x, (int)CLUSTER_SIZE);
+	clusters[cluster].sides[side].clear();
+	clusters[other].sides[(side + 2) % 4].clear();
+
+	for (int z = 0; z < _save->getMapSizeZ(); ++z)
+	{
+		int run = 0;
+		for (int i = 0; i <= length; ++i)
+		{
+			Position inside = first + along * i + Position(0, 0, z), end;
+			bool open = false, joined = false;
+			if (i < length)
+			{
+				open = getCachedTUCost(inside, direction, &end, _unit, 0) < 255 && end == inside + across
+					&& getCachedTUCost(inside + across, (direction + 4) % 8, &end, _unit, 0) < 255 && end == inside;
+				// a run is broken by anything that stops walking along the border on either side
+				joined = open && run && getCachedTUCost(inside - along, alongDirection, &end, _unit, 0) < 255 && end == inside
+					&& getCachedTUCost(inside - along + across, alongDirection, &end, _unit, 0) < 255 && end == inside + across;
+			}
+			if (run && !joined)
+			{
+				Position middle = first + along * (i - 1 - (run - 1) / 2) + Position(0, 0, z);
+				Entrance out, in;
+				out.inside = in.outside = _save->getTileIndex(middle);
+				out.outside = in.inside = _save->getTileIndex(middle + across);
+				out.cost = getCachedTUCost(middle, direction, &end, _unit, 0);
+				in.cost = getCachedTUCost(middle + across, (direction + 4) % 8, &end, _unit, 0);
+				clusters[cluster].sides[side].push_back(out);
+				clusters[other].sides[(side + 2) % 4].push_back(in);
+				run = 0;
+			}
+			if (open)
+			{
+				++run;
+			}
+		}
+	}
+}
+
+/**
+ * Works out the links of every portal of a cluster: the cost to the other portals
+ * without leaving the cluster, and the step across the border it is an entrance of.
+ * @param cluster Index of the cluster.
+ */
+void Pathfinding::linkCluster(int cluster)
+{
+	Cluster &c = _clusters[_movementType][cluster];
+	c.links.clear();
+	for (int side = 0; side < 4; ++side)
+	{
+		for (std::vector<Entrance>::const_iterator i = c.sides[side].begin(); i != c.sides[side].end(); ++i)
+		{
+			PortalLink link = { i->outside, i->cost };
+			c.links[i->inside].push_back(link);
+		}
+	}
+	for (std::map<int, std::vector<PortalLink> >::iterator i = c.links.begin(); i != c.links.end(); ++i)
+	{
+		exploreCluster(_nodes[i->first].getPosition(), cluster);
+		for (std::map<int, std::vector<PortalLink> >::const_iterator j = c.links.begin(); j != c.links.end(); ++j)
+		{
+			if (i != j && _nodes[j->first].isChecked())
+			{
+				PortalLink link = { j->first, _nodes[j->first].getTUCost(false) };
+				i->second.push_back(link);
+			}
+		}
+	}
+}
+
+/**
+ * Finds the cheapest cost from a tile to every tile of a cluster, with paths that stay
+ * in the cluster. Only the nodes of the cluster are reset; the ones reached are checked.
+ * @param startPosition The position to start from.
+ * @param cluster Index of the cluster it is in.
+ */
+void Pathfinding::exploreCluster(const Position &startPosition, int cluster)
+{
+	int minX = (cluster % _clustersX) * CLUSTER_SIZE, minY = (cluster / _clustersX) * CLUSTER_SIZE;
+	int maxX = std::min(minX + CLUSTER_SIZE, _save->getMapSizeX()) - 1, maxY = std::min(minY + CLUSTER_SIZE, _save->getMapSizeY()) - 1;
+	for (int z = 0; z < _save->getMapSizeZ(); ++z)
+		for (int y = minY; y <= maxY; ++y)
+			for (int x = minX; x <= maxX; ++x)
+			{
+				getNode(Position(x, y, z))->reset();
+			}
+
+	PathfindingNode *startNode = getNode(startPosition);
+	startNode->connect(0, 0, 0);
+	PathfindingOpenSet &unvisited = _openSet;
+	unvisited.clear();
+	unvisited.push(startNode);
+	while (!unvisited.empty())
+	{
+		PathfindingNode *currentNode = unvisited.pop();
+		Position const &currentPos = currentNode->getPosition();
+		currentNode->setChecked();
+		for (int direction = 0; direction < 10; direction++)
+		{
+			Position nextPos;
+			int tuCost = getCachedTUCost(currentPos, direction, &nextPos, _unit, 0);
+			if (tuCost == 255 || nextPos.x < minX || nextPos.x > maxX || nextPos.y < minY || nextPos.y > maxY)
+				continue;
+			PathfindingNode *nextNode = getNode(nextPos);
+			if (nextNode->isChecked())
+				continue;
+			int totalTuCost = currentNode->getTUCost(false) + tuCost;
+			if (!nextNode->inOpenSet() || nextNode->getTUCost(false) > totalTuCost)
+			{
+				nextNode->connect(totalTuCost, currentNode, direction);
+				unvisited.push(nextNode);
+			}
+		}
+	}
+}
+
+/**
+ * Finds a path by first searching the graph of cluster portals, then running A* only
+ * through the clusters that path goes through, so the search doesn't spread over the
+ * rest of the map. Only used for units of one tile, between different clusters.
+ * The unit information and movement type must have already been set.
+ * @param startPosition The position to start from.
+ * @param endPosition The position we want to reach.
+ * @param sneak Whether to avoid tiles the player can see.
+ * @return True if a path was found. If not, the caller should fall back to aStarPath,
+ * as the portal graph only has two way entrances and ignores units.
+ */
+bool Pathfinding::hierarchicalPath(const Position &startPosition, const Position &endPosition, bool sneak)
+{
+	int startCluster = getCluster(startPosition), endCluster = getCluster(endPosition);
+	if (_unit->getArmor()->getSize() > 1 || startCluster == endCluster || !_save->getTile(endPosition))
+		return false;
+
+	prepareMoveCosts();
+	_ignoreUnits = true;
+	std::vector<Cluster> &clusters = updateClusters();
+	// link the start and the end to the portals of their clusters
+	int startIndex = _save->getTileIndex(startPosition), endIndex = _save->getTileIndex(endPosition);
+	std::map<int, std::vector<PortalLink> > extraLinks;
+	exploreCluster(startPosition, startCluster);
+	for (std::map<int, std::vector<PortalLink> >::const_iterator i = clusters[startCluster].links.begin(); i != clusters[startCluster].links.end(); ++i)
+	{
+		if (_nodes[i->first].isChecked())
+		{
+			PortalLink link = { i->first, _nodes[i->first].getTUCost(false) };
+			extraLinks[startIndex].push_back(link);
+		}
+	}
+	// the way back from the end to the portals of its cluster stands in for the way there,
+	// one search instead of one per portal
+	exploreCluster(endPosition, endCluster);
+	for (std::map<int, std::vector<PortalLink> >::const_iterator i = clusters[endCluster].links.begin(); i != clusters[endCluster].links.end(); ++i)
+	{
+		if (_nodes[i->first].isChecked())
+		{
+			PortalLink link = { endIndex, _nodes[i->first].getTUCost(false) };
+			extraLinks[i->first].push_back(link);
+		}
+	}
+	_ignoreUnits = false;
+
+	// A* over the portals, on the same nodes as the real search
+	for (std::vector<PathfindingNode>::iterator it = _nodes.begin(); it != _nodes.end(); ++it)
+		it->reset();
+	PathfindingNode *start = &_nodes[startIndex], *end = &_nodes[endIndex];
+	start->connect(0, 0, 0, endPosition);
+	PathfindingOpenSet &openList = _openSet;
+	openList.clear();
+	openList.push(start);
+	while (!openList.empty())
+	{
+		PathfindingNode *currentNode = openList.pop();
+		currentNode->setChecked();
+		if (currentNode == end)
+			break;
+		int tile = currentNode - &_nodes[0];
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			std::map<int, std::vector<PortalLink> > &links = pass ? extraLinks : clusters[getCluster(currentNode->getPosition())].links;
+			std::map<int, std::vector<PortalLink> >::const_iterator i = links.find(tile);
+			if (i == links.end())
+				continue;
+			for (std::vector<PortalLink>::const_iterator j = i->second.begin(); j != i->second.end(); ++j)
+			{
+				PathfindingNode *nextNode = &_nodes[j->tile];
+				int tuCost = currentNode->getTUCost(false) + j->cost;
+				if (!nextNode->isChecked() && (!nextNode->inOpenSet() || nextNode->getTUCost(false) > tuCost))
+				{
+					nextNode->connect(tuCost, currentNode, -1, endPosition);
+					openList.push(nextNode);
+				}
+			}
+		}
+	}
+	if (!end->isChecked())
+		return false;
+
+	// refine with A* in the clusters the portal path goes through
+	_corridor.assign(clusters.size(), false);
+	for (PathfindingNode *node = end; node; node = node->getPrevNode())
+	{
+		_corridor[getCluster(node->getPosition())] = true;
+	}
+	_corridor[startCluster] = true;
+	bool found = aStarPath(startPosition, endPosition, 0, sneak);
+	_corridor.clear();
+	return found;
+}
+
 bool Pathfinding::getStrafeMove() const {
 	return _strafeMove;
 }
@@ -20,8 +20,15 @@
 #define OPENXCOM_PATHFINDING_H
 
 #include <vector>
+#include <map>
+#include <string>
+#include <iosfwd>
 #include "Position.h"
+#include "PathfindingOpenSet.h"
+#include "ReachabilityMap.h"
 #include "../Ruleset/MapData.h"
+#include "../Savegame/BitPlane.h"
+#include "../Savegame/TileArena.h"
 
 namespace OpenXcom
 {
@@ -38,11 +45,71 @@ class BattleUnit;
 class Pathfinding
 {
 private:
+	/// A recorded request for a path, to replay.
+	struct PathRequest
+	{
+		BattleUnit *unit, *missileTarget;
+		Position start, end;
+		bool sneak;
+	};
+	/// A step cost worked out from the terrain alone, with the offset to where the step ends.
+	struct MoveCost
+	{
+		short cost;
+		signed char dx, dy, dz;
+	};
+	/// A step out of a cluster into the next one, in the middle of an opening in their border.
+	struct Entrance
+	{
+		int inside, outside, cost;
+	};
+	/// A way from a portal tile to another tile, in the same cluster or across into the next one.
+	struct PortalLink
+	{
+		int tile, cost;
+	};
+	/// A map block sized column of the map, with the entrances on its sides and the costs between them.
+	struct Cluster
+	{
+		bool dirty;
+		std::vector<Entrance> sides[4];
+		std::map<int, std::vector<PortalLink> > links;
+		Cluster() : dirty(true) {}
+	};
+	/// Size of the clusters, the size of the map blocks the battlescape generator lays out.
+	static const int CLUSTER_SIZE = 10;
 	SavedBattleGame *_save;
 	std::vector<PathfindingNode> _nodes;
+	PathfindingOpenSet _openSet;
 	int _size;
 	std::vector<int> _path;
 	MovementType _movementType;
+	/// Cached step costs per movement type and unit size, 10 directions per tile, cost -1 if not worked out yet.
+	std::vector<MoveCost> _moveCosts[3][2];
+	/// Terrain revision of each tile, and of the whole map, when the cached step costs were last checked.
+	std::vector<int> _terrainRevisions;
+	int _terrainRevision;
+	/// Start tiles where a step can be affected by a unit, so the cache is bypassed.
+	BitPlane _nearUnits;
+	/// Units on the map when it was last checked, and a counter that goes up when they or the terrain change.
+	OccupancySnapshot _occupants;
+	int _mapRevision;
+	ReachabilityMap _reachability;
+	/// Reachability maps worked out ahead for a number of units, and the pathfindings of the threads that did it.
+	std::vector<ReachabilityMap> _plans;
+	std::vector<Pathfinding*> _planners;
+	const std::vector<BattleUnit*> *_planUnits;
+	int _planTUMax;
+	/// How many times a planned map was handed out, and how many times it had to be worked out again.
+	int _planHits, _planMisses;
+	/// Clusters of the hierarchical pathfinding per movement type, empty until it is first used.
+	std::vector<Cluster> _clusters[3];
+	int _clustersX, _clustersY;
+	bool _ignoreUnits;
+	/// Where the A* requests are recorded, or 0 if they aren't.
+	std::ofstream *_pathLog;
+	/// Clusters aStarPath may go through, or empty to search the whole map.
+	std::vector<bool> _corridor;
 	/// Gets the node at certain position.
 	PathfindingNode *getNode(const Position& pos);
 	/// whether a tile blocks a certain movementType
@@ -50,6 +117,40 @@ private:
 	bool canFallDown(Tile *destinationTile);
 	bool canFallDown(Tile *destinationTile, int size);
 	bool isOnStairs(const Position &startPosition, const Position &endPosition);
+	/// Appends a path request to the recorded ones.
+	void recordPath(const Position &startPosition, const Position &endPosition, BattleUnit *missileTarget, bool sneak);
+	/// Drops stale cached step costs and finds the tiles near units.
+	void prepareMoveCosts();
+	/// Drops the cached step costs that can depend on a tile.
+	void forgetMoveCosts(const Position &pos);
+	/// Gets the TU cost of one step, from the cache when possible.
+	int getCachedTUCost(const Position &startPosition, const int direction, Position *endPosition, BattleUnit *unit, BattleUnit *missileTarget);
+	/// Gets the cluster a position is in.
+	int getCluster(const Position &pos) const;
+	/// Marks the clusters whose portals can depend on a tile as needing an update.
+	void markClustersDirty(const Position &pos);
+	/// Brings the clusters of the current movement type up to date.
+	std::vector<Cluster> &updateClusters();
+	/// Finds the entrances on the east or south border of a cluster.
+	void findEntrances(int cluster, int side);
+	/// Works out the costs between the portals of a cluster.
+	void linkCluster(int cluster);
+	/// Finds the cost to every tile of a cluster, without leaving it.
+	void exploreCluster(const Position &startPosition, int cluster);
+	/// Try to find a path through the clusters first, then refine it between them.
+	bool hierarchicalPath(const Position &origin, const Position &target, bool sneak);
+	/// Checks if a reachability map still holds for a unit.
+	bool isCurrent(const ReachabilityMap &map, BattleUnit *unit, int tuMax) const;
+	/// Checks if a reachability map can depend on a tile that changed.
+	bool dependsOn(const ReachabilityMap &map, int index, bool unit) const;
+	/// Carries the reachability maps that don't depend on the changed tiles over to the next map revision.
+	void keepReachabilityMaps(const std::vector<int> &terrain, const std::vector<int> &units);
+	/// Works out the reachability map of a unit.
+	void buildReachabilityMap(BattleUnit *unit, int tuMax, ReachabilityMap &map);
+	/// Works out the reachability map of one unit of a plan.
+	static void planJob(void *pathfinding, int index, int thread);
+	/// Gets what the pathfinding sees of a unit standing on a tile.
+	static int getOccupantState(BattleUnit *unit);
 	BattleUnit *_unit;
 	bool _pathPreviewed;
 	bool _strafeMove;
@@ -64,6 +165,8 @@ public:
 	static const int DIR_UP = 8;
 	static const int DIR_DOWN = 9;
 	static const int O_BIGWALL = -1;
+	/// TU budget for findReachable and getReachabilityMap that no path will run out of.
+	static const int UNLIMITED_TU = 100000;
 	/// Creates a new Pathfinding class
 	Pathfinding(SavedBattleGame *save);
 	/// Cleans up the Pathfinding.
@@ -88,6 +191,20 @@ public:
 	void setUnit(BattleUnit *unit) { _unit = unit; };
 	/// Get all reachable tiles, based on cost.
 	std::vector<int> findReachable(BattleUnit *unit, int tuMax);
+	/// Get the cheapest cost to every tile a unit can reach, reusing the last map if nothing changed.
+	const ReachabilityMap &getReachabilityMap(BattleUnit *unit, int tuMax);
+	/// Work out the reachability maps of a number of units at once, ahead of asking for them.
+	void planReachability(const std::vector<BattleUnit*> &units, int tuMax);
+	/// Gets how many times a planned reachability map was used.
+	int getPlanHits() const { return _planHits; }
+	/// Gets how many times a planned reachability map had to be worked out again.
+	int getPlanMisses() const { return _planMisses; }
+	/// Drop all cached step costs.
+	void invalidateMoveCosts();
+	/// Starts recording the A* requests to a log, for replaying them later.
+	void recordPaths(const std::string &filename, const std::string &save);
+	/// Replays the recorded A* requests of a log and times them.
+	int replayPaths(std::istream &log, int *paths, int *found);
 	/// get _totalTUCost; find out whether we can hike somewhere in this turn or not
 	int getTotalTUCost() const { return _totalTUCost; }
 };
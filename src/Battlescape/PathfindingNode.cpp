@@ -27,7 +27,7 @@ namespace OpenXcom
  * Sets up a PathfindingNode.
  * @param pos Position.
  */
-PathfindingNode::PathfindingNode(Position pos) : _pos(pos), _openentry(0)
+PathfindingNode::PathfindingNode(Position pos) : _pos(pos), _openIndex(-1), _openCost(0)
 {
 
 }
@@ -54,7 +54,7 @@ const Position &PathfindingNode::getPosition() const
 void PathfindingNode::reset()
 {
 	_checked = false;
-	_openentry = 0;
+	_openIndex = -1;
 }
 
 /**
@@ -25,7 +25,6 @@ namespace OpenXcom
 {
 
 class PathfindingOpenSet;
-struct OpenSetEntry;
 
 /**
  * A class that holds pathfinding info for a certain node on the map.
@@ -40,8 +39,9 @@ private:
 	int _prevDir;
 	/// Approximate cost to reach goal position.
 	int _tuGuess;
-	// Invasive field needed by PathfindingOpenSet
-	OpenSetEntry *_openentry;
+	// Invasive fields needed by PathfindingOpenSet: place in its heap (-1 if not in it) and cost there
+	int _openIndex;
+	int _openCost;
 	friend class PathfindingOpenSet;
 public:
 	/// Creates a new PathfindingNode class
@@ -65,7 +65,7 @@ public:
 	/// get previous walking direction
 	int getPrevDir() const;
 	/// Is this node already in a PathfindingOpenSet?
-	bool inOpenSet() const { return (_openentry != 0); }
+	bool inOpenSet() const { return (_openIndex != -1); }
 	/// Get approximate cost to reach target position.
 	int getTUGuess() const { return _tuGuess; }
 	/// Connect to previous node along the path.
@@ -16,6 +16,7 @@
  * You should have received a copy of the GNU General Public License
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <cassert>
 #include "PathfindingOpenSet.h"
 #include "PathfindingNode.h"
 
@@ -23,27 +24,94 @@ namespace OpenXcom
 {
 
 /**
- * Cleans up all the entries still in set.
+ * Creates an empty open set.
+ */
+PathfindingOpenSet::PathfindingOpenSet()
+{
+}
+
+/**
+ * Cleans up the open set. The nodes belong to the pathfinding.
  */
 PathfindingOpenSet::~PathfindingOpenSet()
 {
-	while (!_queue.empty())
+}
+
+/**
+ * Makes room for a number of nodes, so pushing them doesn't allocate.
+ * @param size The number of nodes.
+ */
+void PathfindingOpenSet::reserve(int size)
+{
+	_heap.reserve(size);
+}
+
+/**
+ * Removes all the nodes from the set. The nodes themselves must be reset separately.
+ */
+void PathfindingOpenSet::clear()
+{
+	_heap.clear();
+}
+
+/**
+ * Puts a node at a place in the heap and lets it know where it is.
+ * @param node A pointer to the node.
+ * @param index The place in the heap.
+ */
+void PathfindingOpenSet::place(PathfindingNode *node, int index)
+{
+	_heap[index] = node;
+	node->_openIndex = index;
+}
+
+/**
+ * Moves a node up the heap until its parent costs no more than it.
+ * @param index The place of the node in the heap.
+ */
+void PathfindingOpenSet::siftUp(int index)
+{
+	PathfindingNode *node = _heap[index];
+	while (index > 0)
 	{
-		delete _queue.top();
-		_queue.pop();
+		int parent = (index - 1) / 2;
+		if (_heap[parent]->_openCost <= node->_openCost)
+		{
+			break;
+		}
+		place(_heap[parent], index);
+		index = parent;
 	}
+	place(node, index);
 }
 
 /**
- * Keep removing all discarded entries that have come to the top of the queue.
+ * Moves a node down the heap until its children cost no less than it.
+ * @param index The place of the node in the heap.
  */
-void PathfindingOpenSet::removeDiscarded()
+void PathfindingOpenSet::siftDown(int index)
 {
-	while (!_queue.empty() && !_queue.top()->_node)
+	PathfindingNode *node = _heap[index];
+	int size = _heap.size();
+	while (true)
 	{
-		delete _queue.top();
-		_queue.pop();
+		int child = index * 2 + 1;
+		if (child >= size)
+		{
+			break;
+		}
+		if (child + 1 < size && _heap[child + 1]->_openCost < _heap[child]->_openCost)
+		{
+			++child;
+		}
+		if (node->_openCost <= _heap[child]->_openCost)
+		{
+			break;
+		}
+		place(_heap[child], index);
+		index = child;
 	}
+	place(node, index);
 }
 
 /**
@@ -54,31 +122,33 @@ void PathfindingOpenSet::removeDiscarded()
 PathfindingNode *PathfindingOpenSet::pop()
 {
 	assert(!empty());
-	PathfindingNode *nd = _queue.top()->_node;
-	delete _queue.top();
-	_queue.pop();
-	nd->_openentry = 0;
-
-	// Discarded entries might be visible now.
-	removeDiscarded();
+	PathfindingNode *nd = _heap.front();
+	PathfindingNode *last = _heap.back();
+	_heap.pop_back();
+	if (!_heap.empty())
+	{
+		place(last, 0);
+		siftDown(0);
+	}
+	nd->_openIndex = -1;
 	return nd;
 }
 
 /**
  * Place the node in the set.
- * If the node was already in the set, the previous entry is discarded.
+ * If the node was already in the set, it is moved to match its new cost.
  * It is the caller's responsibility to never re-add a node with a worse cost.
  * @param node A pointer to the node to add.
  */
 void PathfindingOpenSet::push(PathfindingNode *node)
 {
-	OpenSetEntry *entry = new OpenSetEntry;
-	entry->_node = node;
-	entry->_cost = node->getTUCost(false) + node->getTUGuess();
-	if (node->_openentry)
-		node->_openentry->_node = 0;
-	node->_openentry = entry;
-	_queue.push(entry);
+	node->_openCost = node->getTUCost(false) + node->getTUGuess();
+	if (node->_openIndex == -1)
+	{
+		_heap.push_back(node);
+		node->_openIndex = _heap.size() - 1;
+	}
+	siftUp(node->_openIndex);
 }
 
 
@@ -19,57 +19,46 @@
 #ifndef OPENXCOM_PATHFINDINGOPENSET_H
 #define OPENXCOM_PATHFINDINGOPENSET_H
 
-#include <queue>
+#include <vector>
 
 namespace OpenXcom
 {
 
 class PathfindingNode;
 
-struct OpenSetEntry
-{
-	int _cost;
-	PathfindingNode *_node;
-};
-
-/**
- * Helper class to compare entries through pointers.
- */
-class EntryCompare
-{
-public:
- 	/**
-	 * Compare entries @a *a and @a *b.
-         * @param a Pointer to first entry.
-         * @param b Pointer to second entry.
-	 * @return true If entry @a *b must come before @a *a.
-	 */
-	bool operator()(OpenSetEntry *a, OpenSetEntry *b) const
-	{
-		return b->_cost < a->_cost;
-	}
-};
-
 /**
  * A class that holds references to the nodes to be examined in pathfinding.
+ * It is a binary heap of the nodes themselves, each node knowing where it is in the heap,
+ * so a node found along a cheaper path is moved up in place instead of being added again.
+ * The storage is kept between searches, so a search doesn't allocate anything.
  */
 class PathfindingOpenSet
 {
 public:
-	/// Cleanup the set and free allocated memory.
+	/// Creates an empty set.
+	PathfindingOpenSet();
+	/// Cleans up the set.
 	~PathfindingOpenSet();
+	/// Makes room for a number of nodes.
+	void reserve(int size);
+	/// Empties the set.
+	void clear();
 	/// Get the next node to check.
 	PathfindingNode *pop();
 	/// Add a node in the set.
 	void push(PathfindingNode *node);
 	/// Is the set empty?
-	bool empty() const { return _queue.empty(); }
+	bool empty() const { return _heap.empty(); }
 
 private:
-	std::priority_queue<OpenSetEntry*, std::vector<OpenSetEntry*>, EntryCompare> _queue;
+	std::vector<PathfindingNode*> _heap;
 
-	/// Remove reachable discarded entries.
-	void removeDiscarded();
+	/// Moves a node up the heap until its parent costs no more than it.
+	void siftUp(int index);
+	/// Moves a node down the heap until its children cost no less than it.
+	void siftDown(int index);
+	/// Puts a node at a place in the heap.
+	void place(PathfindingNode *node, int index);
 };
 
 }
@@ -29,6 +29,7 @@
 #include "../Engine/Options.h"
 #include "../Ruleset/Armor.h"
 #include "../Savegame/Tile.h"
+#include "../Savegame/SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -95,6 +96,36 @@ void PatrolBAIState::save(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the AI state from binary.
+ * @param buffer Pointer to the state data, after its name.
+ * @param end End of the save data.
+ */
+void PatrolBAIState::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	int fromnodeID = unserializeInt(buffer, end);
+	int tonodeID = unserializeInt(buffer, end);
+	if (fromnodeID != -1)
+	{
+		_fromNode = _game->getNodes()->at(fromnodeID);
+	}
+	if (tonodeID != -1)
+	{
+		_toNode = _game->getNodes()->at(tonodeID);
+	}
+}
+
+/**
+ * Saves the AI state to binary.
+ * @param buffer Buffer to add the state to.
+ */
+void PatrolBAIState::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeString(buffer, "PATROL");
+	serializeInt(buffer, _fromNode ? _fromNode->getID() : -1);
+	serializeInt(buffer, _toNode ? _toNode->getID() : -1);
+}
+
 /**
  * Enters the current AI state.
  */
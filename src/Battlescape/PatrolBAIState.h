@@ -45,6 +45,10 @@ public:
 	void load(const YAML::Node& node);
 	/// Saves the AI state to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads the AI state from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the AI state to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Enters the state.
 	void enter();
 	/// Exits the state.
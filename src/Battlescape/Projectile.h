@@ -22,6 +22,7 @@
 #include <vector>
 #include "Position.h"
 #include "BattlescapeGame.h"
+#include "../Engine/MemoryPool.h"
 
 namespace OpenXcom
 {
@@ -52,6 +53,10 @@ public:
 	Projectile(ResourcePack *res, SavedBattleGame *save, BattleAction action, Position origin);
 	/// Cleans up the Projectile.
 	~Projectile();
+	/// Gets the memory for a projectile from the pool.
+	static void *operator new(size_t size) { return MemoryPool::allocate(size); }
+	/// Gives the memory of a projectile back to the pool.
+	static void operator delete(void *p, size_t size) { MemoryPool::deallocate(p, size); }
 	/// Calculates the trajectory for straight path.
 	int calculateTrajectory(double accuracy);
 	/// Calculates the trajectory for curved path.
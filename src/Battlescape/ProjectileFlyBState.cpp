@@ -81,15 +81,14 @@ void ProjectileFlyBState::init()
 	if (!_parent->getSave()->getTile(_action.target)) // invalid target position
 		return;
 
-	if (_action.actor->getTimeUnits() < _action.TU)
+	_unit = _action.actor;
+	_ammo = weapon->getAmmoItem();
+	_action.result = validateAction(_parent->getTileEngine(), &_action);
+	if (!_action.result.empty())
 	{
-		_action.result = "STR_NOT_ENOUGH_TIME_UNITS";
 		_parent->popState();
 		return;
 	}
-
-	_unit = _action.actor;
-	_ammo = weapon->getAmmoItem();
 	if (_unit->isOut())
 	{
 		// something went wrong - we can't shoot when dead or unconscious
@@ -97,52 +96,17 @@ void ProjectileFlyBState::init()
 		return;
 	}
 
-	// autoshot will default back to snapshot if it's not possible
-	if (weapon->getRules()->getAccuracyAuto() == 0 && _action.type == BA_AUTOSHOT)
-		_action.type = BA_SNAPSHOT;
-
-	// snapshot defaults to "hit" if it's a melee weapon
-	// (in case of reaction "shots" with a melee weapon)
-	if (weapon->getRules()->getBattleType() == BT_MELEE && _action.type == BA_SNAPSHOT)
-		_action.type = BA_HIT;
-
 	switch (_action.type)
 	{
 	case BA_SNAPSHOT:
 	case BA_AIMEDSHOT:
 	case BA_AUTOSHOT:
 	case BA_LAUNCH:
-		if (_ammo == 0)
-		{
-			_action.result = "STR_NO_AMMUNITION_LOADED";
-			_parent->popState();
-			return;
-		}
-		if (_ammo->getAmmoQuantity() == 0)
-		{
-			_action.result = "STR_NO_ROUNDS_LEFT";
-			_parent->popState();
-			return;
-		}
+	case BA_HIT:
 		break;
 	case BA_THROW:
-		if (!validThrowRange(&_action))
-		{
-			// out of range
-			_action.result = "STR_OUT_OF_RANGE";
-			_parent->popState();
-			return;
-		}
 		_projectileItem = weapon;
 		break;
-	case BA_HIT:
-		if (!_parent->getTileEngine()->validMeleeRange(_action.actor->getPosition(), _action.actor->getDirection(), _action.actor->getArmor()->getSize(), _action.actor->getHeight(), 0))
-		{
-			_action.result = "STR_THERE_IS_NO_ONE_THERE";
-			_parent->popState();
-			return;
-		}
-		break;
 	case BA_PANIC:
 	case BA_MINDCONTROL:
 		_parent->statePushFront(new ExplosionBState(_parent, Position((_action.target.x*16)+8,(_action.target.y*16)+8,(_action.target.z*24)+10), weapon, _action.actor));
@@ -237,10 +201,9 @@ bool ProjectileFlyBState::createNewProjectile()
 				// and we have a lift-off
 				if (_action.weapon->getRules()->getFireSound() != -1)
 					_parent->getResourcePack()->getSound("BATTLE.CAT", _action.weapon->getRules()->getFireSound())->play();
-				if (!_parent->getSave()->getDebugMode() && _action.type != BA_LAUNCH && _ammo->spendBullet() == false)
+				if (!_parent->getSave()->getDebugMode() && _action.type != BA_LAUNCH)
 				{
-					_parent->getSave()->removeItem(_ammo);
-					_action.weapon->setAmmoItem(0);
+					spendBullet(_parent->getSave(), _action.weapon, _ammo);
 				}
 		}
 		else
@@ -314,23 +277,14 @@ void ProjectileFlyBState::think()
 			}
 			else
 			{
-				if (_action.type == BA_LAUNCH && _ammo->spendBullet() == false)
+				if (_action.type == BA_LAUNCH)
 				{
-					_parent->getSave()->removeItem(_ammo);
-					_action.weapon->setAmmoItem(0);
+					spendBullet(_parent->getSave(), _action.weapon, _ammo);
 				}
 
 				if (_projectileImpact != 5) // out of map
 				{
-					int offset = 0;
-					// explosions impact not inside the voxel but one step back
-					if (_ammo && (
-						_ammo->getRules()->getDamageType() == DT_HE ||
-						_ammo->getRules()->getDamageType() == DT_IN))
-					{
-						offset = -1;
-					}
-					_parent->statePushFront(new ExplosionBState(_parent, _parent->getMap()->getProjectile()->getPosition(offset), _ammo, _action.actor));
+					_parent->statePushFront(new ExplosionBState(_parent, _parent->getMap()->getProjectile()->getPosition(getImpactOffset(_ammo)), _ammo, _action.actor));
 				}
 				else
 				{
@@ -373,4 +327,93 @@ bool ProjectileFlyBState::validThrowRange(BattleAction *action)
 	return realDistance < maxDistance;
 }
 
+/**
+ * Checks if a shot, throw or hit can be done. An autoshot defaults back to a snapshot
+ * if it's not possible, and a snapshot to a hit with a melee weapon (in case of
+ * reaction "shots" with a melee weapon). The battle simulator checks its actions
+ * with this too, so both go by the same rules.
+ * @param engine Pointer to the tile engine.
+ * @param action The action, which gets its type changed.
+ * @return The reason it can't be done, empty if it can.
+ */
+std::string ProjectileFlyBState::validateAction(TileEngine *engine, BattleAction *action)
+{
+	BattleItem *weapon = action->weapon;
+	if (action->actor->getTimeUnits() < action->TU)
+	{
+		return "STR_NOT_ENOUGH_TIME_UNITS";
+	}
+
+	if (weapon->getRules()->getAccuracyAuto() == 0 && action->type == BA_AUTOSHOT)
+		action->type = BA_SNAPSHOT;
+
+	if (weapon->getRules()->getBattleType() == BT_MELEE && action->type == BA_SNAPSHOT)
+		action->type = BA_HIT;
+
+	switch (action->type)
+	{
+	case BA_SNAPSHOT:
+	case BA_AIMEDSHOT:
+	case BA_AUTOSHOT:
+	case BA_LAUNCH:
+		if (weapon->getAmmoItem() == 0)
+		{
+			return "STR_NO_AMMUNITION_LOADED";
+		}
+		if (weapon->getAmmoItem()->getAmmoQuantity() == 0)
+		{
+			return "STR_NO_ROUNDS_LEFT";
+		}
+		break;
+	case BA_THROW:
+		if (!validThrowRange(action))
+		{
+			// out of range
+			return "STR_OUT_OF_RANGE";
+		}
+		break;
+	case BA_HIT:
+		if (!engine->validMeleeRange(action->actor->getPosition(), action->actor->getDirection(), action->actor->getArmor()->getSize(), action->actor->getHeight(), 0))
+		{
+			return "STR_THERE_IS_NO_ONE_THERE";
+		}
+		break;
+	default:
+		break;
+	}
+	return "";
+}
+
+/**
+ * Spends a round of a weapon's ammo, and takes the clip out of the game when it's empty.
+ * @param save Pointer to the battle.
+ * @param weapon The weapon.
+ * @param ammo The weapon's ammo.
+ */
+void ProjectileFlyBState::spendBullet(SavedBattleGame *save, BattleItem *weapon, BattleItem *ammo)
+{
+	if (ammo->spendBullet() == false)
+	{
+		save->removeItem(ammo);
+		weapon->setAmmoItem(0);
+	}
+}
+
+/**
+ * Gets how far back along its path a projectile's ammo goes off:
+ * explosions impact not inside the voxel but one step back.
+ * @param ammo The ammo, 0 for none.
+ * @return The offset to the projectile's position.
+ */
+int ProjectileFlyBState::getImpactOffset(BattleItem *ammo)
+{
+	if (ammo && (
+		ammo->getRules()->getDamageType() == DT_HE ||
+		ammo->getRules()->getDamageType() == DT_IN))
+	{
+		return -1;
+	}
+	return 0;
+}
+
 }
@@ -28,6 +28,8 @@ namespace OpenXcom
 class BattlescapeGame;
 class BattleUnit;
 class BattleItem;
+class SavedBattleGame;
+class TileEngine;
 
 class ProjectileFlyBState : public BattleState
 {
@@ -53,6 +55,12 @@ public:
 	/// Runs state functionality every cycle.
 	void think();
 	static bool validThrowRange(BattleAction *action);
+	/// Checks if a shot, throw or hit can be done, turning it into the action it really is.
+	static std::string validateAction(TileEngine *engine, BattleAction *action);
+	/// Spends a round of a weapon's ammo, unloading the clip when it runs out.
+	static void spendBullet(SavedBattleGame *save, BattleItem *weapon, BattleItem *ammo);
+	/// Gets how far back from where a projectile hit its ammo goes off.
+	static int getImpactOffset(BattleItem *ammo);
 };
 
 }
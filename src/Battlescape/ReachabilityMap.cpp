@@ -0,0 +1,121 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ReachabilityMap.h"
+#include "../Savegame/SavedBattleGame.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Creates an empty reachability map, that doesn't match any unit.
+ * @param save Pointer to the battle.
+ */
+ReachabilityMap::ReachabilityMap(SavedBattleGame *save) : _save(save), _unit(0), _origin(-1, -1, -1), _tuMax(0), _movementType(MT_WALK), _mapRevision(-1)
+{
+}
+
+/**
+ * Cleans up the reachability map.
+ */
+ReachabilityMap::~ReachabilityMap()
+{
+}
+
+/**
+ * Gets the index of a tile on the map.
+ * @param pos Position of the tile.
+ * @return Tile index, or -1 if the position is outside the map.
+ */
+int ReachabilityMap::getIndex(const Position &pos) const
+{
+	if (_cost.empty() || !_save->getTile(pos))
+		return -1;
+	return _save->getTileIndex(pos);
+}
+
+/**
+ * Gets the TU cost of the cheapest path from the unit to a tile.
+ * @param pos Position of the tile.
+ * @return TU cost, or -1 if the tile can't be reached.
+ */
+int ReachabilityMap::getTUCost(const Position &pos) const
+{
+	int index = getIndex(pos);
+	return index == -1 ? -1 : _cost[index];
+}
+
+/**
+ * Gets the tiles the unit can reach and still have some TUs left,
+ * for example to fire once it gets there.
+ * @param tu The TUs the unit has to spend.
+ * @param tuLeft The TUs it must have left.
+ * @return Indices of the tiles, cheapest first.
+ */
+std::vector<int> ReachabilityMap::getTilesWithTULeft(int tu, int tuLeft) const
+{
+	std::vector<int> tiles;
+	for (std::vector<int>::const_iterator i = _tiles.begin(); i != _tiles.end() && _cost[*i] <= tu - tuLeft; ++i)
+	{
+		tiles.push_back(*i);
+	}
+	return tiles;
+}
+
+/**
+ * Finds which of a list of tiles is the cheapest to reach.
+ * @param targets Positions of the tiles.
+ * @return Index in the list of the cheapest tile, or -1 if none can be reached.
+ */
+int ReachabilityMap::findCheapest(const std::vector<Position> &targets) const
+{
+	int best = -1, bestCost = 0;
+	for (size_t i = 0; i != targets.size(); ++i)
+	{
+		int cost = getTUCost(targets[i]);
+		if (cost != -1 && (best == -1 || cost < bestCost))
+		{
+			best = i;
+			bestCost = cost;
+		}
+	}
+	return best;
+}
+
+/**
+ * Gets the directions to walk along the cheapest path to a tile.
+ * Like the pathfinding's own path, they are stored last step first.
+ * @param pos Position of the tile.
+ * @param path Pointer to the vector to fill with directions.
+ * @return True if the tile can be reached.
+ */
+bool ReachabilityMap::getPath(const Position &pos, std::vector<int> *path) const
+{
+	path->clear();
+	int index = getIndex(pos);
+	if (index == -1 || _cost[index] == -1)
+		return false;
+	while (_prevTile[index] != -1)
+	{
+		path->push_back(_prevDir[index]);
+		index = _prevTile[index];
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_REACHABILITYMAP_H
+#define OPENXCOM_REACHABILITYMAP_H
+
+#include <vector>
+#include "Position.h"
+#include "../Ruleset/MapData.h"
+
+namespace OpenXcom
+{
+
+class SavedBattleGame;
+class BattleUnit;
+
+/**
+ * The cheapest TU cost from where a unit stands to every tile it can walk to,
+ * with the way back along each cheapest path.
+ * Built by Pathfinding::getReachabilityMap, which keeps handing out the same map
+ * for the same unit until the unit moves or the map changes, so the AI and the
+ * interface can ask it as many questions as they like for one search.
+ */
+class ReachabilityMap
+{
+private:
+	SavedBattleGame *_save;
+	BattleUnit *_unit;
+	Position _origin;
+	int _tuMax;
+	MovementType _movementType;
+	int _mapRevision;
+	std::vector<BattleUnit*> _visibleUnits;
+	std::vector<int> _cost, _prevTile, _tiles;
+	std::vector<signed char> _prevDir;
+	friend class Pathfinding;
+	/// Gets the index of a tile on the map, or -1 if it's outside.
+	int getIndex(const Position &pos) const;
+public:
+	/// Creates an empty map.
+	ReachabilityMap(SavedBattleGame *save);
+	/// Cleans up the map.
+	~ReachabilityMap();
+	/// Gets the unit the map was built for.
+	BattleUnit *getUnit() const { return _unit; }
+	/// Gets the position the map was built from.
+	const Position &getOrigin() const { return _origin; }
+	/// Gets the cheapest TU cost to reach a tile.
+	int getTUCost(const Position &pos) const;
+	/// Checks if a tile can be reached.
+	bool isReachable(const Position &pos) const { return getTUCost(pos) != -1; }
+	/// Gets the reachable tiles, cheapest first.
+	const std::vector<int> &getTiles() const { return _tiles; }
+	/// Gets the tiles that can be reached leaving some TUs.
+	std::vector<int> getTilesWithTULeft(int tu, int tuLeft) const;
+	/// Finds the cheapest to reach of some tiles.
+	int findCheapest(const std::vector<Position> &targets) const;
+	/// Gets the cheapest path to a tile.
+	bool getPath(const Position &pos, std::vector<int> *path) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,335 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ThreatMap.h"
+#include <cstdlib>
+#include <algorithm>
+#include "TileEngine.h"
+#include "../Savegame/SavedBattleGame.h"
+#include "../Savegame/Tile.h"
+#include "../Savegame/TileArena.h"
+#include "../Engine/ThreadPool.h"
+
+namespace OpenXcom
+{
+
+/// Voxels above the floor of a tile that a unit standing there can be shot at: around its legs and its chest.
+const int ThreatMap::heights[ThreatMap::HEIGHTS] = {6, 16};
+
+/**
+ * Gets what the threat map sees of a unit standing on a tile: whether it's out.
+ * @param unit Pointer to the unit.
+ * @return The state of the unit.
+ */
+int ThreatMap::getOccupantState(BattleUnit *unit)
+{
+	return unit->isOut();
+}
+
+/**
+ * Creates an empty threat map.
+ * @param save Pointer to the battle.
+ * @param engine Pointer to the tile engine tracing the lines of fire.
+ * @param faction The faction whose units make the threat.
+ */
+ThreatMap::ThreatMap(SavedBattleGame *save, TileEngine *engine, UnitFaction faction) : _save(save), _engine(engine), _faction(faction), _occupants(getOccupantState), _terrainRevision(-1), _smoky(false)
+{
+}
+
+/**
+ * Cleans up the threat map.
+ */
+ThreatMap::~ThreatMap()
+{
+}
+
+/**
+ * Brings the threat map up to date. Only the units that moved, changed sides or went out,
+ * and the ones that had the terrain, the smoke or the units within their view change
+ * since the last update, are traced again, so the AI can call this before every
+ * action and it costs next to nothing when nothing happened.
+ * @return True if the threat to any tile may have changed.
+ */
+bool ThreatMap::update()
+{
+	int size = _save->getMapSizeXYZ();
+	if ((int)_threats.size() != size)
+	{
+		_threats.assign(size, 0);
+		_terrainRevisions.assign(size, -1);
+		_smoke.assign(size, 0);
+		_smokingTiles.clear();
+		_occupants.clear();
+		_terrainRevision = -1;
+		_watchers.clear();
+	}
+
+	std::vector<Position> changed;
+	findChanges(&changed);
+
+	std::vector<BattleUnit*> *units = _save->getUnits();
+	if (_watchers.size() < units->size())
+	{
+		_watchers.resize(units->size());
+	}
+	_dirty.clear();
+	bool updated = false;
+	for (size_t i = 0; i < units->size(); ++i)
+	{
+		BattleUnit *unit = units->at(i);
+		Watcher &watcher = _watchers[i];
+		bool active = unit->getFaction() == _faction && !unit->isOut();
+		Position eye = active ? _engine->getSightOriginVoxel(unit) : Position(-1, -1, -1);
+		int range = active ? _engine->getViewDistance(unit) : 0;
+		bool dirty = watcher.unit != unit || watcher.eye != eye || watcher.range != range;
+		if (!dirty && active)
+		{
+			Position center = unit->getPosition();
+			for (std::vector<Position>::const_iterator j = changed.begin(); j != changed.end() && !dirty; ++j)
+			{
+				dirty = abs(j->x - center.x) <= range + 1 && abs(j->y - center.y) <= range + 1;
+			}
+		}
+		if (!dirty)
+			continue;
+
+		updated = true;
+		if (watcher.counted)
+		{
+			count(watcher, -1);
+			watcher.counted = false;
+		}
+		watcher.unit = unit;
+		watcher.eye = eye;
+		watcher.range = range;
+		if (active)
+		{
+			_dirty.push_back(i);
+		}
+	}
+
+	if (_dirty.empty())
+		return updated;
+
+	// tracing reads the voxel shapes, which have to be cached before the threads share them
+	_engine->calculateVoxelShapes();
+	_engine->getThreadPool()->run(traceJob, this, _dirty.size());
+	for (std::vector<int>::const_iterator i = _dirty.begin(); i != _dirty.end(); ++i)
+	{
+		count(_watchers[*i], +1);
+		_watchers[*i].counted = true;
+	}
+	return true;
+}
+
+/**
+ * Finds the tiles whose terrain or smoke changed since the last update, and the tiles
+ * a unit came onto, left or went out on, as all of them can change the lines of fire
+ * going through them. The tiles are only gone through when the map's terrain revision
+ * says one of them changed; the smoke and the units are found through the arena's lists.
+ * @param changed The vector to add the positions of the tiles to.
+ */
+void ThreatMap::findChanges(std::vector<Position> *changed)
+{
+	Tile **tiles = _save->getTiles();
+	TileArena *arena = _save->getTileArena();
+	if (arena->getTerrainRevision() != _terrainRevision)
+	{
+		int size = _save->getMapSizeXYZ();
+		for (int i = 0; i < size; ++i)
+		{
+			if (_terrainRevisions[i] != tiles[i]->getTerrainRevision())
+			{
+				_terrainRevisions[i] = tiles[i]->getTerrainRevision();
+				changed->push_back(tiles[i]->getPosition());
+			}
+		}
+		_terrainRevision = arena->getTerrainRevision();
+	}
+
+	// tiles where the smoke cleared are off the arena's list, so the last list is checked too
+	std::vector<int> smoking = arena->getSmokingTiles();
+	_smokingTiles.insert(_smokingTiles.end(), smoking.begin(), smoking.end());
+	for (std::vector<int>::const_iterator i = _smokingTiles.begin(); i != _smokingTiles.end(); ++i)
+	{
+		int smoke = tiles[*i]->getSmoke();
+		if (smoke != _smoke[*i])
+		{
+			_smoke[*i] = smoke;
+			changed->push_back(tiles[*i]->getPosition());
+		}
+	}
+	_smokingTiles.swap(smoking);
+	_smoky = !_smokingTiles.empty();
+
+	std::vector<int> units;
+	_occupants.update(arena, &units);
+	for (std::vector<int>::const_iterator i = units.begin(); i != units.end(); ++i)
+	{
+		changed->push_back(tiles[*i]->getPosition());
+	}
+}
+
+/**
+ * Forgets all traced threats.
+ */
+void ThreatMap::invalidate()
+{
+	_threats.clear();
+	_terrainRevisions.clear();
+	_smoke.clear();
+	_smokingTiles.clear();
+	_occupants.clear();
+	_watchers.clear();
+}
+
+/**
+ * Traces the threat of one of the units that need it in an update.
+ * @param map Pointer to the threat map.
+ * @param index Index of the unit among the ones to trace.
+ * @param thread Number of the thread running the trace.
+ */
+void ThreatMap::traceJob(void *map, int index, int)
+{
+	ThreatMap *self = (ThreatMap*)map;
+	self->trace(self->_watchers[self->_dirty[index]]);
+}
+
+/**
+ * Traces lines of fire from a unit's eye to every tile it can see, as far as it can see
+ * through the smoke. A tile is threatened when any of the points a unit standing there
+ * could be hit at is in plain sight.
+ * This only reads the battlescape, so several units can be traced at the same time.
+ * @param watcher The unit to trace.
+ */
+void ThreatMap::trace(Watcher &watcher)
+{
+	watcher.tiles.resize(_save->getMapSizeXYZ());
+	std::vector<Position> trajectory;
+	Position center = watcher.unit->getPosition();
+	int range = watcher.range;
+	int minX = std::max(0, center.x - range), maxX = std::min(_save->getMapSizeX() - 1, center.x + range);
+	int minY = std::max(0, center.y - range), maxY = std::min(_save->getMapSizeY() - 1, center.y + range);
+	for (int z = 0; z < _save->getMapSizeZ(); ++z)
+	{
+		for (int y = minY; y <= maxY; ++y)
+		{
+			for (int x = minX; x <= maxX; ++x)
+			{
+				Position pos(x, y, z);
+				int distance = _engine->distance(center, pos);
+				if (distance > range)
+					continue;
+
+				Tile *tile = _save->getTile(pos);
+				int index = _save->getTileIndex(pos);
+				if (pos == center)
+				{
+					watcher.tiles.set(index);
+					continue;
+				}
+				for (int h = 0; h < HEIGHTS; ++h)
+				{
+					Position target(x * 16 + 8, y * 16 + 8, z * 24 - tile->getTerrainLevel() + heights[h]);
+					trajectory.clear();
+					int result = _engine->calculateLine(watcher.eye, target, _smoky, &trajectory, watcher.unit);
+					// a unit standing on the tile right now doesn't hide it
+					if ((result == -1 || (result == 4 && trajectory.back().x / 16 == x && trajectory.back().y / 16 == y))
+						&& (!_smoky || distance <= range - smokeDecay(trajectory, center)))
+					{
+						watcher.tiles.set(index);
+						break;
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Works out how much the smoke a line of sight goes through cuts the view,
+ * the same way TileEngine::visible does.
+ * @param trajectory The voxels of the line.
+ * @param origin Position of the tile the line starts on, whose smoke is already counted.
+ * @return Number of tiles less that can be seen along the line.
+ */
+int ThreatMap::smokeDecay(const std::vector<Position> &trajectory, const Position &origin) const
+{
+	int decay = 0;
+	Tile *t = _save->getTile(origin);
+	for (std::vector<Position>::const_iterator i = trajectory.begin(); i != trajectory.end(); ++i)
+	{
+		Tile *next = _save->getTile(Position(i->x / 16, i->y / 16, i->z / 24));
+		if (next != t)
+		{
+			t = next;
+			decay += t->getSmoke() / 2;
+		}
+	}
+	return decay;
+}
+
+/**
+ * Adds or takes the tiles a unit threatens to the threat count of each tile.
+ * @param watcher The unit.
+ * @param change 1 to add the unit, -1 to take it away.
+ */
+void ThreatMap::count(const Watcher &watcher, int change)
+{
+	int size = watcher.tiles.size();
+	for (int i = 0; i < size; ++i)
+	{
+		if (watcher.tiles.get(i))
+		{
+			_threats[i] += change;
+		}
+	}
+}
+
+/**
+ * Gets how many units threaten a tile.
+ * @param pos Position of the tile.
+ * @return Number of units that can see or shoot at the tile.
+ */
+int ThreatMap::getThreat(const Position &pos) const
+{
+	if (_threats.empty() || !_save->getTile(pos))
+		return 0;
+	return _threats[_save->getTileIndex(pos)];
+}
+
+/**
+ * Gets the units that threaten a tile.
+ * @param pos Position of the tile.
+ * @param units The vector to add the units to.
+ */
+void ThreatMap::getThreats(const Position &pos, std::vector<BattleUnit*> *units) const
+{
+	if (getThreat(pos) == 0)
+		return;
+	int index = _save->getTileIndex(pos);
+	for (std::vector<Watcher>::const_iterator i = _watchers.begin(); i != _watchers.end(); ++i)
+	{
+		if (i->counted && i->tiles.get(index))
+		{
+			units->push_back(i->unit);
+		}
+	}
+}
+
+}
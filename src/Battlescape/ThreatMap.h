@@ -0,0 +1,89 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_THREATMAP_H
+#define OPENXCOM_THREATMAP_H
+
+#include <vector>
+#include "Position.h"
+#include "../Savegame/BattleUnit.h"
+#include "../Savegame/BitPlane.h"
+#include "../Savegame/TileArena.h"
+
+namespace OpenXcom
+{
+
+class SavedBattleGame;
+class TileEngine;
+
+/**
+ * Which tiles the units of a faction can see or shoot at, worked out once for every unit
+ * and then only again for the units that moved or saw the terrain, the smoke or the
+ * units within their view change.
+ * The AI of the other side asks it how exposed a tile is, instead of checking
+ * every enemy unit's line of fire for every tile it considers.
+ */
+class ThreatMap
+{
+private:
+	static const int HEIGHTS = 2;
+	static const int heights[HEIGHTS];
+	/// The tiles one unit threatens, and where it was looking from when they were traced.
+	struct Watcher
+	{
+		BattleUnit *unit;
+		Position eye;
+		int range;
+		bool counted;
+		BitPlane tiles;
+		Watcher() : unit(0), eye(-1, -1, -1), range(0), counted(false) {}
+	};
+	SavedBattleGame *_save;
+	TileEngine *_engine;
+	UnitFaction _faction;
+	std::vector<Watcher> _watchers;
+	std::vector<int> _dirty, _threats, _terrainRevisions, _smoke, _smokingTiles;
+	OccupancySnapshot _occupants;
+	int _terrainRevision;
+	bool _smoky;
+	/// Finds the tiles where the terrain, the smoke or the units changed since the last update.
+	void findChanges(std::vector<Position> *changed);
+	static void traceJob(void *map, int index, int thread);
+	/// Gets what the threat map sees of a unit standing on a tile.
+	static int getOccupantState(BattleUnit *unit);
+	void trace(Watcher &watcher);
+	int smokeDecay(const std::vector<Position> &trajectory, const Position &origin) const;
+	void count(const Watcher &watcher, int change);
+public:
+	/// Creates an empty threat map.
+	ThreatMap(SavedBattleGame *save, TileEngine *engine, UnitFaction faction);
+	/// Cleans up the threat map.
+	~ThreatMap();
+	/// Brings the threat map up to date with the units and the terrain.
+	bool update();
+	/// Forgets everything, so the next update traces every unit again.
+	void invalidate();
+	/// Gets the number of units threatening a tile.
+	int getThreat(const Position &pos) const;
+	/// Gets the units threatening a tile.
+	void getThreats(const Position &pos, std::vector<BattleUnit*> *units) const;
+};
+
+}
+
+#endif
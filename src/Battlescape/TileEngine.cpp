@@ -19,13 +19,16 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include <climits>
-#include <set>
+#include <algorithm>
+#include <queue>
+#include <iterator>
 #include "TileEngine.h"
 #include <SDL.h>
 #include "BattleAIState.h"
 #include "AggroBAIState.h"
 #include "../Savegame/SavedBattleGame.h"
 #include "../Savegame/Tile.h"
+#include "../Savegame/TileArena.h"
 #include "../Savegame/BattleUnit.h"
 #include "../Savegame/Soldier.h"
 #include "../Engine/RNG.h"
@@ -39,6 +42,34 @@
 #include "Pathfinding.h"
 #include "../Engine/Options.h"
 #include "../Engine/Logger.h"
+#include "../Engine/ThreadPool.h"
+#include "ThreatMap.h"
+#include "../Engine/CrossPlatform.h"
+
+namespace
+{
+/// Sines and cosines of the explosion ray angles: every 5 degrees from straight down to straight up, and every 3 degrees around.
+struct ExplosionDirections
+{
+	double sinFi[37], cosFi[37], sinTe[121], cosTe[121];
+	ExplosionDirections()
+	{
+		for (int i = 0; i < 37; ++i)
+		{
+			int fi = -90 + i * 5;
+			sinFi[i] = sin(fi * M_PI / 180.0);
+			cosFi[i] = cos(fi * M_PI / 180.0);
+		}
+		for (int i = 0; i < 121; ++i)
+		{
+			int te = i * 3;
+			sinTe[i] = sin(te * M_PI / 180.0);
+			cosTe[i] = cos(te * M_PI / 180.0);
+		}
+	}
+};
+const ExplosionDirections explosionDirections;
+}
 
 namespace OpenXcom
 {
@@ -49,8 +80,12 @@ const int TileEngine::heightFromCenter[11] = {0,-2,+2,-4,+4,-6,+6,-8,+8,-12,+12}
  * Sets up a TileEngine.
  * @param save pointer to SavedBattleGame object.
  */
-TileEngine::TileEngine(SavedBattleGame *save, std::vector<Uint16> *voxelData) : _save(save), _voxelData(voxelData), _personalLighting(true)
+TileEngine::TileEngine(SavedBattleGame *save, std::vector<Uint16> *voxelData) : _save(save), _voxelData(voxelData), _fovTraces(1), _fovScratch(1), _fovUnits(0), _threadPool(0), _surveySide(FACTION_HOSTILE), _personalLighting(true)
 {
+	for (int i = 0; i < 3; ++i)
+	{
+		_threatMaps[i] = 0;
+	}
 }
 
 /**
@@ -58,9 +93,163 @@ TileEngine::TileEngine(SavedBattleGame *save, std::vector<Uint16> *voxelData) :
  */
 TileEngine::~TileEngine()
 {
+	for (int i = 0; i < 3; ++i)
+	{
+		delete _threatMaps[i];
+	}
+	delete _threadPool;
+}
+
+/**
+ * Gets the worker threads used for batch calculations, starting them the first time.
+ * @return Pointer to the thread pool.
+ */
+ThreadPool *TileEngine::getThreadPool()
+{
+	if (_threadPool == 0)
+	{
+		int threads = Options::getInt("battleThreads");
+		if (threads <= 0)
+		{
+			threads = CrossPlatform::getProcessorCount();
+		}
+		_threadPool = new ThreadPool(threads);
+	}
+	return _threadPool;
+}
+
+/**
+ * Gets the map of the tiles the units of a faction can see or shoot at, creating it the first time.
+ * It's only brought up to date when asked to, which the AI does with updateThreatSurvey
+ * at the start of its turn and before every action.
+ * @param faction The faction whose units make the threat.
+ * @return Pointer to the threat map.
+ */
+ThreatMap *TileEngine::getThreatMap(UnitFaction faction)
+{
+	if (_threatMaps[faction] == 0)
+	{
+		_threatMaps[faction] = new ThreatMap(_save, this, faction);
+	}
+	return _threatMaps[faction];
+}
+
+/**
+ * Forgets every threat map worked out so far, after the map was generated again.
+ */
+void TileEngine::invalidateThreatMaps()
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		if (_threatMaps[i] != 0)
+		{
+			_threatMaps[i]->invalidate();
+		}
+	}
+}
 
+/**
+ * Gets the faction whose units threaten a faction: the aliens for the player and
+ * the civilians, and the player's units for the aliens.
+ * @param faction The threatened faction.
+ * @return The threatening faction.
+ */
+UnitFaction TileEngine::getOpponents(UnitFaction faction)
+{
+	return faction == FACTION_HOSTILE ? FACTION_PLAYER : FACTION_HOSTILE;
 }
 
+/**
+ * Brings the threat map of a side's opponents up to date with the units that moved, went down
+ * or had their view change since it was last updated, and drops what surveyXComThreatToTile
+ * worked out for the tiles if any threat changed or another side is asking now, so the AI
+ * doesn't pick cover from stale lines of fire.
+ * @param side The side the AI is playing.
+ * @param newTurn True at the start of the AI's turn, when the survey is dropped anyway.
+ */
+void TileEngine::updateThreatSurvey(UnitFaction side, bool newTurn)
+{
+	if (!getThreatMap(getOpponents(side))->update() && !newTurn && side == _surveySide)
+		return;
+
+	_surveySide = side;
+
+	Tile **tiles = _save->getTiles();
+	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
+	{
+		tiles[i]->soldiersVisible = -1; // -1 for "not calculated"; actual calculations will take place as needed
+		tiles[i]->closestSoldierDSqr = -1; // for most of the tiles most of the time, this data is not needed
+	}
+}
+
+/**
+ * Gets the merged terrain voxels of a tile, caching them first if the tile changed since.
+ * Tiles made of the same parts with the same ufo doors open share one shape.
+ * @param tile The tile.
+ * @return The tile's voxel shape.
+ */
+const TileEngine::VoxelShape &TileEngine::getVoxelShape(Tile *tile)
+{
+	if (tile->getVoxelShape() != -1)
+	{
+		return _voxelShapes[tile->getVoxelShape()];
+	}
+
+	std::vector<int> key(4*12, -1);
+	for (int i = 0; i < 4; ++i)
+	{
+		MapData *mp = tile->getMapData(i);
+		if (mp != 0 && !tile->isUfoDoorOpen(i))
+		{
+			for (int slice = 0; slice < 12; ++slice)
+			{
+				key[i*12 + slice] = mp->getLoftID(slice);
+			}
+		}
+	}
+
+	std::map<std::vector<int>, int>::iterator found = _voxelShapeIndex.find(key);
+	if (found == _voxelShapeIndex.end())
+	{
+		VoxelShape shape;
+		shape.empty = true;
+		for (int slice = 0; slice < 12; ++slice)
+		{
+			for (int y = 0; y < 16; ++y)
+			{
+				shape.rows[slice][y] = 0;
+				for (int i = 0; i < 4; ++i)
+				{
+					shape.loft[i][slice] = key[i*12 + slice];
+					if (shape.loft[i][slice] != -1)
+					{
+						shape.rows[slice][y] |= _voxelData->at(shape.loft[i][slice]*16 + y);
+					}
+				}
+				if (shape.rows[slice][y])
+				{
+					shape.empty = false;
+				}
+			}
+		}
+		found = _voxelShapeIndex.insert(std::make_pair(key, (int)_voxelShapes.size())).first;
+		_voxelShapes.push_back(shape);
+	}
+	tile->setVoxelShape(found->second);
+	return _voxelShapes[found->second];
+}
+
+/**
+ * Caches the merged terrain voxels of every tile that changed since the last time.
+ * This has to be done before tracing on several threads, which only read the cache.
+ */
+void TileEngine::calculateVoxelShapes()
+{
+	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
+	{
+		getVoxelShape(_save->getTiles()[i]);
+	}
+}
 
 /**
   * Calculate sun shading for the whole terrain.
@@ -69,9 +258,9 @@ void TileEngine::calculateSunShading()
 {
 	const int layer = 0; // Ambient lighting layer.
 
+	_save->getTileArena()->resetLight(layer);
 	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
 	{
-		_save->getTiles()[i]->resetLight(layer);
 		calculateSunShading(_save->getTiles()[i]);
 	}
 }
@@ -105,44 +294,41 @@ void TileEngine::calculateTerrainLighting()
 {
 	const int layer = 1; // Static lighting layer.
 	const int fireLightPower = 15; // amount of light a fire generates
-
-	// reset all light to 0 first
-	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
-	{
-		_save->getTiles()[i]->resetLight(layer);
-	}
+	std::vector<LightSource> sources;
 
 	// add lighting of terrain
 	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
 	{
+		Tile *tile = _save->getTiles()[i];
 		// only floors and objects can light up
-		if (_save->getTiles()[i]->getMapData(MapData::O_FLOOR)
-			&& _save->getTiles()[i]->getMapData(MapData::O_FLOOR)->getLightSource())
+		if (tile->getMapData(MapData::O_FLOOR)
+			&& tile->getMapData(MapData::O_FLOOR)->getLightSource())
 		{
-			addLight(_save->getTiles()[i]->getPosition(), _save->getTiles()[i]->getMapData(MapData::O_FLOOR)->getLightSource(), layer);
+			sources.push_back(LightSource(tile->getPosition(), tile->getMapData(MapData::O_FLOOR)->getLightSource()));
 		}
-		if (_save->getTiles()[i]->getMapData(MapData::O_OBJECT)
-			&& _save->getTiles()[i]->getMapData(MapData::O_OBJECT)->getLightSource())
+		if (tile->getMapData(MapData::O_OBJECT)
+			&& tile->getMapData(MapData::O_OBJECT)->getLightSource())
 		{
-			addLight(_save->getTiles()[i]->getPosition(), _save->getTiles()[i]->getMapData(MapData::O_OBJECT)->getLightSource(), layer);
+			sources.push_back(LightSource(tile->getPosition(), tile->getMapData(MapData::O_OBJECT)->getLightSource()));
 		}
 
 		// fires
-		if (_save->getTiles()[i]->getFire())
+		if (tile->getFire())
 		{
-			addLight(_save->getTiles()[i]->getPosition(), fireLightPower, layer);
+			sources.push_back(LightSource(tile->getPosition(), fireLightPower));
 		}
 
-		for (std::vector<BattleItem*>::iterator it = _save->getTiles()[i]->getInventory()->begin(); it != _save->getTiles()[i]->getInventory()->end(); ++it)
+		for (std::vector<BattleItem*>::iterator it = tile->getInventory()->begin(); it != tile->getInventory()->end(); ++it)
 		{
 			if ((*it)->getRules()->getBattleType() == BT_FLARE)
 			{
-				addLight(_save->getTiles()[i]->getPosition(), (*it)->getRules()->getPower(), layer);
+				sources.push_back(LightSource(tile->getPosition(), (*it)->getRules()->getPower()));
 			}
 		}
 
 	}
 
+	updateLighting(sources, layer);
 }
 
 /**
@@ -152,12 +338,7 @@ void TileEngine::calculateUnitLighting()
 {
 	const int layer = 2; // Dynamic lighting layer.
 	const int personalLightPower = 15; // amount of light a unit generates
-
-	// reset all light to 0 first
-	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
-	{
-		_save->getTiles()[i]->resetLight(layer);
-	}
+	std::vector<LightSource> sources;
 
 	if (_personalLighting)
 	{
@@ -166,40 +347,111 @@ void TileEngine::calculateUnitLighting()
 		{
 			if ((*i)->getFaction() == FACTION_PLAYER && !(*i)->isOut())
 			{
-				addLight((*i)->getPosition(), personalLightPower, layer);
+				sources.push_back(LightSource((*i)->getPosition(), personalLightPower));
 			}
 		}
 	}
+
+	updateLighting(sources, layer);
 }
 
 /**
- * Adds circular light pattern starting from center and loosing power with distance travelled.
- * @param center
- * @param power
+ * Brings a light layer up to date with a new set of light sources.
+ * Only the light of sources that went away, moved or changed power is taken off the map, by clearing
+ * the square they lit and adding back whatever other sources reach into it; new sources are simply added.
+ * Light goes through walls, so changes to the terrain never need more than that.
+ * @param sources The light sources now on the map.
  * @param layer Light is seperated in 3 layers: Ambient, Static and Dynamic.
  */
-void TileEngine::addLight(const Position &center, int power, int layer)
+void TileEngine::updateLighting(std::vector<LightSource> &sources, int layer)
 {
-	// only loop through the positive quadrant.
-	for (int x = 0; x <= power; ++x)
+	LightLayer &lit = _lightLayers[layer];
+	std::sort(sources.begin(), sources.end());
+
+	// a new map has nothing lit yet
+	if (!lit.valid)
 	{
-		for (int y = 0; y <= power; ++y)
+		_save->getTileArena()->resetLight(layer);
+		for (std::vector<LightSource>::const_iterator i = sources.begin(); i != sources.end(); ++i)
 		{
-			for (int z = 0; z < _save->getMapSizeZ(); z++)
-			{
-				int distance = int(floor(sqrt(float(x*x + y*y)) + 0.5));
+			addLight(*i, layer, 0, 0, _save->getMapSizeX() - 1, _save->getMapSizeY() - 1);
+		}
+		lit.valid = true;
+		lit.sources.swap(sources);
+		return;
+	}
 
-				if (_save->getTile(Position(center.x + x,center.y + y, z)))
-					_save->getTile(Position(center.x + x,center.y + y, z))->addLight(power - distance, layer);
+	std::vector<LightSource> removed, added;
+	std::set_difference(lit.sources.begin(), lit.sources.end(), sources.begin(), sources.end(), std::back_inserter(removed));
+	std::set_difference(sources.begin(), sources.end(), lit.sources.begin(), lit.sources.end(), std::back_inserter(added));
 
-				if (_save->getTile(Position(center.x - x,center.y - y, z)))
-					_save->getTile(Position(center.x - x,center.y - y, z))->addLight(power - distance, layer);
+	for (std::vector<LightSource>::const_iterator i = removed.begin(); i != removed.end(); ++i)
+	{
+		int minX = std::max(i->x - i->power, 0);
+		int minY = std::max(i->y - i->power, 0);
+		int maxX = std::min(i->x + i->power, _save->getMapSizeX() - 1);
+		int maxY = std::min(i->y + i->power, _save->getMapSizeY() - 1);
+		for (int z = 0; z < _save->getMapSizeZ(); ++z)
+		{
+			for (int y = minY; y <= maxY; ++y)
+			{
+				for (int x = minX; x <= maxX; ++x)
+				{
+					_save->getTile(Position(x, y, z))->resetLight(layer);
+				}
+			}
+		}
+		for (std::vector<LightSource>::const_iterator j = sources.begin(); j != sources.end(); ++j)
+		{
+			if (j->x + j->power >= minX && j->x - j->power <= maxX && j->y + j->power >= minY && j->y - j->power <= maxY)
+			{
+				addLight(*j, layer, minX, minY, maxX, maxY);
+			}
+		}
+	}
+	for (std::vector<LightSource>::const_iterator i = added.begin(); i != added.end(); ++i)
+	{
+		addLight(*i, layer, 0, 0, _save->getMapSizeX() - 1, _save->getMapSizeY() - 1);
+	}
+
+	lit.sources.swap(sources);
+}
 
-				if (_save->getTile(Position(center.x - x,center.y + y, z)))
-					_save->getTile(Position(center.x - x,center.y + y, z))->addLight(power - distance, layer);
+/**
+ * Forgets the light sources of every layer, for when the tiles they lit are gone.
+ */
+void TileEngine::invalidateLighting()
+{
+	for (int layer = 0; layer < 3; ++layer)
+	{
+		_lightLayers[layer].valid = false;
+	}
+}
 
-				if (_save->getTile(Position(center.x + x,center.y - y, z)))
-					_save->getTile(Position(center.x + x,center.y - y, z))->addLight(power - distance, layer);
+/**
+ * Adds circular light pattern starting from center and loosing power with distance travelled.
+ * Only the tiles inside the given rectangle get lit, on every level.
+ * @param light The light source.
+ * @param layer Light is seperated in 3 layers: Ambient, Static and Dynamic.
+ * @param minX Left edge of the rectangle.
+ * @param minY Top edge of the rectangle.
+ * @param maxX Right edge of the rectangle.
+ * @param maxY Bottom edge of the rectangle.
+ */
+void TileEngine::addLight(const LightSource &light, int layer, int minX, int minY, int maxX, int maxY)
+{
+	minX = std::max(minX, light.x - light.power);
+	minY = std::max(minY, light.y - light.power);
+	maxX = std::min(maxX, light.x + light.power);
+	maxY = std::min(maxY, light.y + light.power);
+	for (int y = minY; y <= maxY; ++y)
+	{
+		for (int x = minX; x <= maxX; ++x)
+		{
+			int distance = int(floor(sqrt(float((x - light.x)*(x - light.x) + (y - light.y)*(y - light.y))) + 0.5));
+			for (int z = 0; z < _save->getMapSizeZ(); z++)
+			{
+				_save->getTile(Position(x, y, z))->addLight(light.power - distance, layer);
 			}
 		}
 	}
@@ -222,40 +474,155 @@ static size_t BattleUnitsChecksum(std::vector<BattleUnit*>& units)
  */
 bool TileEngine::calculateFOV(BattleUnit *unit)
 {
-	size_t visibleUnitsChecksum = 0, oldNumVisibleUnits = 0;
-	Position center = unit->getPosition();
-	Position test;
-	int direction;
-	bool swap;
-	std::vector<Position> _trajectory;
-	if (_save->getStrafeSetting() && (unit->getTurretType() > -1)) {
-		direction = unit->getTurretDirection();
+	prepareFOV(unit, _fovTraces[0]);
+	traceFOV(unit, _fovTraces[0], _fovScratch[0]);
+	return applyFOV(unit, _fovTraces[0]);
+}
+
+/**
+ * Calculates line of sight of a number of soldiers at once, split between the worker threads.
+ * The results are applied one unit after another in the order given, so the outcome
+ * is the same as calculating them one by one, however many threads there are.
+ * @param units Units to calculate the line of sight of.
+ */
+void TileEngine::calculateFOV(const std::vector<BattleUnit*> &units)
+{
+	if (units.empty())
+	{
+		return;
 	}
-	else
+	if (_fovTraces.size() < units.size())
 	{
-		direction = unit->getDirection();
+		_fovTraces.resize(units.size());
+	}
+	for (size_t i = 0; i < units.size(); ++i)
+	{
+		prepareFOV(units[i], _fovTraces[i]);
 	}
-	swap = (direction==0 || direction==4);
-	int signX[8] = { +1, +1, +1, +1, -1, -1, -1, -1 };
-	int signY[8] = { -1, -1, -1, +1, +1, +1, -1, -1 };
-	int y1, y2;
-
-	// calculate a visible units checksum - if it changed during this step, the soldier stops walking
-	visibleUnitsChecksum = BattleUnitsChecksum(*(unit->getVisibleUnits()));	
 
-	oldNumVisibleUnits = unit->getVisibleUnits()->size();
+	ThreadPool *pool = getThreadPool();
+	if (_fovScratch.size() < (size_t)pool->getThreads())
+	{
+		_fovScratch.resize(pool->getThreads());
+	}
+	calculateVoxelShapes();
+	_fovUnits = &units;
+	pool->run(traceFOVJob, this, units.size());
+	_fovUnits = 0;
 
-	unit->clearVisibleUnits();
-	unit->clearVisibleTiles();
+	for (size_t i = 0; i < units.size(); ++i)
+	{
+		applyFOV(units[i], _fovTraces[i]);
+	}
+}
 
+/**
+ * Works out what a unit is going to look at, and gets everything tracing it needs ready,
+ * so the trace itself doesn't have to change anything shared.
+ * @param unit The unit looking.
+ * @param trace Where to keep the view.
+ */
+void TileEngine::prepareFOV(BattleUnit *unit, FOVTrace &trace)
+{
+	trace.fans.clear();
 	if (unit->isOut())
-		return false;
+		return;
+
+	if (_save->getStrafeSetting() && (unit->getTurretType() > -1)) {
+		trace.direction = unit->getTurretDirection();
+	}
+	else
+	{
+		trace.direction = unit->getDirection();
+	}
 	Position pos = unit->getPosition();
 
 	if ((unit->getHeight() + unit->getFloatHeight() + -_save->getTile(unit->getPosition())->getTerrainLevel()) >= 24 + 4)
 	{
 		++pos.z;
 	}
+	trace.eye = pos;
+	int size = unit->getArmor()->getSize();
+
+	// terrain line of sight only depends on the eye position and the terrain itself,
+	// so a view already traced from this position doesn't need to be traced again until some of it changes
+	if (unit->getFaction() == FACTION_PLAYER)
+	{
+		ViewCache *cache = &_viewCache[unit];
+		if (cache->origin != pos || cache->size != size)
+		{
+			cache->origin = pos;
+			cache->size = size;
+			cache->directions = 0;
+		}
+		if (!(cache->directions & (1 << trace.direction)))
+		{
+			cache->directions |= 1 << trace.direction;
+			// large units have "4 pair of eyes"
+			for (int xo = 0; xo < size; xo++)
+			{
+				for (int yo = 0; yo < size; yo++)
+				{
+					trace.fans.push_back(&getRayFan(trace.direction, xo, yo, pos.z));
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Runs the line of sight trace of one unit of a batch.
+ * @param engine Pointer to the tile engine.
+ * @param index Index of the unit in the batch.
+ * @param thread Number of the thread running the trace.
+ */
+void TileEngine::traceFOVJob(void *engine, int index, int thread)
+{
+	TileEngine *self = (TileEngine*)engine;
+	self->traceFOV(self->_fovUnits->at(index), self->_fovTraces[index], self->_fovScratch[thread]);
+}
+
+/**
+ * Traces the terrain and units a unit sees. This only reads the battlescape,
+ * so several units can be traced at the same time.
+ * @param unit The unit looking.
+ * @param trace The view to trace, as prepared by prepareFOV.
+ * @param scratch Scratch space of the thread doing the tracing.
+ */
+void TileEngine::traceFOV(BattleUnit *unit, FOVTrace &trace, FOVScratch &scratch)
+{
+	trace.tiles.clear();
+	trace.units.clear();
+	if (unit->isOut())
+		return;
+
+	if (!trace.fans.empty())
+	{
+		if (scratch.marks.size() != (size_t)_save->getMapSizeXYZ() || scratch.stamp == INT_MAX)
+		{
+			scratch.marks.assign(_save->getMapSizeXYZ(), 0);
+			scratch.stamp = 0;
+		}
+		++scratch.stamp;
+		// this sets tiles to discovered if they are in LOS - tile visibility is not calculated in voxelspace but in tilespace
+		int size = unit->getArmor()->getSize();
+		for (int xo = 0; xo < size; xo++)
+		{
+			for (int yo = 0; yo < size; yo++)
+			{
+				traceRayFan(trace.eye + Position(xo, yo, 0), *trace.fans[xo * size + yo], scratch, trace.tiles);
+			}
+		}
+	}
+
+	Position center = unit->getPosition();
+	Position test;
+	int direction = trace.direction;
+	bool swap = (direction==0 || direction==4);
+	int signX[8] = { +1, +1, +1, +1, -1, -1, -1, -1 };
+	int signY[8] = { -1, -1, -1, +1, +1, +1, -1, -1 };
+	int y1, y2;
+
 	for (int x = 0; x <= MAX_VIEW_DISTANCE; ++x)
 	{
 		if (direction%2)
@@ -283,64 +650,68 @@ bool TileEngine::calculateFOV(BattleUnit *unit)
 						BattleUnit *visibleUnit = _save->getTile(test)->getUnit();
 						if (visibleUnit && !visibleUnit->isOut() && visible(unit, _save->getTile(test)))
 						{
-							if ((visibleUnit->getFaction() == FACTION_HOSTILE && unit->getFaction() != FACTION_HOSTILE)
-								|| (visibleUnit->getFaction() != FACTION_HOSTILE && unit->getFaction() == FACTION_HOSTILE))
-							{
-								unit->addToVisibleUnits(visibleUnit);
-								unit->addToVisibleTiles(visibleUnit->getTile());
-								if (unit->getFaction() == FACTION_PLAYER)
-								{
-								//	visibleUnit->getTile()->setDiscovered(true, 2);
-									visibleUnit->getTile()->setVisible(+1);
-								}
-							}
-							if (unit->getFaction() == FACTION_PLAYER)
-							{
-								visibleUnit->setVisible(true);
-							}
-							else if (unit->getFaction() == FACTION_HOSTILE && visibleUnit->getFaction() == FACTION_PLAYER && unit->getIntelligence() > visibleUnit->getTurnsExposed())
-							{
-								visibleUnit->setTurnsExposed(unit->getIntelligence());
-								_save->updateExposedUnits();
-							}
-						}
-
-						if (unit->getFaction() == FACTION_PLAYER)
-						{
-							// this sets tiles to discovered if they are in LOS - tile visibility is not calculated in voxelspace but in tilespace
-							// large units have "4 pair of eyes"
-							int size = unit->getArmor()->getSize();
-							for (int xo = 0; xo < size; xo++)
-							{
-								for (int yo = 0; yo < size; yo++)
-								{
-									Position poso = pos + Position(xo,yo,0);
-									_trajectory.clear();
-									int tst = calculateLine(poso, test, true, &_trajectory, unit, false);
-									unsigned int tsize = _trajectory.size();
-									if (tst>127) --tsize; //last tile is blocked thus must be cropped
-									for (unsigned int i = 0; i < tsize; i++)
-									{
-										Position posi = _trajectory.at(i); 
-										//mark every tile of line as visible (as in original)
-										//this is needed because of bresenham narrow stroke. 
-										_save->getTile(posi)->setVisible(+1);
-										_save->getTile(posi)->setDiscovered(true, 2);
-										// walls to the east or south of a visible tile, we see that too
-										Tile* t = _save->getTile(Position(posi.x + 1, posi.y, posi.z));
-										if (t) t->setDiscovered(true, 0);
-										t = _save->getTile(Position(posi.x, posi.y + 1, posi.z));
-										if (t) t->setDiscovered(true, 1);
-									}
-
-								}
-							}
+							trace.units.push_back(visibleUnit);
 						}
 					}
 				}
 			}
 		}
 	}
+}
+
+/**
+ * Applies a traced line of sight to the unit and the battlescape.
+ * @param unit The unit looking.
+ * @param trace The view traced by traceFOV.
+ * @return true when new aliens spotted
+ */
+bool TileEngine::applyFOV(BattleUnit *unit, const FOVTrace &trace)
+{
+	size_t visibleUnitsChecksum = 0, oldNumVisibleUnits = 0;
+
+	// calculate a visible units checksum - if it changed during this step, the soldier stops walking
+	visibleUnitsChecksum = BattleUnitsChecksum(*(unit->getVisibleUnits()));	
+
+	oldNumVisibleUnits = unit->getVisibleUnits()->size();
+
+	unit->clearVisibleUnits();
+
+	if (unit->isOut())
+		return false;
+
+	for (std::vector<Tile*>::const_iterator i = trace.tiles.begin(); i != trace.tiles.end(); ++i)
+	{
+		Position posi = (*i)->getPosition();
+		//mark every tile of line as visible (as in original)
+		//this is needed because of bresenham narrow stroke. 
+		_save->setTileVisible(unit->getFaction(), *i);
+		_save->setTileDiscovered(*i, true, 2);
+		// walls to the east or south of a visible tile, we see that too
+		Tile* t = _save->getTile(Position(posi.x + 1, posi.y, posi.z));
+		if (t) _save->setTileDiscovered(t, true, 0);
+		t = _save->getTile(Position(posi.x, posi.y + 1, posi.z));
+		if (t) _save->setTileDiscovered(t, true, 1);
+	}
+
+	for (std::vector<BattleUnit*>::const_iterator i = trace.units.begin(); i != trace.units.end(); ++i)
+	{
+		BattleUnit *visibleUnit = *i;
+		if ((visibleUnit->getFaction() == FACTION_HOSTILE && unit->getFaction() != FACTION_HOSTILE)
+			|| (visibleUnit->getFaction() != FACTION_HOSTILE && unit->getFaction() == FACTION_HOSTILE))
+		{
+			unit->addToVisibleUnits(visibleUnit);
+			_save->setTileVisible(unit->getFaction(), visibleUnit->getTile());
+		}
+		if (unit->getFaction() == FACTION_PLAYER)
+		{
+			visibleUnit->setVisible(true);
+		}
+		else if (unit->getFaction() == FACTION_HOSTILE && visibleUnit->getFaction() == FACTION_PLAYER && unit->getIntelligence() > visibleUnit->getTurnsExposed())
+		{
+			visibleUnit->setTurnsExposed(unit->getIntelligence());
+			_save->updateExposedUnits();
+		}
+	}
 
 	size_t newChecksum = BattleUnitsChecksum(*(unit->getVisibleUnits()));
 
@@ -361,140 +732,201 @@ bool TileEngine::calculateFOV(BattleUnit *unit)
 			}
 			aggro->setAggroTarget(unit->getVisibleUnits()->at(0)); // just pick the first one - maybe we need to prioritize on distance to unit or other parameters?
 		}
-
-		return true;
+
+		return true;
+	}
+
+	return false;
+
+}
+
+/**
+ * Gets the fan of tile-space rays from an eye to every tile it can see when looking in a direction.
+ * The rays are the same Bresenham lines calculateLine walks, merged into a tree where they share their first tiles,
+ * so each tile near the eye only gets traced once instead of once per tile behind it.
+ * Fans only depend on the direction, the eye's offset within a large unit and the height of the eye, so they are built once and kept.
+ * @param direction Direction the unit is looking in.
+ * @param eyeX X offset of the eye from the unit's position.
+ * @param eyeY Y offset of the eye from the unit's position.
+ * @param eyeZ Level the eye is on.
+ * @return The ray fan.
+ */
+const TileEngine::RayFan &TileEngine::getRayFan(int direction, int eyeX, int eyeY, int eyeZ)
+{
+	int key = (((_save->getMapSizeZ() * 256 + eyeZ) * 8 + direction) * 2 + eyeX) * 2 + eyeY;
+	std::map<int, RayFan>::iterator found = _rayFans.find(key);
+	if (found != _rayFans.end())
+	{
+		return found->second;
+	}
+
+	RayFan &fan = _rayFans[key];
+	bool swap = (direction==0 || direction==4);
+	int signX[8] = { +1, +1, +1, +1, -1, -1, -1, -1 };
+	int signY[8] = { -1, -1, -1, +1, +1, +1, -1, -1 };
+	int y1, y2;
+	// the lines are traced below the map, where nothing blocks them
+	Position eye(0, 0, -2 * _save->getMapSizeZ());
+	std::vector<Position> trajectory;
+	std::map<std::pair<int, int>, int> children;
+
+	fan.parent.push_back(-1);
+	fan.offset.push_back(Position(0, 0, 0));
+	fan.target.push_back(false);
+	// same tiles, in the same order, as calculateFOV checks for units
+	for (int x = 0; x <= MAX_VIEW_DISTANCE; ++x)
+	{
+		if (direction%2)
+		{
+			y1 = 0;
+			y2 = MAX_VIEW_DISTANCE;
+		}
+		else
+		{
+			y1 = -x;
+			y2 = x;
+		}
+		for (int y = y1; y <= y2; ++y)
+		{
+			for (int z = 0; z < _save->getMapSizeZ(); z++)
+			{
+				int distance = int(floor(sqrt(float(x*x + y*y)) + 0.5));
+				if (distance <= MAX_VIEW_DISTANCE)
+				{
+					Position test = eye + Position(signX[direction]*(swap?y:x) - eyeX, signY[direction]*(swap?x:y) - eyeY, z - eyeZ);
+					trajectory.clear();
+					calculateLine(eye, test, true, &trajectory, 0, false);
+					int node = 0;
+					for (std::vector<Position>::const_iterator i = trajectory.begin() + 1; i != trajectory.end(); ++i)
+					{
+						Position offset = *i - eye;
+						std::pair<int, int> step = std::make_pair(node, ((offset.x + 64) * 128 + offset.y + 64) * 128 + offset.z + 64);
+						std::map<std::pair<int, int>, int>::iterator child = children.find(step);
+						if (child == children.end())
+						{
+							child = children.insert(std::make_pair(step, (int)fan.parent.size())).first;
+							fan.parent.push_back(node);
+							fan.offset.push_back(offset);
+							fan.target.push_back(false);
+						}
+						node = child->second;
+					}
+					fan.target[node] = true;
+				}
+			}
+		}
 	}
-
-	return false;
-
+	return fan;
 }
 
-
-
-bool TileEngine::surveyXComThreatToTile(Tile *tile, Position &tilePos, BattleUnit *queryingUnit)
+/**
+ * Collects the tiles an eye can see along a ray fan.
+ * A ray stops at the first step that is blocked, the same way calculateLine crops a blocked line.
+ * @param eye Position of the eye.
+ * @param fan Ray fan to trace.
+ * @param scratch Scratch space of the thread doing the tracing.
+ * @param tiles Tiles seen, each only once per trace.
+ */
+void TileEngine::traceRayFan(const Position &eye, const RayFan &fan, FOVScratch &scratch, std::vector<Tile*> &tiles)
 {
-	if (tile->soldiersVisible != -1) return true; // already calculated this turn
+	int nodes = fan.parent.size();
+	std::vector<char> &rays = scratch.rays;
+	rays.assign(nodes, 0);
 
-	//BattleUnit *hypotheticalUnit = new BattleUnit(*queryingUnit); // dangerous :/
-	
-	//BattleUnit dummyUnit(queryingUnit->getUnitRules(), FACTION_HOSTILE, queryingUnit->getId()*2, queryingUnit->getArmor());
-	//dummyUnit.setTile(queryingUnit->getTile());
-	//dummyUnit.setPosition(queryingUnit->getPosition());
-	BattleUnit dummyUnit(*queryingUnit);
-	BattleUnit *hypotheticalUnit = &dummyUnit;
-	
-	//BattleUnit unitBackup = *hypotheticalUnit;
-		
-	if (!_save->setUnitPosition(hypotheticalUnit, tilePos, true)) 
+	// only rays leading to a tile on the map are traced
+	for (int i = nodes - 1; i >= 0; --i)
 	{
-		//hypotheticalUnit->invalidateCache();
-		//delete hypotheticalUnit;
-		return false;
+		if (!rays[i] && fan.target[i] && _save->getTile(eye + fan.offset[i]))
+		{
+			rays[i] = 1;
+		}
+		if (rays[i] && i > 0)
+		{
+			rays[fan.parent[i]] = 1;
+		}
 	}
-	
-	std::map<int, BattleUnit*> originalTileUnits;
-	std::vector<Position> toBackUp;
-	
-	toBackUp.push_back(hypotheticalUnit->getPosition());
-	toBackUp.push_back(hypotheticalUnit->getTile()->getPosition()); // no such thing as too many backups??? .__.
-	toBackUp.push_back(hypotheticalUnit->getLastPosition());
-	toBackUp.push_back(tilePos);
-	
-	// back up BattleUnit pointers in tile data
-	for (std::vector<Position>::iterator which = toBackUp.begin(); which != toBackUp.end(); ++which)
+
+	// parents always come before their children, so one pass walks every ray outwards
+	for (int i = 0; i < nodes; ++i)
 	{
-		for (int x = hypotheticalUnit->getArmor()->getSize()-1; x >= 0; x--)
+		if (!rays[i])
+		{
+			continue;
+		}
+		Position posi = eye + fan.offset[i];
+		Tile *tile = _save->getTile(posi);
+		if (i > 0)
 		{
-			for (int y = hypotheticalUnit->getArmor()->getSize()-1; y >= 0; y--)
+			int parent = fan.parent[i];
+			Tile *previous = _save->getTile(eye + fan.offset[parent]);
+			if (!rays[parent] || horizontalBlockage(previous, tile, DT_NONE) + verticalBlockage(previous, tile, DT_NONE) > 127)
 			{
-				Position pos = *which;
-				pos.x += x;
-				pos.y += y;
-				
-				Tile *tileToSave = _save->getTile(pos);
-				if (!tileToSave) continue; // out of map bounds?
-				
-				int index = _save->getTileIndex(pos);				
-				originalTileUnits[index] = tileToSave->getUnit();
+				rays[i] = 0;
+				continue;
 			}
 		}
+		if (!tile || scratch.marks[_save->getTileIndex(posi)] == scratch.stamp)
+		{
+			continue;
+		}
+		scratch.marks[_save->getTileIndex(posi)] = scratch.stamp;
+		tiles.push_back(tile);
 	}
+}
 
+/**
+ * Works out for the AI how exposed a tile is to the units of the other side, using the threat map.
+ * The results are kept in the tile's scratch variables until the AI resets them next turn.
+ * @param tile The tile.
+ * @param tilePos Position of the tile.
+ * @param queryingUnit The unit that would stand on the tile.
+ * @return False if the unit can't stand on the tile.
+ */
+bool TileEngine::surveyXComThreatToTile(Tile *tile, Position &tilePos, BattleUnit *queryingUnit)
+{
+	if (tile->soldiersVisible != -1) return true; // already calculated this turn
 
-#if 0
-	for (int x = hypotheticalUnit->getArmor()->getSize()-1; x >= 0; x--)
+	if (!_save->setUnitPosition(queryingUnit, tilePos, true))
 	{
-		for (int y = hypotheticalUnit->getArmor()->getSize()-1; y >= 0; y--)
-		{
-			Position pos = hypotheticalUnit->getPosition();
-			pos.x += x;
-			pos.y += y;
-
-			Tile *zeroMe = _save->getTile(pos);
-			assert (!zeroMe || zeroMe->getUnit() == queryingUnit);
-			if (zeroMe) zeroMe->setUnit(0);
-		}
+		return false;
 	}
-#endif
-	
-	_save->setUnitPosition(hypotheticalUnit, tilePos); // updates the unit and the tiles
-	//_save->setUnitPosition(hypotheticalUnit, tilePos); // reset its lastPosition too
 
-		
 	tile->soldiersVisible = 0; // we're actually not updating the other three tiles of a 2x2 unit because the AI code is going to ignore them anyway for now
 	tile->closestSoldierDSqr = INT_MAX;
 	tile->closestAlienDSqr = INT_MAX;
 	tile->meanSoldierDSqr = INT_MAX;
-	
+
 	int dsqrTotal = 0;
-	
-	//Position targetVoxel = getSightOriginVoxel(hypotheticalUnit); // relevant if trying to use calculateLine() which doesn't seem to cooperate anyway!
-	Position targetVoxel(0,0,0);
-	
-	for (std::vector<BattleUnit*>::const_iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
+
+	std::vector<BattleUnit*> threats;
+	getThreatMap(getOpponents(queryingUnit->getFaction()))->getThreats(tilePos, &threats);
+	for (std::vector<BattleUnit*>::const_iterator i = threats.begin(); i != threats.end(); ++i)
 	{
-		if ((*i)->isOut()) continue;
-		
 		int dsqr = distanceSq(tilePos, (*i)->getPosition());
 		if (dsqr < 1) dsqr = 1; // sanity buffer
-		
-		Position originVoxel = getSightOriginVoxel(*i);
 
-		if ((*i)->getFaction() == FACTION_PLAYER && canTargetUnit(&originVoxel, tile, &targetVoxel, *i))		
-		//if ((*i)->getFaction() == FACTION_PLAYER && visible(*i, tile))
-		//if ((*i)->getFaction() == FACTION_PLAYER && canTargetTile(&originVoxel, tile, MapData::O_FLOOR, &targetVoxel, *i)) 
-		//if ((*i)->getFaction() == FACTION_PLAYER && calculateLine(originVoxel, targetVoxel, false, 0, *i, false) == 4)
-		{
-			++tile->soldiersVisible;
+		++tile->soldiersVisible;
 
-			if (dsqr < tile->closestSoldierDSqr)
-			{
-				tile->closestSoldierDSqr = dsqr;
-				tile->_closestSoldierPos = (*i)->getPosition();
-			}
-			
-			dsqrTotal += dsqr;
+		if (dsqr < tile->closestSoldierDSqr)
+		{
+			tile->closestSoldierDSqr = dsqr;
+			tile->_closestSoldierPos = (*i)->getPosition();
 		}
 
-		if ((*i)->getFaction() == FACTION_HOSTILE && dsqr < tile->closestAlienDSqr) tile->closestAlienDSqr = dsqr;
+		dsqrTotal += dsqr;
 	}
-	
-	tile->meanSoldierDSqr = tile->soldiersVisible ? (dsqrTotal / tile->soldiersVisible) : 0;
-	
-	//if (tile->_soldiersVisible == 0 && tile->getVisible()) { Log(LOG_WARNING) << "Visible tile returned !canTargetTile() for all soldiers."; }
 
-	//*hypotheticalUnit = unitBackup;
-	//hypotheticalUnit->invalidateCache();
-	
-	// restore tile data
-	for (std::map<int,BattleUnit*>::iterator i = originalTileUnits.begin(); i != originalTileUnits.end(); ++i)
+	for (std::vector<BattleUnit*>::const_iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
 	{
-		_save->getTiles()[i->first]->setUnit(i->second);
+		if ((*i)->isOut() || (*i)->getFaction() != queryingUnit->getFaction()) continue;
+
+		int dsqr = distanceSq(tilePos, (*i)->getPosition());
+		if (dsqr < 1) dsqr = 1;
+		if (dsqr < tile->closestAlienDSqr) tile->closestAlienDSqr = dsqr;
 	}
-	
-	//hypotheticalUnit->invalidateCache();
-	//delete hypotheticalUnit;
-	
+
+	tile->meanSoldierDSqr = tile->soldiersVisible ? (dsqrTotal / tile->soldiersVisible) : 0;
+
 	return true;
 }
 
@@ -516,6 +948,17 @@ Position TileEngine::getSightOriginVoxel(BattleUnit *currentUnit)
 
 
 
+/**
+ * Gets how far a unit can see, less the smoke on its own tile.
+ * The smoke on the tiles between it and what it looks at takes off more.
+ * @param unit The watcher.
+ * @return View distance in tiles.
+ */
+int TileEngine::getViewDistance(BattleUnit *unit) const
+{
+	return MAX_VIEW_DISTANCE - _save->getTile(unit->getPosition())->getSmoke() / 2;
+}
+
 /**
  * Check for an opposing unit on this tile
  * @param currentUnit the watcher
@@ -553,7 +996,7 @@ bool TileEngine::visible(BattleUnit *currentUnit, Tile *tile)
 		_trajectory.clear();
 		calculateLine(originVoxel, scanVoxel, true, &_trajectory, currentUnit);
 		Tile *t = _save->getTile(currentUnit->getPosition());
-		int maxViewDistance = MAX_VIEW_DISTANCE - (t->getSmoke()/2);
+		int maxViewDistance = getViewDistance(currentUnit);
 		for (unsigned int i = 0; i < _trajectory.size(); i++)
 		{
 			if (t != _save->getTile(Position(_trajectory.at(i).x/16,_trajectory.at(i).y/16, _trajectory.at(i).z/24)))
@@ -777,15 +1220,43 @@ bool TileEngine::canTargetTile(Position *originVoxel, Tile *tile, int part, Posi
  */
 void TileEngine::calculateFOV(const Position &position)
 {
+	std::vector<BattleUnit*> units;
 	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
 	{
 		if (distance(position, (*i)->getPosition()) < 20 && (*i)->getFaction() == _save->getSide())
 		{
-			calculateFOV(*i);
+			units.push_back(*i);
+		}
+	}
+	calculateFOV(units);
+}
+
+/**
+ * Forgets the terrain line of sight cached for units that can see a changed position.
+ * Call this whenever a wall, door, floor or object changes, so the next calculateFOV traces through it again.
+ * @param position Position of the changed terrain.
+ * @param radius How far from the position the terrain may have changed.
+ */
+void TileEngine::invalidateFOVCache(const Position &position, int radius)
+{
+	for (std::map<BattleUnit*, ViewCache>::iterator i = _viewCache.begin(); i != _viewCache.end(); ++i)
+	{
+		// large units look from every tile they stand on, and walls to the east and south of a traced tile get discovered too
+		if (distance(position, i->second.origin) <= MAX_VIEW_DISTANCE + radius + i->second.size + 1)
+		{
+			i->second.directions = 0;
 		}
 	}
 }
 
+/**
+ * Forgets all cached terrain line of sight.
+ */
+void TileEngine::invalidateFOVCache()
+{
+	_viewCache.clear();
+}
+
 /**
  * Checks if of the opposing faction a sniper sees this unit. The unit with the highest reaction score will be compared with the current unit's reaction score.
  * If it's higher, a shot is fired when enough time units a weapon and ammo available.
@@ -830,25 +1301,31 @@ bool TileEngine::checkReactionFire(BattleUnit *unit, BattleAction *action, Battl
 	// we reset the unit to false here - if it is seen by any unit in range below the unit becomes visible again
 	//unit->setVisible(false);
 
+	std::vector<BattleUnit*> spotters;
 	for (std::vector<BattleUnit*>::iterator i = _save->getUnits()->begin(); i != _save->getUnits()->end(); ++i)
 	{
 		if (distance(unit->getPosition(), (*i)->getPosition()) < 19 && (*i)->getFaction() != _save->getSide() && !(*i)->isOut())
 		{
-			if (recalculateFOV)
-			{
-				calculateFOV(*i);
-			}
-			for (std::vector<BattleUnit*>::iterator j = (*i)->getVisibleUnits()->begin(); j != (*i)->getVisibleUnits()->end(); ++j)
+			spotters.push_back(*i);
+		}
+	}
+	if (recalculateFOV)
+	{
+		calculateFOV(spotters);
+	}
+
+	for (std::vector<BattleUnit*>::iterator i = spotters.begin(); i != spotters.end(); ++i)
+	{
+		for (std::vector<BattleUnit*>::iterator j = (*i)->getVisibleUnits()->begin(); j != (*i)->getVisibleUnits()->end(); ++j)
+		{
+			if ((*j) == unit && (*i)->getReactionScore() > highestReactionScore && (*i)->getMainHandWeapon())
 			{
-				if ((*j) == unit && (*i)->getReactionScore() > highestReactionScore && (*i)->getMainHandWeapon())
+				if (((*i)->getMainHandWeapon()->getRules()->getBattleType() == BT_MELEE && validMeleeRange((*i), unit)) ||
+					(*i)->getMainHandWeapon()->getRules()->getBattleType() != BT_MELEE)
 				{
-					if (((*i)->getMainHandWeapon()->getRules()->getBattleType() == BT_MELEE && validMeleeRange((*i), unit)) ||
-						(*i)->getMainHandWeapon()->getRules()->getBattleType() != BT_MELEE)
-					{
-						// I see you!
-						highestReactionScore = (*i)->getReactionScore();
-						action->actor = (*i);
-					}
+					// I see you!
+					highestReactionScore = (*i)->getReactionScore();
+					action->actor = (*i);
 				}
 			}
 		}
@@ -905,6 +1382,7 @@ BattleUnit *TileEngine::hit(const Position &center, int power, ItemDamageType ty
 		int rndPower = RNG::generate(power/4, (power*3)/4); //RNG::boxMuller(power, power/6)
 		if (tile->damage(part, rndPower))
 			_save->setObjectiveDestroyed(true);
+		invalidateFOVCache(tile->getPosition());
 	}
 	else if (part == 4)
 	{
@@ -959,18 +1437,84 @@ BattleUnit *TileEngine::hit(const Position &center, int power, ItemDamageType ty
  */
 void TileEngine::explode(const Position &center, int power, ItemDamageType type, int maxRadius, BattleUnit *unit)
 {
-	double centerZ = (int)(center.z / 24) + 0.5;
-	double centerX = (int)(center.x / 16) + 0.5;
-	double centerY = (int)(center.y / 16) + 0.5;
-	int power_;
-	std::set<Tile*> tilesAffected;
-	std::pair<std::set<Tile*>::iterator,bool> ret;
-
 	if (type == DT_IN)
 	{
 		power /= 2;
 	}
 
+	if (Options::getBool("battleExplosionFloodFill"))
+	{
+		std::vector<ExplosionSource> sources(1);
+		sources[0].position = Position(center.x / 16, center.y / 16, center.z / 24);
+		sources[0].power = power;
+		sources[0].radius = maxRadius;
+		floodExplosion(sources, type);
+	}
+	else
+	{
+		_explosion.centerX = (int)(center.x / 16) + 0.5;
+		_explosion.centerY = (int)(center.y / 16) + 0.5;
+		_explosion.centerZ = (int)(center.z / 24) + 0.5;
+		_explosion.power = power;
+		_explosion.type = type;
+		_explosion.maxRadius = maxRadius;
+		_explosion.vertdec = getExplosionVertdec();
+		_explosion.rays.resize(EXPLOSION_ELEVATIONS * EXPLOSION_AZIMUTHS);
+
+		// the rays only read the terrain, so they can all be traced at once
+		getThreadPool()->run(traceExplosionJob, this, EXPLOSION_ELEVATIONS);
+	}
+
+	// then the damage is done ray by ray, in the same order as tracing them one at a time would
+	applyExplosion(type, unit);
+
+	calculateSunShading(); // roofs could have been destroyed
+	calculateFOV(center);
+	calculateTerrainLighting(); // fires could have been started
+}
+
+/**
+ * Explodes every tile that was left with explosives by destroyed terrain, all in one go.
+ * The blasts spread as one flood fill, each tile taking the strongest blast that reaches it.
+ * Explosions this sets off in turn are left for the next call.
+ */
+void TileEngine::explodeTerrain()
+{
+	std::vector<ExplosionSource> sources;
+	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
+	{
+		Tile *tile = _save->getTiles()[i];
+		if (tile->getExplosive())
+		{
+			ExplosionSource source;
+			source.position = tile->getPosition();
+			source.power = tile->getExplosive();
+			source.radius = source.power / 10;
+			sources.push_back(source);
+		}
+	}
+	if (sources.empty())
+	{
+		return;
+	}
+
+	floodExplosion(sources, DT_HE);
+	applyExplosion(DT_HE, 0);
+
+	calculateSunShading(); // roofs could have been destroyed
+	for (std::vector<ExplosionSource>::iterator i = sources.begin(); i != sources.end(); ++i)
+	{
+		calculateFOV(Position(i->position.x * 16, i->position.y * 16, i->position.z * 24));
+	}
+	calculateTerrainLighting(); // fires could have been started
+}
+
+/**
+ * How much power an explosion loses going up or down a level, depending on the explosion height option.
+ * @return Power lost per level.
+ */
+int TileEngine::getExplosionVertdec() const
+{
 	int exHeight = Options::getInt("battleExplosionHeight");
 	int vertdec = 1000; //default flat explosion
 	if (exHeight<0) exHeight = 0;
@@ -986,132 +1530,186 @@ void TileEngine::explode(const Position &center, int power, ItemDamageType type,
 	case 3:
 		vertdec = 5;
 	}
+	return vertdec;
+}
+
+/**
+ * Spreads explosions over the tile grid, strongest first, instead of tracing rays.
+ * Power drops by 10 for every tile (14 going diagonally), by the terrain blockage in between,
+ * and by the explosion height factor going up or down a level. Every tile is reached once,
+ * with the most power any of the explosions can bring to it, and noted in the order reached.
+ * @param sources The explosions.
+ * @param type The damage type of the explosions.
+ */
+void TileEngine::floodExplosion(const std::vector<ExplosionSource> &sources, ItemDamageType type)
+{
+	static const int dirX[10] = {0, 1, 1, 1, 0, -1, -1, -1, 0, 0};
+	static const int dirY[10] = {-1, -1, 0, 1, 1, 1, 0, -1, 0, 0};
+	static const int dirZ[10] = {0, 0, 0, 0, 0, 0, 0, 0, 1, -1};
+	int vertdec = getExplosionVertdec();
 
+	_explosion.rays.resize(1);
+	ExplosionRay &ray = _explosion.rays[0];
+	ray.tiles.clear();
+	ray.power.clear();
+	_explosionPower.assign(_save->getMapSizeXYZ(), 0);
+	_explosionHits.resize(_save->getMapSizeXYZ());
 
-	for (int fi = -90; fi <= 90; fi += 5)
-//	for (int fi = 0; fi <= 0; fi += 10)
+	std::priority_queue<ExplosionFront> front;
+	for (size_t i = 0; i < sources.size(); ++i)
 	{
-		// raytrace every 3 degrees makes sure we cover all tiles in a circle.
-		for (int te = 0; te <= 360; te += 3)
+		ExplosionFront start;
+		start.index = _save->getTileIndex(sources[i].position);
+		start.power = sources[i].power + 1;
+		start.source = i;
+		if (start.power > _explosionPower[start.index])
 		{
-			double cos_te = cos(te * M_PI / 180.0);
-			double sin_te = sin(te * M_PI / 180.0);
-			double sin_fi = sin(fi * M_PI / 180.0);
-			double cos_fi = cos(fi * M_PI / 180.0);
-
-			Tile *origin = _save->getTile(center);
-			double l = 0;
-			double vx, vy, vz;
-			int tileX, tileY, tileZ;
-			power_ = power + 1;
+			_explosionPower[start.index] = start.power;
+			front.push(start);
+		}
+	}
 
-			while (power_ > 0 && l <= maxRadius)
+	while (!front.empty())
+	{
+		ExplosionFront current = front.top();
+		front.pop();
+		if (_explosionHits.get(current.index))
+		{
+			continue;
+		}
+		_explosionHits.set(current.index);
+
+		Tile *tile = _save->getTiles()[current.index];
+		ray.tiles.push_back(tile);
+		ray.power.push_back(current.power);
+
+		const ExplosionSource &source = sources[current.source];
+		for (int dir = 0; dir < 10; ++dir)
+		{
+			Position pos = tile->getPosition() + Position(dirX[dir], dirY[dir], dirZ[dir]);
+			Tile *dest = _save->getTile(pos);
+			if (!dest) continue; // out of map!
+			Position offset = pos - source.position;
+			if (offset.x * offset.x + offset.y * offset.y + offset.z * offset.z > source.radius * source.radius) continue;
+
+			ExplosionFront next;
+			next.index = _save->getTileIndex(pos);
+			if (_explosionHits.get(next.index)) continue;
+			next.power = current.power - (horizontalBlockage(tile, dest, type) + verticalBlockage(tile, dest, type)) * 2;
+			next.power -= (dir % 2 == 1 && dir < 8) ? 14 : 10; // explosive damage decreases by 10 per tile
+			if (dirZ[dir] != 0) next.power -= vertdec; //3d explosion factor
+			next.source = current.source;
+			if (next.power > _explosionPower[next.index])
 			{
-				vx = centerX + l * sin_te * cos_fi;
-				vy = centerY + l * cos_te * cos_fi;
-				vz = centerZ + l * sin_fi;
+				_explosionPower[next.index] = next.power;
+				front.push(next);
+			}
+		}
+	}
+}
+
+/**
+ * Does the damage of the explosion worked out last: every tile on every ray in turn,
+ * with the effects on units, items, smoke and fire done the first time a tile is reached.
+ * HE then detonates the tiles reached, in tile order.
+ * @param type The damage type of the explosion.
+ * @param unit The unit that caused the explosion.
+ */
+void TileEngine::applyExplosion(ItemDamageType type, BattleUnit *unit)
+{
+	int power_;
+	std::vector<int> tilesAffected;
 
-				tileZ = int(floor(vz));
-				tileX = int(floor(vx));
-				tileY = int(floor(vy));
+	_explosionHits.resize(_save->getMapSizeXYZ());
+	for (std::vector<ExplosionRay>::const_iterator ray = _explosion.rays.begin(); ray != _explosion.rays.end(); ++ray)
+	{
+		for (size_t step = 0; step < ray->tiles.size(); ++step)
+		{
+			Tile *dest = ray->tiles[step];
+			power_ = ray->power[step];
 
-				Tile *dest = _save->getTile(Position(tileX, tileY, tileZ));
-				if (!dest) break; // out of map!
+			if (type == DT_HE)
+			{
+				// explosives do 1/2 damage to terrain and 1/2 up to 3/2 random damage to units
+				dest->setExplosive(power_ / 2);
+			}
 
-				// blockage by terrain is deducted from the explosion power
-				if (l != 0) // no need to block epicentrum
-				{
-					power_ -= (horizontalBlockage(origin, dest, type) + verticalBlockage(origin, dest, type)) * 2;
-					power_ -= 10; // explosive damage decreases by 10 per tile
-					if (origin->getPosition().z != tileZ) power_ -= vertdec; //3d explosion factor
-				}
+			int index = _save->getTileIndex(dest->getPosition());
+			if (!_explosionHits.get(index)) // check if we had this tile already
+			{
+				_explosionHits.set(index);
+				tilesAffected.push_back(index);
 
-				if (power_ > 0)
+				if (type == DT_STUN)
 				{
-					if (type == DT_HE)
+					// power 50 - 150%
+					if (dest->getUnit())
 					{
-						// explosives do 1/2 damage to terrain and 1/2 up to 3/2 random damage to units
-						dest->setExplosive(power_ / 2);
+						dest->getUnit()->damage(Position(0, 0, 0), (int)(RNG::generate(power_/2.0, power_*1.5)), type);
 					}
-
-					ret = tilesAffected.insert(dest); // check if we had this tile already
-					if (ret.second)
+					for (std::vector<BattleItem*>::iterator it = dest->getInventory()->begin(); it != dest->getInventory()->end(); ++it)
 					{
-						if (type == DT_STUN)
-						{
-							// power 50 - 150%
-							if (dest->getUnit())
-							{
-								dest->getUnit()->damage(Position(0, 0, 0), (int)(RNG::generate(power_/2.0, power_*1.5)), type);
-							}
-							for (std::vector<BattleItem*>::iterator it = dest->getInventory()->begin(); it != dest->getInventory()->end(); ++it)
-							{
-								if ((*it)->getUnit())
-								{
-									(*it)->getUnit()->damage(Position(0, 0, 0), (int)(RNG::generate(power_/2.0, power_*1.5)), type);
-								}
-							}
-						}
-						if (type == DT_HE)
-						{
-							// power 50 - 150%
-							if (dest->getUnit())
-							{
-								dest->getUnit()->damage(Position(0, 0, 0), (int)(RNG::generate(power_/2.0, power_*1.5)), type);
-							}
-							bool done = false;
-							while (!done)
-							{
-								done = dest->getInventory()->size() == 0;
-								for (std::vector<BattleItem*>::iterator it = dest->getInventory()->begin(); it != dest->getInventory()->end(); )
-								{
-									if (power_ > (*it)->getRules()->getArmor())
-									{
-										if ((*it)->getUnit() && (*it)->getUnit()->getStatus() == STATUS_UNCONSCIOUS)
-											(*it)->getUnit()->instaKill();
-										_save->removeItem((*it));
-										break;
-									}
-									else
-									{
-										++it;
-										done = it == dest->getInventory()->end();
-									}
-								}
-							}
-						}
-
-						if (type == DT_SMOKE)
+						if ((*it)->getUnit())
 						{
-							// smoke from explosions always stay 6 to 14 turns - power of a smoke grenade is 60
-							if (dest->getSmoke() < 10)
-							{
-								dest->addSmoke(RNG::generate(power_/10, 14));
-							}
+							(*it)->getUnit()->damage(Position(0, 0, 0), (int)(RNG::generate(power_/2.0, power_*1.5)), type);
 						}
-
-						if (type == DT_IN && !dest->isVoid())
+					}
+				}
+				if (type == DT_HE)
+				{
+					// power 50 - 150%
+					if (dest->getUnit())
+					{
+						dest->getUnit()->damage(Position(0, 0, 0), (int)(RNG::generate(power_/2.0, power_*1.5)), type);
+					}
+					bool done = false;
+					while (!done)
+					{
+						done = dest->getInventory()->size() == 0;
+						for (std::vector<BattleItem*>::iterator it = dest->getInventory()->begin(); it != dest->getInventory()->end(); )
 						{
-							if (dest->getFire() == 0)
+							if (power_ > (*it)->getRules()->getArmor())
 							{
-								dest->ignite();
+								if ((*it)->getUnit() && (*it)->getUnit()->getStatus() == STATUS_UNCONSCIOUS)
+									(*it)->getUnit()->instaKill();
+								_save->removeItem((*it));
+								break;
 							}
-							if (dest->getUnit())
+							else
 							{
-								dest->getUnit()->damage(Position(0, 0, 0), RNG::generate(0, power_/3), type); // immediate IN damage
-								dest->getUnit()->setFire(RNG::generate(1, 5)); // catch fire and burn for 1-5 rounds
+								++it;
+								done = it == dest->getInventory()->end();
 							}
 						}
+					}
+				}
 
-						if (unit && dest->getUnit() && dest->getUnit()->getFaction() != unit->getFaction())
-						{
-							unit->addFiringExp();
-						}
+				if (type == DT_SMOKE)
+				{
+					// smoke from explosions always stay 6 to 14 turns - power of a smoke grenade is 60
+					if (dest->getSmoke() < 10)
+					{
+						dest->addSmoke(RNG::generate(power_/10, 14));
+					}
+				}
 
+				if (type == DT_IN && !dest->isVoid())
+				{
+					if (dest->getFire() == 0)
+					{
+						dest->ignite();
+					}
+					if (dest->getUnit())
+					{
+						dest->getUnit()->damage(Position(0, 0, 0), RNG::generate(0, power_/3), type); // immediate IN damage
+						dest->getUnit()->setFire(RNG::generate(1, 5)); // catch fire and burn for 1-5 rounds
 					}
 				}
-				origin = dest;
-				l++;
+
+				if (unit && dest->getUnit() && dest->getUnit()->getFaction() != unit->getFaction())
+				{
+					unit->addFiringExp();
+				}
 			}
 		}
 	}
@@ -1119,17 +1717,87 @@ void TileEngine::explode(const Position &center, int power, ItemDamageType type,
 
 	if (type == DT_HE)
 	{
-		for (std::set<Tile*>::iterator i = tilesAffected.begin(); i != tilesAffected.end(); ++i)
+		std::sort(tilesAffected.begin(), tilesAffected.end());
+		for (std::vector<int>::iterator i = tilesAffected.begin(); i != tilesAffected.end(); ++i)
 		{
-			if (detonate(*i))
+			Tile *tile = _save->getTiles()[*i];
+			if (detonate(tile))
 				_save->setObjectiveDestroyed(true);
-			applyItemGravity(*i);
+			applyItemGravity(tile);
+			invalidateFOVCache(tile->getPosition());
 		}
 	}
 
-	calculateSunShading(); // roofs could have been destroyed
-	calculateFOV(center);
-	calculateTerrainLighting(); // fires could have been started
+}
+
+/**
+ * Traces the rays of the explosion being worked out at one elevation.
+ * Called from the worker threads, so it mustn't change anything but the rays.
+ * @param engine Pointer to the tile engine.
+ * @param index Which elevation to trace, from straight down to straight up.
+ * @param thread Unused.
+ */
+void TileEngine::traceExplosionJob(void *engine, int index, int)
+{
+	TileEngine *self = static_cast<TileEngine*>(engine);
+	for (int te = 0; te < EXPLOSION_AZIMUTHS; ++te)
+	{
+		self->traceExplosionRay(index, te, self->_explosion.rays[index * EXPLOSION_AZIMUTHS + te]);
+	}
+}
+
+/**
+ * Follows one ray of an explosion out from its center until its power runs out,
+ * noting every tile it reaches with the power it has left there.
+ * Elevations go every 5 degrees, azimuths every 3 degrees, which makes sure we cover all tiles in a circle.
+ * @param fi Elevation index.
+ * @param te Azimuth index.
+ * @param ray Where to note the tiles.
+ */
+void TileEngine::traceExplosionRay(int fi, int te, ExplosionRay &ray)
+{
+	double sin_te = explosionDirections.sinTe[te];
+	double cos_te = explosionDirections.cosTe[te];
+	double sin_fi = explosionDirections.sinFi[fi];
+	double cos_fi = explosionDirections.cosFi[fi];
+
+	Tile *origin = 0;
+	double l = 0;
+	double vx, vy, vz;
+	int tileX, tileY, tileZ;
+	int power_ = _explosion.power + 1;
+	ray.tiles.clear();
+	ray.power.clear();
+
+	while (power_ > 0 && l <= _explosion.maxRadius)
+	{
+		vx = _explosion.centerX + l * sin_te * cos_fi;
+		vy = _explosion.centerY + l * cos_te * cos_fi;
+		vz = _explosion.centerZ + l * sin_fi;
+
+		tileZ = int(floor(vz));
+		tileX = int(floor(vx));
+		tileY = int(floor(vy));
+
+		Tile *dest = _save->getTile(Position(tileX, tileY, tileZ));
+		if (!dest) break; // out of map!
+
+		// blockage by terrain is deducted from the explosion power
+		if (l != 0) // no need to block epicentrum
+		{
+			power_ -= (horizontalBlockage(origin, dest, _explosion.type) + verticalBlockage(origin, dest, _explosion.type)) * 2;
+			power_ -= 10; // explosive damage decreases by 10 per tile
+			if (origin->getPosition().z != tileZ) power_ -= _explosion.vertdec; //3d explosion factor
+		}
+
+		if (power_ > 0)
+		{
+			ray.tiles.push_back(dest);
+			ray.power.push_back(power_);
+		}
+		origin = dest;
+		l++;
+	}
 }
 
 /**
@@ -1580,13 +2248,12 @@ int TileEngine::unitOpensDoor(BattleUnit *unit, bool rClick)
 	{
 
 		unit->spendTimeUnits(TUCost);
+		// adjacent doors up to 2 tiles away open along with this one
+		invalidateFOVCache(unit->getPosition(), size + 2);
 		calculateFOV(unit->getPosition());
 		// look from the other side (may be need check reaction fire?)
-		std::vector<BattleUnit*> *vunits = unit->getVisibleUnits();
-		for (int i = 0; i < vunits->size(); ++i)
-		{
-			calculateFOV(vunits->at(i));
-		}
+		std::vector<BattleUnit*> vunits = *unit->getVisibleUnits();
+		calculateFOV(vunits);
 	}
 
 	return door;
@@ -1603,13 +2270,19 @@ int TileEngine::closeUfoDoors()
 	// prepare a list of tiles on fire/smoke & close any ufo doors
 	for (int i = 0; i < _save->getMapSizeXYZ(); ++i)
 	{
-		doorsclosed += _save->getTiles()[i]->closeUfoDoor();
+		if (_save->getTiles()[i]->closeUfoDoor())
+		{
+			invalidateFOVCache(_save->getTiles()[i]->getPosition());
+			++doorsclosed;
+		}
 	}
 
 	return doorsclosed;
 }
 /**
  * calculateLine. Using bresenham algorithm in 3D.
+ * Unless the whole trajectory is stored, runs of the line through tiles that have nothing to hit
+ * are stepped over in one go instead of checking every voxel.
  * @param origin (voxel??)
  * @param target (also voxel??)
  * @param storeTrajectory true will store the whole trajectory - otherwise it just stores the last position.
@@ -1627,6 +2300,7 @@ int TileEngine::calculateLine(const Position& origin, const Position& target, bo
 	int swap_xy, swap_xz;
 	int drift_xy, drift_xz;
 	int cx, cy, cz;
+	int size_x = 16, size_y = 16, size_z = 24;
 	Position lastPoint(origin);
 	int result;
 
@@ -1641,6 +2315,7 @@ int TileEngine::calculateLine(const Position& origin, const Position& target, bo
 	{
 		std::swap(x0, y0);
 		std::swap(x1, y1);
+		std::swap(size_x, size_y);
 	}
 
 	//do same for xz
@@ -1649,6 +2324,7 @@ int TileEngine::calculateLine(const Position& origin, const Position& target, bo
 	{
 		std::swap(x0, z0);
 		std::swap(x1, z1);
+		std::swap(size_x, size_z);
 	}
 
 	//delta is Length in each plane
@@ -1680,6 +2356,45 @@ int TileEngine::calculateLine(const Position& origin, const Position& target, bo
 		if (swap_xz) std::swap(cx, cz);
 		if (swap_xy) std::swap(cx, cy);
 
+		//step over the part of the line that stays inside a tile with nothing to hit
+		if (doVoxelCheck && !storeTrajectory && cx >= 0 && cy >= 0 && cz >= 0)
+		{
+			Tile *tile = _save->getTile(Position(cx/16, cy/16, cz/24));
+			if (tile != 0 && isTileClear(tile))
+			{
+				// how many steps until the line leaves the tile along the longest delta...
+				int steps = std::min(abs(x1 - x) + 1, step_x > 0 ? size_x - x % size_x : x % size_x + 1);
+				// ...and along the shallow planes, which move one voxel each time their drift runs out
+				if (delta_y > 0)
+				{
+					int room = step_y > 0 ? size_y - 1 - y % size_y : y % size_y;
+					steps = std::min(steps, (room * delta_x + drift_xy) / delta_y);
+				}
+				if (delta_z > 0)
+				{
+					int room = step_z > 0 ? size_z - 1 - z % size_z : z % size_z;
+					steps = std::min(steps, (room * delta_x + drift_xz) / delta_z);
+				}
+				if (steps > 0)
+				{
+					if (delta_y > 0)
+					{
+						int moves = std::max(0, (steps*delta_y - drift_xy + delta_x - 1) / delta_x);
+						y += moves * step_y;
+						drift_xy += moves * delta_x - steps * delta_y;
+					}
+					if (delta_z > 0)
+					{
+						int moves = std::max(0, (steps*delta_z - drift_xz + delta_x - 1) / delta_x);
+						z += moves * step_z;
+						drift_xz += moves * delta_x - steps * delta_z;
+					}
+					x += (steps - 1) * step_x;
+					continue;
+				}
+			}
+		}
+
 		if (storeTrajectory)
 		{
 			trajectory->push_back(Position(cx, cy, cz));
@@ -1866,6 +2581,22 @@ bool TileEngine::isVoxelVisible(const Position& voxel)
 
 
 
+/**
+ * Checks if voxelCheck can't hit anything anywhere in a tile:
+ * it has no terrain voxels and no unit standing on it or sticking up into it from below.
+ * @param tile The tile to check.
+ * @return True if the tile is clear.
+ */
+bool TileEngine::isTileClear(Tile *tile)
+{
+	if (!getVoxelShape(tile).empty || tile->getUnit() != 0)
+	{
+		return false;
+	}
+	Tile *below = _save->getTile(tile->getPosition() + Position(0, 0, -1));
+	return below == 0 || below->getUnit() == 0;
+}
+
 /**
  * Check if we hit a voxel.
  * @param voxel The voxel to check.
@@ -1884,19 +2615,22 @@ int TileEngine::voxelCheck(const Position& voxel, BattleUnit *excludeUnit, bool
 	}
 
 	// first we check terrain voxel data, not to allow 2x2 units stick through walls
-	for (int i=0; i< 4; ++i)
+	const VoxelShape &shape = getVoxelShape(tile);
+	if (!shape.empty)
 	{
-		MapData *mp = tile->getMapData(i);
-		if (tile->isUfoDoorOpen(i))
-			continue;
-		if (mp != 0)
+		int slice = (voxel.z%24)/2;
+		int x = 15 - voxel.x%16;
+		int y = voxel.y%16;
+		if (shape.rows[slice][y] & (1 << x))
 		{
-			int x = 15 - voxel.x%16;
-			int y = voxel.y%16;
-			int idx = (mp->getLoftID((voxel.z%24)/2)*16) + y;
-			if (_voxelData->at(idx) & (1 << x))
+			// the merged row says something is there, the lowest part that has the voxel is the one we hit
+			for (int i=0; i< 4; ++i)
 			{
-				return i;
+				int loft = shape.loft[i][slice];
+				if (loft != -1 && (*_voxelData)[loft*16 + y] & (1 << x))
+				{
+					return i;
+				}
 			}
 		}
 	}
@@ -20,11 +20,13 @@
 #define OPENXCOM_TILEENGINE_H
 
 #include <vector>
+#include <map>
 #include "Position.h"
 #include "../Ruleset/MapData.h"
 #include <SDL.h>
 #include "BattlescapeGame.h"
 #include "../Savegame/BattleUnit.h"
+#include "../Savegame/BitPlane.h"
 
 namespace OpenXcom
 {
@@ -33,6 +35,8 @@ class SavedBattleGame;
 class BattleUnit;
 class BattleItem;
 class Tile;
+class ThreadPool;
+class ThreatMap;
 
 /**
  * A utility class that modifies tile properties on a battlescape map. This includes lighting, destruction, smoke, fire, fog of war.
@@ -43,12 +47,121 @@ class TileEngine
 private:
 	static const int MAX_VIEW_DISTANCE = 20;
 	static const int MAX_DARKNESS_TO_SEE_UNITS = 9;
+	static const int EXPLOSION_ELEVATIONS = 37;
+	static const int EXPLOSION_AZIMUTHS = 121;
+	/// The terrain line of sight traced so far from one eye position, so it doesn't get traced again.
+	struct ViewCache
+	{
+		Position origin;
+		int size;
+		int directions;
+	};
+	/// The tile-space rays from one eye to every tile in its view, merged where they run over the same tiles.
+	struct RayFan
+	{
+		std::vector<int> parent;
+		std::vector<Position> offset;
+		std::vector<bool> target;
+	};
+	/// What a unit sees, worked out without changing the battlescape so several units can look at once.
+	struct FOVTrace
+	{
+		Position eye;
+		int direction;
+		std::vector<const RayFan*> fans;
+		std::vector<Tile*> tiles;
+		std::vector<BattleUnit*> units;
+	};
+	/// Scratch space for tracing ray fans, one for each thread.
+	struct FOVScratch
+	{
+		std::vector<char> rays;
+		std::vector<int> marks;
+		int stamp;
+		FOVScratch() : stamp(0) {}
+	};
+	/// The terrain voxels of all four parts of a tile merged together, shared by every tile built from the same parts.
+	struct VoxelShape
+	{
+		Uint16 rows[12][16];
+		int loft[4][12];
+		bool empty;
+	};
+	/// The tiles one ray of an explosion reaches, with the power it has left at each.
+	struct ExplosionRay
+	{
+		std::vector<Tile*> tiles;
+		std::vector<int> power;
+	};
+	/// An explosion being worked out, so its rays can be traced on several threads.
+	struct ExplosionTrace
+	{
+		double centerX, centerY, centerZ;
+		int power, maxRadius, vertdec;
+		ItemDamageType type;
+		std::vector<ExplosionRay> rays;
+	};
+	/// A light on the map. Light reaches every level, so only the column it is in matters.
+	struct LightSource
+	{
+		int x, y, power;
+		LightSource(const Position &pos, int lightPower) : x(pos.x), y(pos.y), power(lightPower) {}
+		bool operator<(const LightSource &other) const { return x < other.x || (x == other.x && (y < other.y || (y == other.y && power < other.power))); }
+	};
+	/// The light sources a light layer was last worked out from.
+	struct LightLayer
+	{
+		std::vector<LightSource> sources;
+		bool valid;
+		LightLayer() : valid(false) {}
+	};
+	/// Where an explosion spread by flood fill starts.
+	struct ExplosionSource
+	{
+		Position position;
+		int power, radius;
+	};
+	/// A tile an explosion flood fill can spread to, with the power it gets there with.
+	struct ExplosionFront
+	{
+		int power, index, source;
+		bool operator<(const ExplosionFront &other) const { return power < other.power || (power == other.power && index > other.index); }
+	};
 	SavedBattleGame *_save;
 	std::vector<Uint16> *_voxelData;
+	std::map<BattleUnit*, ViewCache> _viewCache;
+	std::map<int, RayFan> _rayFans;
+	std::vector<FOVTrace> _fovTraces;
+	std::vector<FOVScratch> _fovScratch;
+	const std::vector<BattleUnit*> *_fovUnits;
+	ThreadPool *_threadPool;
+	ThreatMap *_threatMaps[3];
+	UnitFaction _surveySide;
+	std::vector<VoxelShape> _voxelShapes;
+	std::map<std::vector<int>, int> _voxelShapeIndex;
+	ExplosionTrace _explosion;
+	BitPlane _explosionHits;
+	std::vector<int> _explosionPower;
+	LightLayer _lightLayers[3];
 	static const int heightFromCenter[11];
-	void addLight(const Position &center, int power, int layer);
+	void addLight(const LightSource &light, int layer, int minX, int minY, int maxX, int maxY);
+	void updateLighting(std::vector<LightSource> &sources, int layer);
 	int blockage(Tile *tile, const int part, ItemDamageType type);
 	int vectorToDirection(const Position &vector);
+	const RayFan &getRayFan(int direction, int eyeX, int eyeY, int eyeZ);
+	void traceRayFan(const Position &eye, const RayFan &fan, FOVScratch &scratch, std::vector<Tile*> &tiles);
+	void prepareFOV(BattleUnit *unit, FOVTrace &trace);
+	static void traceFOVJob(void *engine, int index, int thread);
+	void traceFOV(BattleUnit *unit, FOVTrace &trace, FOVScratch &scratch);
+	bool applyFOV(BattleUnit *unit, const FOVTrace &trace);
+	const VoxelShape &getVoxelShape(Tile *tile);
+	bool isTileClear(Tile *tile);
+	static void traceExplosionJob(void *engine, int index, int thread);
+	void traceExplosionRay(int fi, int te, ExplosionRay &ray);
+	int getExplosionVertdec() const;
+	void floodExplosion(const std::vector<ExplosionSource> &sources, ItemDamageType type);
+	void applyExplosion(ItemDamageType type, BattleUnit *unit);
+	static UnitFaction getOpponents(UnitFaction faction);
 	bool _personalLighting;
 public:
 	/// Creates a new TileEngine class.
@@ -59,19 +172,39 @@ public:
 	void calculateSunShading();
 	/// Calculate sun shading of a single tile.
 	void calculateSunShading(Tile *tile);
+	/// Gets the worker threads used for batch calculations.
+	ThreadPool *getThreadPool();
+	/// Gets the map of tiles the units of a faction threaten.
+	ThreatMap *getThreatMap(UnitFaction faction);
+	/// Forget every threat map, so the next update traces every unit again.
+	void invalidateThreatMaps();
+	/// Brings the threat map of a side's opponents up to date and drops the AI's survey of the tiles if the threats changed.
+	void updateThreatSurvey(UnitFaction side, bool newTurn);
+	/// Cache the merged terrain voxels of every changed tile.
+	void calculateVoxelShapes();
 	/// Calculate the field of view from a units view point.
 	bool calculateFOV(BattleUnit *unit);
+	/// Calculate the field of view of a number of units at once.
+	void calculateFOV(const std::vector<BattleUnit*> &units);
 	/// Calculate the field of view within range of a certain position.
 	void calculateFOV(const Position &position);
+	/// Forget the cached terrain line of sight around a changed position.
+	void invalidateFOVCache(const Position &position, int radius = 0);
+	/// Forget all cached terrain line of sight.
+	void invalidateFOVCache();
 	/// Check reaction fire.
 	bool checkReactionFire(BattleUnit *unit, BattleAction *action, BattleUnit *potentialVictim = 0, bool recalculateFOV = true);
 	/// Recalculate lighting of the battlescape.
 	void calculateTerrainLighting();
 	/// Recalculate lighting of the battlescape.
 	void calculateUnitLighting();
+	/// Forget the light sources, so the next recalculation relights the whole map.
+	void invalidateLighting();
 	/// Explosions.
 	BattleUnit *hit(const Position &center, int power, ItemDamageType type, BattleUnit *unit);
 	void explode(const Position &center, int power, ItemDamageType type, int maxRadius, BattleUnit *unit = 0);
+	/// Explode every tile left with explosives by destroyed terrain at once.
+	void explodeTerrain();
 	/// Check if a destroyed tile starts an explosion.
 	Tile *checkForTerrainExplosions();
 	/// Unit opens door?
@@ -84,6 +217,8 @@ public:
 	int calculateParabola(const Position& origin, const Position& target, bool storeTrajectory, std::vector<Position> *trajectory, BattleUnit *excludeUnit, double curvature, double accuracy);
 	bool surveyXComThreatToTile(Tile *tile, Position &tilePos, BattleUnit *hypotheticalUnit);	
 	Position getSightOriginVoxel(BattleUnit *currentUnit);
+	/// Gets how far a unit can see before the smoke along the way is counted.
+	int getViewDistance(BattleUnit *unit) const;
 	bool visible(BattleUnit *currentUnit, Tile *tile);
 	void togglePersonalLighting();
 	int distance(const Position &pos1, const Position &pos2) const;
@@ -164,6 +164,7 @@ void UnitFallBState::think()
 				if ((*unit)->getSpecialAbility() == SPECAB_BURNFLOOR)
 				{
 					(*unit)->getTile()->destroy(MapData::O_FLOOR);
+					_terrain->invalidateFOVCache((*unit)->getPosition());
 				}
 				// move our personal lighting with us
 				_terrain->calculateUnitLighting();
@@ -105,16 +105,9 @@ void UnitWalkBState::think()
 					Tile *otherTileBelow = _parent->getSave()->getTile(_unit->getPosition() + Position(x,y,-1));
 					if (!_parent->getSave()->getTile(_unit->getPosition() + Position(x,y,0))->hasNoFloor(otherTileBelow) || _unit->getArmor()->getMovementType() == MT_FLY)
 						largeCheck = false;
-					_parent->getSave()->getTile(_unit->getLastPosition() + Position(x,y,0))->setUnit(0);
-				}
-			}
-			for (int x = size; x >= 0; x--)
-			{
-				for (int y = size; y >= 0; y--)
-				{
-					_parent->getSave()->getTile(_unit->getPosition() + Position(x,y,0))->setUnit(_unit, _parent->getSave()->getTile(_unit->getPosition() + Position(x,y,-1)));
 				}
 			}
+			moveOnTiles(_parent->getSave(), _unit, _unit->getLastPosition());
 			_falling = largeCheck && _unit->getPosition().z != 0 && _unit->getTile()->hasNoFloor(tileBelow) && _unit->getArmor()->getMovementType() != MT_FLY && _unit->getWalkingPhase() == 0;
 			
 			if (_falling)
@@ -163,6 +156,7 @@ void UnitWalkBState::think()
 			if (_unit->getSpecialAbility() == SPECAB_BURNFLOOR)
 			{
 				_unit->getTile()->destroy(MapData::O_FLOOR);
+				_terrain->invalidateFOVCache(_unit->getPosition());
 			}
 
 			// move our personal lighting with us
@@ -171,34 +165,13 @@ void UnitWalkBState::think()
 
 			BattleAction action;
 			
-			// check for proximity grenades (1 tile around the unit in every direction) (for large units, we need to check every tile it occupies)
-			int size = _unit->getArmor()->getSize() - 1;
-			for (int x = size; x >= 0; x--)
+			// check for proximity grenades
+			Position p;
+			BattleItem *grenade = triggerProximityGrenade(_parent->getSave(), _unit, &p);
+			if (grenade)
 			{
-				for (int y = size; y >= 0; y--)
-				{
-					for (int tx = -1; tx < 2; tx++)
-					{
-						for (int ty = -1; ty < 2; ty++)
-						{
-							Tile *t = _parent->getSave()->getTile(_unit->getPosition() + Position(x,y,0) + Position(tx,ty,0));
-							if (t)
-							for (std::vector<BattleItem*>::iterator i = t->getInventory()->begin(); i != t->getInventory()->end(); ++i)
-							{
-								if ((*i)->getRules()->getBattleType() == BT_PROXIMITYGRENADE && (*i)->getExplodeTurn() > 0)
-								{
-									Position p;
-									p.x = t->getPosition().x*16 + 8;
-									p.y = t->getPosition().y*16 + 8;
-									p.z = t->getPosition().z*24 + t->getTerrainLevel();
-									_parent->statePushNext(new ExplosionBState(_parent, p, (*i), (*i)->getPreviousOwner()));
-									t->getInventory()->erase(i);
-									return;
-								}
-							}
-						}
-					}
-				}
+				_parent->statePushNext(new ExplosionBState(_parent, p, grenade, grenade->getPreviousOwner()));
+				return;
 			}
 
 			// check for reaction fire
@@ -263,16 +236,12 @@ void UnitWalkBState::think()
 			}
 
 			Position destination;
-			int tu = _pf->getTUCost(_unit->getPosition(), dir, &destination, _unit, 0); // gets tu cost, but also gets the destination position.
+			int energy;
+			int tu = getStepCost(_pf, _unit, dir, _action.run, &destination, &energy);
 			if (_falling)
 			{
 				tu = 0;
-			}
-			int energy = tu;
-			if (_action.run)
-			{
-				tu *= 0.75;
-				energy *= 1.5;
+				energy = 0;
 			}
 
 			if (tu > _unit->getTimeUnits())
@@ -485,4 +454,93 @@ void UnitWalkBState::playMovementSound()
 	}
 }
 
+/**
+ * Gets the time units and energy a step costs, running or not.
+ * @param pf Pointer to the pathfinding.
+ * @param unit The walking unit.
+ * @param dir Direction of the step.
+ * @param run Whether the unit runs.
+ * @param destination Returns where the step ends.
+ * @param energy Returns the energy the step costs.
+ * @return The time units the step costs.
+ */
+int UnitWalkBState::getStepCost(Pathfinding *pf, BattleUnit *unit, int dir, bool run, Position *destination, int *energy)
+{
+	int tu = pf->getTUCost(unit->getPosition(), dir, destination, unit, 0); // gets tu cost, but also gets the destination position.
+	*energy = tu;
+	if (run)
+	{
+		tu *= 0.75;
+		*energy *= 1.5;
+	}
+	return tu;
+}
+
+/**
+ * Takes a unit off the tiles it stood on and puts it on the tiles at its position,
+ * once it got to the next tile.
+ * @param save Pointer to the battle.
+ * @param unit The walking unit.
+ * @param from The position it came from.
+ */
+void UnitWalkBState::moveOnTiles(SavedBattleGame *save, BattleUnit *unit, const Position &from)
+{
+	int size = unit->getArmor()->getSize() - 1;
+	for (int x = size; x >= 0; x--)
+	{
+		for (int y = size; y >= 0; y--)
+		{
+			save->getTile(from + Position(x,y,0))->setUnit(0);
+		}
+	}
+	for (int x = size; x >= 0; x--)
+	{
+		for (int y = size; y >= 0; y--)
+		{
+			save->getTile(unit->getPosition() + Position(x,y,0))->setUnit(unit, save->getTile(unit->getPosition() + Position(x,y,-1)));
+		}
+	}
+}
+
+/**
+ * Checks for proximity grenades 1 tile around the unit in every direction
+ * (for large units, every tile it occupies is checked), and takes the first
+ * live one found off the tile it lies on.
+ * @param save Pointer to the battle.
+ * @param unit The unit that stepped next to it.
+ * @param voxel Returns where the grenade goes off.
+ * @return The grenade, 0 if there is none.
+ */
+BattleItem *UnitWalkBState::triggerProximityGrenade(SavedBattleGame *save, BattleUnit *unit, Position *voxel)
+{
+	int size = unit->getArmor()->getSize() - 1;
+	for (int x = size; x >= 0; x--)
+	{
+		for (int y = size; y >= 0; y--)
+		{
+			for (int tx = -1; tx < 2; tx++)
+			{
+				for (int ty = -1; ty < 2; ty++)
+				{
+					Tile *t = save->getTile(unit->getPosition() + Position(x,y,0) + Position(tx,ty,0));
+					if (t)
+					for (std::vector<BattleItem*>::iterator i = t->getInventory()->begin(); i != t->getInventory()->end(); ++i)
+					{
+						if ((*i)->getRules()->getBattleType() == BT_PROXIMITYGRENADE && (*i)->getExplodeTurn() > 0)
+						{
+							BattleItem *grenade = *i;
+							voxel->x = t->getPosition().x*16 + 8;
+							voxel->y = t->getPosition().y*16 + 8;
+							voxel->z = t->getPosition().z*24 + t->getTerrainLevel();
+							t->getInventory()->erase(i);
+							return grenade;
+						}
+					}
+				}
+			}
+		}
+	}
+	return 0;
+}
+
 }
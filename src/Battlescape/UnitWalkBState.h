@@ -26,8 +26,10 @@ namespace OpenXcom
 {
 
 class BattleUnit;
+class BattleItem;
 class Pathfinding;
 class TileEngine;
+class SavedBattleGame;
 
 class UnitWalkBState : public BattleState
 {
@@ -53,6 +55,12 @@ public:
 	void cancel();
 	/// Runs state functionality every cycle. Returns false when finished.
 	void think();
+	/// Gets the time units and energy a step costs, and where it ends.
+	static int getStepCost(Pathfinding *pf, BattleUnit *unit, int dir, bool run, Position *destination, int *energy);
+	/// Moves a unit off the tiles it stood on and onto the tiles at its position.
+	static void moveOnTiles(SavedBattleGame *save, BattleUnit *unit, const Position &from);
+	/// Takes a live proximity grenade next to a unit off its tile, to be set off.
+	static BattleItem *triggerProximityGrenade(SavedBattleGame *save, BattleUnit *unit, Position *voxel);
 };
 
 }
@@ -43,6 +43,7 @@
 #include <stdlib.h>
 #include <sys/param.h>
 #include <sys/types.h>
+#include <sys/time.h>
 #include <pwd.h>
 #endif
 
@@ -475,5 +476,97 @@ bool deleteFile(const std::string &path)
 #endif
 }
 
+/**
+ * Moves a file to another path, replacing any file already there.
+ * On the same drive this happens at once, so the destination
+ * is always either the old file or the whole new one.
+ * @param src Full path to the file.
+ * @param dest Full path to move it to.
+ * @return True if the operation succeeded, False otherwise.
+ */
+bool moveFile(const std::string &src, const std::string &dest)
+{
+#ifdef _WIN32
+	return (MoveFileExA(src.c_str(), dest.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0);
+#else
+	return (rename(src.c_str(), dest.c_str()) == 0);
+#endif
+}
+
+/**
+ * Gets when a file was last changed and how big it is,
+ * for telling if a file changed since it was last read.
+ * @param path Full path to file.
+ * @param modified Returns the time it was last written, in seconds.
+ * @param size Returns the size in bytes.
+ * @return False if the file couldn't be found.
+ */
+bool getFileInfo(const std::string &path, long *modified, long *size)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA info;
+	if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &info))
+	{
+		return false;
+	}
+	ULARGE_INTEGER time;
+	time.LowPart = info.ftLastWriteTime.dwLowDateTime;
+	time.HighPart = info.ftLastWriteTime.dwHighDateTime;
+	// 100 nanosecond intervals since 1601
+	*modified = (long)(time.QuadPart / 10000000ULL - 11644473600ULL);
+	*size = (long)info.nFileSizeLow;
+	return true;
+#else
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+	{
+		return false;
+	}
+	*modified = (long)info.st_mtime;
+	*size = (long)info.st_size;
+	return true;
+#endif
+}
+
+/**
+ * Gets the number of processors the system can run threads on.
+ * @return Number of processors, at least 1.
+ */
+int getProcessorCount()
+{
+	int count = 1;
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	count = info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	if (count < 1)
+	{
+		count = 1;
+	}
+	return count;
+}
+
+/**
+ * Gets the time elapsed since some arbitrary point, with a much
+ * finer resolution than SDL's millisecond ticks, for timing code.
+ * @return Time in seconds.
+ */
+double getTime()
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timeval now;
+	gettimeofday(&now, 0);
+	return now.tv_sec + now.tv_usec / 1000000.0;
+#endif
+}
+
 }
 }
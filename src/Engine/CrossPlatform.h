@@ -53,6 +53,14 @@ namespace CrossPlatform
 	bool fileExists(const std::string &path);
 	/// Deletes the specified file.
 	bool deleteFile(const std::string &path);
+	/// Moves a file, replacing the one at the destination.
+	bool moveFile(const std::string &src, const std::string &dest);
+	/// Gets when a file was last changed and its size.
+	bool getFileInfo(const std::string &path, long *modified, long *size);
+	/// Gets the number of processors in the system.
+	int getProcessorCount();
+	/// Gets a high resolution time in seconds.
+	double getTime();
 }
 
 }
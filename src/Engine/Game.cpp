@@ -33,6 +33,7 @@
 #include "../Resource/ResourcePack.h"
 #include "../Ruleset/Ruleset.h"
 #include "../Savegame/SavedGame.h"
+#include "../Savegame/SaveWriter.h"
 #include "Palette.h"
 #include "Action.h"
 #include "Exception.h"
@@ -120,6 +121,9 @@ Game::Game(const std::string &title) : _screen(0), _cursor(0), _lang(0), _states
 	// Create fps counter
 	_fpsCounter = new FpsCounter(15, 5, 0, 0);
 
+	// Create save writer
+	_saveWriter = new SaveWriter();
+
 	// Create blank language
 	_lang = new Language();
 
@@ -145,6 +149,7 @@ Game::~Game()
 	delete _save;
 	delete _screen;
 	delete _fpsCounter;
+	delete _saveWriter;
 
 	Mix_CloseAudio();
 
@@ -470,6 +475,16 @@ void Game::setSavedGame(SavedGame *save)
 	_save = save;
 }
 
+/**
+ * Returns the writer that saves games in the background,
+ * like the autosaves.
+ * @return Pointer to the save writer.
+ */
+SaveWriter *Game::getSaveWriter() const
+{
+	return _saveWriter;
+}
+
 /**
  * Returns the ruleset currently in use by the game.
  * @return Pointer to the ruleset.
@@ -34,6 +34,7 @@ class ResourcePack;
 class SavedGame;
 class Ruleset;
 class FpsCounter;
+class SaveWriter;
 
 /**
  * The core of the game engine, manages the game's entire contents and structure.
@@ -54,6 +55,7 @@ private:
 	Ruleset *_rules;
 	bool _quit, _init;
 	FpsCounter *_fpsCounter;
+	SaveWriter *_saveWriter;
 	bool _mouseActive;
 	int _alienContainmentHasUpperLimit; // It's an int-type cache for Options::getBool("alienContainmentHasUpperLimit").
 	static bool _ctrlKeyDown; // Used so player can indicate strafing movement.
@@ -95,6 +97,8 @@ public:
 	SavedGame *getSavedGame() const;
 	/// Sets a new saved game for the game.
 	void setSavedGame(SavedGame *save);
+	/// Gets the writer for saves made in the background.
+	SaveWriter *getSaveWriter() const;
 	/// Gets the currently loaded ruleset.
 	Ruleset *getRuleset() const;
 	/// Loads a new ruleset for the game.
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "MemoryPool.h"
+#include <new>
+
+namespace OpenXcom
+{
+
+MemoryPool *MemoryPool::_pools[MemoryPool::POOLS] = {0};
+
+/**
+ * Creates an empty pool of blocks of a size.
+ * @param blockSize Size of the blocks, a multiple of the granule.
+ */
+MemoryPool::MemoryPool(size_t blockSize) : _blockSize(blockSize), _free(0)
+{
+}
+
+/**
+ * Frees all the chunks of the pool.
+ */
+MemoryPool::~MemoryPool()
+{
+	for (std::vector<char*>::iterator i = _chunks.begin(); i != _chunks.end(); ++i)
+	{
+		::operator delete(*i);
+	}
+}
+
+/**
+ * Gets a new chunk from the heap and puts all its blocks on the free list.
+ */
+void MemoryPool::grow()
+{
+	size_t blocks = CHUNK / _blockSize;
+	char *chunk = static_cast<char*>(::operator new(blocks * _blockSize));
+	_chunks.push_back(chunk);
+	for (size_t i = 0; i < blocks; ++i)
+	{
+		void *block = chunk + i * _blockSize;
+		*static_cast<void**>(block) = _free;
+		_free = block;
+	}
+}
+
+/**
+ * Gets memory for an object from the pool for its size.
+ * Objects too big for any pool come from the heap.
+ * @param size Size of the object.
+ * @return Pointer to the memory.
+ */
+void *MemoryPool::allocate(size_t size)
+{
+	size_t index = (size + GRANULE - 1) / GRANULE;
+	if (index == 0)
+	{
+		index = 1;
+	}
+	if (index > (size_t)POOLS)
+	{
+		return ::operator new(size);
+	}
+	MemoryPool *&pool = _pools[index - 1];
+	if (pool == 0)
+	{
+		pool = new MemoryPool(index * GRANULE);
+	}
+	if (pool->_free == 0)
+	{
+		pool->grow();
+	}
+	void *block = pool->_free;
+	pool->_free = *static_cast<void**>(block);
+	return block;
+}
+
+/**
+ * Puts the memory of an object back on the free list of the pool it came from.
+ * @param p Pointer to the memory.
+ * @param size Size of the object, as given to allocate.
+ */
+void MemoryPool::deallocate(void *p, size_t size)
+{
+	if (p == 0)
+	{
+		return;
+	}
+	size_t index = (size + GRANULE - 1) / GRANULE;
+	if (index == 0)
+	{
+		index = 1;
+	}
+	if (index > (size_t)POOLS)
+	{
+		::operator delete(p);
+		return;
+	}
+	MemoryPool *pool = _pools[index - 1];
+	*static_cast<void**>(p) = pool->_free;
+	pool->_free = p;
+}
+
+}
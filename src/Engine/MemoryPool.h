@@ -0,0 +1,61 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_MEMORYPOOL_H
+#define OPENXCOM_MEMORYPOOL_H
+
+#include <vector>
+#include <cstddef>
+
+namespace OpenXcom
+{
+
+/**
+ * Hands out small blocks of memory carved from big chunks, one pool
+ * per block size, and keeps the blocks given back on a list to hand
+ * out again. Classes that get made and thrown away all the time during
+ * a battle use it for their operator new and delete, so a firefight
+ * reuses the same memory instead of going to the heap for every object.
+ * Only meant for the game thread, it has no locking.
+ */
+class MemoryPool
+{
+private:
+	static const size_t GRANULE = 16;
+	static const int POOLS = 128;
+	static const size_t CHUNK = 65536;
+	static MemoryPool *_pools[POOLS];
+	size_t _blockSize;
+	void *_free;
+	std::vector<char*> _chunks;
+	/// Creates a pool of blocks of a size.
+	MemoryPool(size_t blockSize);
+	/// Frees the pool's memory.
+	~MemoryPool();
+	/// Adds a chunk of blocks to the free list.
+	void grow();
+public:
+	/// Gets memory for an object.
+	static void *allocate(size_t size);
+	/// Gives back the memory of an object.
+	static void deallocate(void *p, size_t size);
+};
+
+}
+
+#endif
@@ -160,6 +160,9 @@ void createDefault()
 	setInt("battleAlienSpeed", 30); // 40, 30, 20, 10, 5, 1
 	setBool("battleInstantGrenade", false); // set to true if you want to play with the alternative grenade handling
 	setInt("battleExplosionHeight", 3); //0, 1, 2, 3
+	setBool("battleExplosionFloodFill", false); // spread explosions tile by tile instead of tracing rays
+	setBool("battleRecordPaths", false); // record the A* requests of a loaded battle to paths.log, for openxcom-battlesim paths
+	setBool("battleHierarchicalPaths", false); // search long paths between map block sized clusters first
 	setBool("battlePreviewPath", false); // requires double-click to confirm moves
 	setBool("battleRangeBasedAccuracy", false);
 	setBool("fpsCounter", false);
@@ -186,6 +189,12 @@ void createDefault()
 	setBool("allowResize", false);
 	setInt("windowedModePositionX", 3);
 	setInt("windowedModePositionY", 22);
+	setInt("battleThreads", 0); // 0 uses every processor
+	setInt("battleAIFrameBudget", 10); // milliseconds an alien can think for in one frame, 0 for no limit
+	setBool("binarySaves", true); // false writes YAML saves, for editing and debugging; both kinds load
+	setBool("compressSaves", true); // deflate the bulk of saves; both kinds load
+	setBool("autosave", true); // save in the background every geoscape day and battle turn
+	setInt("battleDeltaSaves", 10); // battle autosaves only append what changed, this many times before saving whole again
 	// controls
 	setInt("keyOk", SDLK_RETURN);
 	setInt("keyCancel", SDLK_ESCAPE);
@@ -80,6 +80,25 @@ void save(YAML::Emitter &out)
 	out << YAML::Key << "rngSeed" << YAML::Value << _seed;
 }
 
+/**
+ * Returns how many numbers have been generated
+ * since the generator was seeded.
+ * @return Count of numbers.
+ */
+long getCount()
+{
+	return _count;
+}
+
+/**
+ * Returns the seed the generator was seeded with.
+ * @return Seed.
+ */
+unsigned int getSeed()
+{
+	return _seed;
+}
+
 /**
  * Generates a random integer number within a certain range.
  * @param min Minimum number.
@@ -38,6 +38,10 @@ namespace RNG
 	void load(const YAML::Node& node);
 	/// Saves the RNG to YAML.
 	void save(YAML::Emitter& out);
+	/// Gets the count of numbers generated.
+	long getCount();
+	/// Gets the current seed.
+	unsigned int getSeed();
 	/// Generates a random integer number.
 	int generate(int min, int max);
 	/// Generates a random decimal number.
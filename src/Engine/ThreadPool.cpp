@@ -0,0 +1,168 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "ThreadPool.h"
+#include "Logger.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Starts the worker threads. The thread that runs
+ * the batches counts as one of them.
+ * @param threads Number of threads, 1 runs everything on the calling thread.
+ */
+ThreadPool::ThreadPool(int threads) : _job(0), _data(0), _count(0), _next(0), _busy(0), _batch(0), _ids(0), _quit(false)
+{
+	_mutex = SDL_CreateMutex();
+	_start = SDL_CreateCond();
+	_done = SDL_CreateCond();
+	for (int i = 1; i < threads; ++i)
+	{
+		SDL_Thread *thread = SDL_CreateThread(work, this);
+		if (thread == 0)
+		{
+			Log(LOG_WARNING) << "Couldn't start worker thread: " << SDL_GetError();
+			break;
+		}
+		_threads.push_back(thread);
+	}
+}
+
+/**
+ * Stops the worker threads and waits for them to end.
+ */
+ThreadPool::~ThreadPool()
+{
+	SDL_LockMutex(_mutex);
+	_quit = true;
+	SDL_CondBroadcast(_start);
+	SDL_UnlockMutex(_mutex);
+	for (std::vector<SDL_Thread*>::iterator i = _threads.begin(); i != _threads.end(); ++i)
+	{
+		SDL_WaitThread(*i, 0);
+	}
+	SDL_DestroyCond(_done);
+	SDL_DestroyCond(_start);
+	SDL_DestroyMutex(_mutex);
+}
+
+/**
+ * Waits for batches and works on them until the pool is stopped.
+ * @param pool Pointer to the pool.
+ * @return Thread exit code.
+ */
+int ThreadPool::work(void *pool)
+{
+	ThreadPool *self = (ThreadPool*)pool;
+	int batch = 0;
+	SDL_LockMutex(self->_mutex);
+	int thread = ++self->_ids;
+	while (true)
+	{
+		while (!self->_quit && self->_batch == batch)
+		{
+			SDL_CondWait(self->_start, self->_mutex);
+		}
+		if (self->_quit)
+		{
+			break;
+		}
+		batch = self->_batch;
+		SDL_UnlockMutex(self->_mutex);
+		self->runJobs(thread);
+		SDL_LockMutex(self->_mutex);
+		if (--self->_busy == 0)
+		{
+			SDL_CondSignal(self->_done);
+		}
+	}
+	SDL_UnlockMutex(self->_mutex);
+	return 0;
+}
+
+/**
+ * Takes the next job of the current batch until they've all been taken.
+ * @param thread Number of the thread running the jobs.
+ */
+void ThreadPool::runJobs(int thread)
+{
+	while (true)
+	{
+		SDL_LockMutex(_mutex);
+		int index = _next++;
+		SDL_UnlockMutex(_mutex);
+		if (index >= _count)
+		{
+			break;
+		}
+		_job(_data, index, thread);
+	}
+}
+
+/**
+ * Returns the number of threads that work on a batch,
+ * including the one that runs it. Jobs are numbered
+ * from 0 to one less than this.
+ * @return Number of threads.
+ */
+int ThreadPool::getThreads() const
+{
+	return _threads.size() + 1;
+}
+
+/**
+ * Runs a job for every index of a batch, split between
+ * the threads, and returns when all of them are done.
+ * Jobs run in no particular order.
+ * @param job Function to run.
+ * @param data Data passed to every job.
+ * @param count Number of jobs in the batch.
+ */
+void ThreadPool::run(ThreadJob job, void *data, int count)
+{
+	if (_threads.empty() || count <= 1)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			job(data, i, 0);
+		}
+		return;
+	}
+
+	SDL_LockMutex(_mutex);
+	_job = job;
+	_data = data;
+	_count = count;
+	_next = 0;
+	_busy = _threads.size();
+	++_batch;
+	SDL_CondBroadcast(_start);
+	SDL_UnlockMutex(_mutex);
+
+	runJobs(0);
+
+	SDL_LockMutex(_mutex);
+	while (_busy > 0)
+	{
+		SDL_CondWait(_done, _mutex);
+	}
+	SDL_UnlockMutex(_mutex);
+}
+
+}
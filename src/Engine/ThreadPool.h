@@ -0,0 +1,64 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_THREADPOOL_H
+#define OPENXCOM_THREADPOOL_H
+
+#include <vector>
+#include <SDL.h>
+
+namespace OpenXcom
+{
+
+/// A job run by the pool: gets the job data, the index of the item to work on and the number of the thread running it.
+typedef void (*ThreadJob)(void *data, int index, int thread);
+
+/**
+ * A fixed set of worker threads that split a batch of
+ * independent jobs between them. The calling thread
+ * works on the batch too and waits until all of it is done,
+ * so jobs must not touch anything another job writes to.
+ */
+class ThreadPool
+{
+private:
+	std::vector<SDL_Thread*> _threads;
+	SDL_mutex *_mutex;
+	SDL_cond *_start, *_done;
+	ThreadJob _job;
+	void *_data;
+	int _count, _next, _busy, _batch, _ids;
+	bool _quit;
+	/// Entry point of the worker threads.
+	static int work(void *pool);
+	/// Works on jobs until there are none left.
+	void runJobs(int thread);
+public:
+	/// Creates a pool with a number of threads.
+	ThreadPool(int threads);
+	/// Stops the threads and cleans up the pool.
+	~ThreadPool();
+	/// Gets the number of threads working on a batch.
+	int getThreads() const;
+	/// Runs a batch of jobs.
+	void run(ThreadJob job, void *data, int count);
+};
+
+}
+
+#endif
@@ -37,6 +37,8 @@
 #include "../Savegame/GameTime.h"
 #include "../Engine/Music.h"
 #include "../Savegame/SavedGame.h"
+#include "../Savegame/SaveWriter.h"
+#include "../Menu/ErrorMessageState.h"
 #include "../Ruleset/Ruleset.h"
 #include "../Savegame/Base.h"
 #include "../Savegame/BaseFacility.h"
@@ -456,6 +458,13 @@ void GeoscapeState::think()
 			_popups.erase(_popups.begin());
 		}
 	}
+	std::string error;
+	if (_game->getSaveWriter()->update(&error))
+	{
+		std::wstringstream message;
+		message << _game->getLanguage()->getString("STR_SAVE_UNSUCCESSFUL") << L'\x02' << Language::utf8ToWstr(error);
+		popup(new ErrorMessageState(_game, message.str(), Palette::blockOffset(8)+10, "BACK01.SCR", 6));
+	}
 	if (_minimizedDogfights == 0 && _dogfights.empty() &&_battleMusic)
 	{
 		_battleMusic = false;
@@ -1469,6 +1478,11 @@ void GeoscapeState::time1Day()
 	// Handle resupply of alien bases.
 	std::for_each(_game->getSavedGame()->getAlienBases()->begin(), _game->getSavedGame()->getAlienBases()->end(),
 		      GenerateSupplyMission(*_game->getRuleset(), *_game->getSavedGame()));
+
+	if (Options::getBool("autosave"))
+	{
+		_game->getSaveWriter()->save(_game->getSavedGame(), "autosave_geoscape");
+	}
 }
 
 /**
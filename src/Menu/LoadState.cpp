@@ -32,6 +32,7 @@
 #include "../Geoscape/GeoscapeState.h"
 #include "ErrorMessageState.h"
 #include "../Battlescape/BattlescapeState.h"
+#include "../Battlescape/Pathfinding.h"
 #include "DeleteGameState.h"
 
 namespace OpenXcom
@@ -82,6 +83,10 @@ void LoadState::lstSavesPress(Action *action)
 			if (_game->getSavedGame()->getBattleGame() != 0)
 			{
 				_game->getSavedGame()->getBattleGame()->loadMapResources(_game->getResourcePack());
+				if (Options::getBool("battleRecordPaths"))
+				{
+					_game->getSavedGame()->getBattleGame()->getPathfinding()->recordPaths(Options::getUserFolder() + "paths.log", filename);
+				}
 				_game->pushState(new BattlescapeState(_game));
 			}
 		}
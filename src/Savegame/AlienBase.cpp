@@ -19,6 +19,7 @@
 #include "AlienBase.h"
 #include <sstream>
 #include "../Engine/Language.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -76,6 +77,44 @@ void AlienBase::saveId(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the alien base from binary.
+ * @param buffer Pointer to the alien base data.
+ * @param end End of the save data.
+ */
+void AlienBase::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	Target::loadBinary(buffer, end);
+	_id = unserializeInt(buffer, end);
+	_race = unserializeString(buffer, end);
+	_inBattlescape = unserializeInt(buffer, end) != 0;
+	_discovered = unserializeInt(buffer, end) != 0;
+}
+
+/**
+ * Saves the alien base to binary.
+ * @param buffer Buffer to add the alien base to.
+ */
+void AlienBase::saveBinary(std::vector<Uint8> &buffer) const
+{
+	Target::saveBinary(buffer);
+	serializeInt(buffer, _id);
+	serializeString(buffer, _race);
+	serializeInt(buffer, _inBattlescape);
+	serializeInt(buffer, _discovered);
+}
+
+/**
+ * Saves the alien base's unique identifiers to binary.
+ * @param buffer Buffer to add the identifiers to.
+ */
+void AlienBase::saveIdBinary(std::vector<Uint8> &buffer) const
+{
+	Target::saveIdBinary(buffer);
+	serializeString(buffer, "STR_ALIEN_BASE");
+	serializeInt(buffer, _id);
+}
+
 /**
  * Returns the alien base's unique ID.
  * @return Unique ID.
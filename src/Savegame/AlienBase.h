@@ -46,6 +46,12 @@ public:
 	void save(YAML::Emitter& out) const;
 	/// Saves the alien base's ID to YAML.
 	void saveId(YAML::Emitter& out) const;
+	/// Loads the alien base from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the alien base to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
+	/// Saves the alien base's ID to binary.
+	void saveIdBinary(std::vector<Uint8> &buffer) const;
 	/// Gets the alien base's ID.
 	int getId() const;
 	/// Sets the alien base's ID.
@@ -36,6 +36,7 @@
 #include "Region.h"
 #include "Country.h"
 #include "Waypoint.h"
+#include "SerializationHelper.h"
 #include <algorithm>
 #include <functional>
 
@@ -133,6 +134,55 @@ void AlienMission::save(YAML::Emitter& out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the alien mission from binary.
+ * @param buffer Pointer to the mission data.
+ * @param end End of the save data.
+ * @param game The game data, required to locate the alien base.
+ */
+void AlienMission::loadBinary(Uint8 **buffer, const Uint8 *end, SavedGame &game)
+{
+	_region = unserializeString(buffer, end);
+	_race = unserializeString(buffer, end);
+	_nextWave = unserializeInt(buffer, end);
+	_nextUfoCounter = unserializeInt(buffer, end);
+	_spawnCountdown = unserializeInt(buffer, end);
+	_liveUfos = unserializeInt(buffer, end);
+	_uniqueID = unserializeInt(buffer, end);
+	if (unserializeInt(buffer, end))
+	{
+		int id = unserializeInt(buffer, end);
+		std::vector<AlienBase*>::const_iterator found = std::find_if(game.getAlienBases()->begin(), game.getAlienBases()->end(), matchById(id));
+		if (found == game.getAlienBases()->end())
+		{
+			throw Exception("Corrupted save: Invalid base for mission.");
+		}
+		_base = *found;
+	}
+}
+
+/**
+ * Saves the alien mission to binary, its type first
+ * for the loader to make it with.
+ * @param buffer Buffer to add the mission to.
+ */
+void AlienMission::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeString(buffer, _rule.getType());
+	serializeString(buffer, _region);
+	serializeString(buffer, _race);
+	serializeInt(buffer, _nextWave);
+	serializeInt(buffer, _nextUfoCounter);
+	serializeInt(buffer, _spawnCountdown);
+	serializeInt(buffer, _liveUfos);
+	serializeInt(buffer, _uniqueID);
+	serializeInt(buffer, _base != 0);
+	if (_base)
+	{
+		serializeInt(buffer, _base->getId());
+	}
+}
+
 const std::string &AlienMission::getType() const
 {
 	return _rule.getType();
@@ -20,6 +20,8 @@
 #define OPENXCOM_ALIEN_MISSION_H
 
 #include <string>
+#include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
 
 namespace OpenXcom
@@ -63,6 +65,10 @@ public:
 	void load(const YAML::Node& node, SavedGame &game);
 	/// Saves the mission to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads the mission from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end, SavedGame &game);
+	/// Saves the mission to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Gets the mission's type.
 	const std::string &getType() const;
 	/// Gets the mission's region.
@@ -22,6 +22,7 @@
 #include "../Engine/RNG.h"
 #include "../Ruleset/Ruleset.h"
 #include "../Ruleset/RuleRegion.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -116,6 +117,46 @@ void AlienStrategy::save(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the data from binary.
+ * @param buffer Pointer to the alien data.
+ * @param end End of the save data.
+ */
+void AlienStrategy::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	// Free allocated memory.
+	for (MissionsByRegion::iterator ii = _regionMissions.begin(); ii != _regionMissions.end(); ++ii)
+	{
+		delete ii->second;
+	}
+	_regionMissions.clear();
+	_regionChances.clear();
+	_regionChances.loadBinary(buffer, end);
+	int regions = unserializeInt(buffer, end);
+	for (int i = 0; i < regions; ++i)
+	{
+		std::string region = unserializeString(buffer, end);
+		std::auto_ptr<WeightedOptions> options(new WeightedOptions());
+		options->loadBinary(buffer, end);
+		_regionMissions.insert(std::make_pair(region, options.release()));
+	}
+}
+
+/**
+ * Saves the alien data to binary.
+ * @param buffer Buffer to add the alien data to.
+ */
+void AlienStrategy::saveBinary(std::vector<Uint8> &buffer) const
+{
+	_regionChances.saveBinary(buffer);
+	serializeInt(buffer, _regionMissions.size());
+	for (MissionsByRegion::const_iterator ii = _regionMissions.begin(); ii != _regionMissions.end(); ++ii)
+	{
+		serializeString(buffer, ii->first);
+		ii->second->saveBinary(buffer);
+	}
+}
+
 /**
  * Choose one of the regions for a mission.
  * @return The region id.
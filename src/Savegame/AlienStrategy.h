@@ -42,6 +42,10 @@ public:
 	void load(const Ruleset *rules, const YAML::Node& node);
 	/// Saves the data to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads the data from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the data to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Choose a random region for a regular mission.
 	const std::string &chooseRandomRegion() const;
 	/// Choose a random mission for a region.
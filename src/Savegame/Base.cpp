@@ -38,6 +38,7 @@
 #include "Ufo.h"
 #include "../Engine/RNG.h"
 #include "../Engine/Options.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -269,6 +270,151 @@ void Base::saveId(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the base from binary.
+ * @param buffer Pointer to the base data.
+ * @param end End of the save data.
+ * @param save Pointer to saved game.
+ */
+void Base::loadBinary(Uint8 **buffer, const Uint8 *end, SavedGame *save)
+{
+	Target::loadBinary(buffer, end);
+	_name = Language::utf8ToWstr(unserializeString(buffer, end));
+
+	int facilities = unserializeInt(buffer, end);
+	for (int i = 0; i < facilities; ++i)
+	{
+		BaseFacility *f = new BaseFacility(_rule->getBaseFacility(unserializeString(buffer, end)), this);
+		f->loadBinary(buffer, end);
+		_facilities.push_back(f);
+	}
+
+	int crafts = unserializeInt(buffer, end);
+	for (int i = 0; i < crafts; ++i)
+	{
+		Craft *c = new Craft(_rule->getCraft(unserializeString(buffer, end)), this);
+		c->loadBinary(buffer, end, _rule, save);
+		_crafts.push_back(c);
+	}
+
+	int soldiers = unserializeInt(buffer, end);
+	for (int i = 0; i < soldiers; ++i)
+	{
+		Craft *craft = 0;
+		if (unserializeInt(buffer, end))
+		{
+			std::string type;
+			int id;
+			Target::loadIdBinary(buffer, end, &type, &id);
+			for (std::vector<Craft*>::iterator j = _crafts.begin(); j != _crafts.end(); ++j)
+			{
+				if ((*j)->getRules()->getType() == type && (*j)->getId() == id)
+				{
+					craft = *j;
+					break;
+				}
+			}
+		}
+		Soldier *s = new Soldier(_rule->getSoldier("XCOM"), _rule->getArmor("STR_NONE_UC"));
+		s->loadBinary(buffer, end, _rule);
+		s->setCraft(craft);
+		_soldiers.push_back(s);
+	}
+
+	_items->loadBinary(buffer, end);
+	_scientists = unserializeInt(buffer, end);
+	_engineers = unserializeInt(buffer, end);
+	_inBattlescape = unserializeInt(buffer, end) != 0;
+
+	int transfers = unserializeInt(buffer, end);
+	for (int i = 0; i < transfers; ++i)
+	{
+		Transfer *t = new Transfer(unserializeInt(buffer, end));
+		t->loadBinary(buffer, end, this, _rule);
+		_transfers.push_back(t);
+	}
+
+	int research = unserializeInt(buffer, end);
+	for (int i = 0; i < research; ++i)
+	{
+		ResearchProject *r = new ResearchProject(_rule->getResearch(unserializeString(buffer, end)));
+		r->loadBinary(buffer, end);
+		_research.push_back(r);
+	}
+
+	int productions = unserializeInt(buffer, end);
+	for (int i = 0; i < productions; ++i)
+	{
+		Production *p = new Production(_rule->getManufacture(unserializeString(buffer, end)), 0);
+		p->loadBinary(buffer, end);
+		_productions.push_back(p);
+	}
+
+	_retaliationTarget = unserializeInt(buffer, end) != 0;
+}
+
+/**
+ * Saves the base to binary. The crafts go before the soldiers,
+ * so the loader has them to put the soldiers back in.
+ * @param buffer Buffer to add the base to.
+ */
+void Base::saveBinary(std::vector<Uint8> &buffer) const
+{
+	Target::saveBinary(buffer);
+	serializeString(buffer, Language::wstrToUtf8(_name));
+	serializeInt(buffer, _facilities.size());
+	for (std::vector<BaseFacility*>::const_iterator i = _facilities.begin(); i != _facilities.end(); ++i)
+	{
+		(*i)->saveBinary(buffer);
+	}
+	serializeInt(buffer, _crafts.size());
+	for (std::vector<Craft*>::const_iterator i = _crafts.begin(); i != _crafts.end(); ++i)
+	{
+		(*i)->saveBinary(buffer);
+	}
+	serializeInt(buffer, _soldiers.size());
+	for (std::vector<Soldier*>::const_iterator i = _soldiers.begin(); i != _soldiers.end(); ++i)
+	{
+		serializeInt(buffer, (*i)->getCraft() != 0);
+		if ((*i)->getCraft() != 0)
+		{
+			(*i)->getCraft()->saveIdBinary(buffer);
+		}
+		(*i)->saveBinary(buffer);
+	}
+	_items->saveBinary(buffer);
+	serializeInt(buffer, _scientists);
+	serializeInt(buffer, _engineers);
+	serializeInt(buffer, _inBattlescape);
+	serializeInt(buffer, _transfers.size());
+	for (std::vector<Transfer*>::const_iterator i = _transfers.begin(); i != _transfers.end(); ++i)
+	{
+		(*i)->saveBinary(buffer);
+	}
+	serializeInt(buffer, _research.size());
+	for (std::vector<ResearchProject*>::const_iterator i = _research.begin(); i != _research.end(); ++i)
+	{
+		(*i)->saveBinary(buffer);
+	}
+	serializeInt(buffer, _productions.size());
+	for (std::vector<Production*>::const_iterator i = _productions.begin(); i != _productions.end(); ++i)
+	{
+		(*i)->saveBinary(buffer);
+	}
+	serializeInt(buffer, _retaliationTarget);
+}
+
+/**
+ * Saves the base's unique identifiers to binary.
+ * @param buffer Buffer to add the identifiers to.
+ */
+void Base::saveIdBinary(std::vector<Uint8> &buffer) const
+{
+	Target::saveIdBinary(buffer);
+	serializeString(buffer, "STR_BASE");
+	serializeInt(buffer, 0);
+}
+
 /**
  * Returns the custom name for the base.
  * @param lang Language to get strings from.
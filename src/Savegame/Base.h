@@ -72,6 +72,12 @@ public:
 	void save(YAML::Emitter& out) const;
 	/// Saves the base's ID to YAML.
 	void saveId(YAML::Emitter& out) const;
+	/// Loads the base from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end, SavedGame *save);
+	/// Saves the base to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
+	/// Saves the base's ID to binary.
+	void saveIdBinary(std::vector<Uint8> &buffer) const;
 	/// Gets the base's name.
 	std::wstring getName(Language* lang = 0) const;
 	/// Sets the base's name.
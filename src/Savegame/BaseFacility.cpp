@@ -19,6 +19,7 @@
 #include "BaseFacility.h"
 #include "../Ruleset/RuleBaseFacility.h"
 #include "Base.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -64,6 +65,31 @@ void BaseFacility::save(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the base facility from binary.
+ * @param buffer Pointer to the base facility data.
+ * @param end End of the save data.
+ */
+void BaseFacility::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	_x = unserializeInt(buffer, end);
+	_y = unserializeInt(buffer, end);
+	_buildTime = unserializeInt(buffer, end);
+}
+
+/**
+ * Saves the base facility to binary, its type first
+ * for the loader to make it with.
+ * @param buffer Buffer to add the base facility to.
+ */
+void BaseFacility::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeString(buffer, _rules->getType());
+	serializeInt(buffer, _x);
+	serializeInt(buffer, _y);
+	serializeInt(buffer, _buildTime);
+}
+
 /**
  * Returns the ruleset for the base facility's type.
  * @return Pointer to ruleset.
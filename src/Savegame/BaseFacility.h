@@ -19,6 +19,8 @@
 #ifndef OPENXCOM_BASEFACILITY_H
 #define OPENXCOM_BASEFACILITY_H
 
+#include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
 
 namespace OpenXcom
@@ -49,6 +51,10 @@ public:
 	void load(const YAML::Node& node);
 	/// Saves the base facility to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads the base facility from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the base facility to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Gets the facility's ruleset.
 	RuleBaseFacility *getRules() const;
 	/// Gets the facility's X position.
@@ -21,6 +21,7 @@
 #include "Tile.h"
 #include "../Ruleset/RuleItem.h"
 #include "../Ruleset/RuleInventory.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -138,6 +139,38 @@ void BattleItem::save(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the item from binary. Its slot, owner, tile and ammo
+ * are matched up by the battle, like when loading from YAML.
+ * @param buffer Pointer to the item data.
+ * @param end End of the save data.
+ */
+void BattleItem::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	_inventoryX = unserializeInt(buffer, end);
+	_inventoryY = unserializeInt(buffer, end);
+	_ammoQuantity = unserializeInt(buffer, end);
+	_painKiller = unserializeInt(buffer, end);
+	_heal = unserializeInt(buffer, end);
+	_stimulant = unserializeInt(buffer, end);
+	_explodeTurn = unserializeInt(buffer, end);
+}
+
+/**
+ * Saves the item's own fields to binary.
+ * @param buffer Buffer to add the item to.
+ */
+void BattleItem::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeInt(buffer, _inventoryX);
+	serializeInt(buffer, _inventoryY);
+	serializeInt(buffer, _ammoQuantity);
+	serializeInt(buffer, _painKiller);
+	serializeInt(buffer, _heal);
+	serializeInt(buffer, _stimulant);
+	serializeInt(buffer, _explodeTurn);
+}
+
 /**
  * Returns the ruleset for the item's type.
  * @return Pointer to ruleset.
@@ -20,7 +20,10 @@
 #define OPENXCOM_BATTLEITEM_H
 
 #include "../Battlescape/Position.h"
+#include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
+#include "../Engine/MemoryPool.h"
 
 namespace OpenXcom
 {
@@ -56,10 +59,18 @@ public:
 	BattleItem(RuleItem *rules, int *id);
 	/// Cleans up the item.
 	~BattleItem();
+	/// Gets the memory for an item from the pool.
+	static void *operator new(size_t size) { return MemoryPool::allocate(size); }
+	/// Gives the memory of an item back to the pool.
+	static void operator delete(void *p, size_t size) { MemoryPool::deallocate(p, size); }
 	/// Loads the item from YAML.
 	void load(const YAML::Node& node);
 	/// Saves the item to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads the item from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the item to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Gets the item's ruleset.
 	RuleItem *getRules() const;
 	/// Gets the item's ammo quantity
@@ -35,6 +35,7 @@
 #include "../Ruleset/Ruleset.h"
 #include "Tile.h"
 #include "SavedGame.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -176,7 +177,6 @@ BattleUnit::BattleUnit(BattleUnit &b) :
 	_status(b._status),
 	_walkPhase(b._walkPhase), _fallPhase(b._fallPhase),
 	_visibleUnits(b._visibleUnits),
-	_visibleTiles(b._visibleTiles),
 	_tu(b._tu), _energy(b._energy), _health(b._health), _morale(b._morale), _stunlevel(b._stunlevel),
 	_kneeled(b._kneeled), _floating(b._floating), _dontReselect(b._dontReselect),
 	//int _currentArmor[5];
@@ -343,6 +343,86 @@ void BattleUnit::save(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the unit from binary. The AI state is loaded by the battle,
+ * once all the units it could point at are there.
+ * @param buffer Pointer to the unit data, after what the battle needs to create it.
+ * @param end End of the save data.
+ */
+void BattleUnit::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	_id = unserializeInt(buffer, end);
+	_faction = (UnitFaction)unserializeInt(buffer, end);
+	_originalFaction = (UnitFaction)unserializeInt(buffer, end);
+	_killedBy = (UnitFaction)unserializeInt(buffer, end);
+	_status = (UnitStatus)unserializeInt(buffer, end);
+	_pos.x = unserializeInt(buffer, end);
+	_pos.y = unserializeInt(buffer, end);
+	_pos.z = unserializeInt(buffer, end);
+	_direction = unserializeInt(buffer, end);
+	_directionTurret = unserializeInt(buffer, end);
+	_tu = unserializeInt(buffer, end);
+	_health = unserializeInt(buffer, end);
+	_stunlevel = unserializeInt(buffer, end);
+	_energy = unserializeInt(buffer, end);
+	_morale = unserializeInt(buffer, end);
+	_kneeled = unserializeInt(buffer, end) != 0;
+	_floating = unserializeInt(buffer, end) != 0;
+	for (int i = 0; i < 5; ++i)
+		_currentArmor[i] = unserializeInt(buffer, end);
+	for (int i = 0; i < 6; ++i)
+		_fatalWounds[i] = unserializeInt(buffer, end);
+	_expBravery = unserializeInt(buffer, end);
+	_expReactions = unserializeInt(buffer, end);
+	_expFiring = unserializeInt(buffer, end);
+	_expThrowing = unserializeInt(buffer, end);
+	_expPsiSkill = unserializeInt(buffer, end);
+	_expMelee = unserializeInt(buffer, end);
+	_turretType = unserializeInt(buffer, end);
+	_visible = unserializeInt(buffer, end) != 0;
+	_turnsExposed = unserializeInt(buffer, end);
+	_charging = 0;
+}
+
+/**
+ * Saves the unit to binary, the same fields the YAML save has
+ * apart from the ones only there to read it.
+ * @param buffer Buffer to add the unit to.
+ */
+void BattleUnit::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeInt(buffer, _id);
+	serializeInt(buffer, _faction);
+	serializeInt(buffer, _originalFaction);
+	serializeInt(buffer, _killedBy);
+	serializeInt(buffer, _status);
+	serializeInt(buffer, _pos.x);
+	serializeInt(buffer, _pos.y);
+	serializeInt(buffer, _pos.z);
+	serializeInt(buffer, _direction);
+	serializeInt(buffer, _directionTurret);
+	serializeInt(buffer, _tu);
+	serializeInt(buffer, _health);
+	serializeInt(buffer, _stunlevel);
+	serializeInt(buffer, _energy);
+	serializeInt(buffer, _morale);
+	serializeInt(buffer, _kneeled);
+	serializeInt(buffer, _floating);
+	for (int i = 0; i < 5; ++i)
+		serializeInt(buffer, _currentArmor[i]);
+	for (int i = 0; i < 6; ++i)
+		serializeInt(buffer, _fatalWounds[i]);
+	serializeInt(buffer, _expBravery);
+	serializeInt(buffer, _expReactions);
+	serializeInt(buffer, _expFiring);
+	serializeInt(buffer, _expThrowing);
+	serializeInt(buffer, _expPsiSkill);
+	serializeInt(buffer, _expMelee);
+	serializeInt(buffer, _turretType);
+	serializeInt(buffer, _visible);
+	serializeInt(buffer, _turnsExposed);
+}
+
 /**
  * Returns the BattleUnit's unique ID.
  * @return Unique ID.
@@ -1211,39 +1291,6 @@ void BattleUnit::clearVisibleUnits()
 	_visibleUnits.clear();
 }
 
-/**
- * Add this unit to the list of visible tiles. Returns true if this is a new one.
- * @param tile
- * @return
- */
-bool BattleUnit::addToVisibleTiles(Tile *tile)
-{
-	_visibleTiles.push_back(tile);
-	return true;
-}
-
-/**
- * Get the pointer to the vector of visible tiles.
- * @return pointer to vector.
- */
-std::vector<Tile*> *BattleUnit::getVisibleTiles()
-{
-	return &_visibleTiles;
-}
-
-/**
- * Clear visible tiles.
- */
-void BattleUnit::clearVisibleTiles()
-{
-	for (std::vector<Tile*>::iterator j = _visibleTiles.begin(); j != _visibleTiles.end(); ++j)
-	{
-		(*j)->setVisible(-1);
-	}
-
-	_visibleTiles.clear();
-}
-
 /**
  * Calculate firing accuracy.
  * Formula = accuracyStat * weaponAccuracy * kneelingbonus(1.15) * one-handPenalty(0.8) * woundsPenalty(% health) * critWoundsPenalty (-10%/wound)
@@ -21,6 +21,7 @@
 
 #include <vector>
 #include <string>
+#include <SDL_types.h>
 #include "../Battlescape/Position.h"
 #include "../Battlescape/BattlescapeGame.h"
 #include "../Ruleset/RuleItem.h"
@@ -28,6 +29,7 @@
 #include "../Ruleset/MapData.h"
 #include "../Ruleset/Ruleset.h"
 #include "Soldier.h"
+#include "../Engine/MemoryPool.h"
 
 namespace OpenXcom
 {
@@ -71,7 +73,6 @@ private:
 	UnitStatus _status;
 	int _walkPhase, _fallPhase;
 	std::vector<BattleUnit *> _visibleUnits;
-	std::vector<Tile *> _visibleTiles;
 	int _tu, _energy, _health, _morale, _stunlevel;
 	bool _kneeled, _floating, _dontReselect;
 	int _currentArmor[5];
@@ -117,10 +118,18 @@ public:
 	BattleUnit(BattleUnit&);
 	/// Cleans up the BattleUnit.
 	~BattleUnit();
+	/// Gets the memory for a unit from the pool.
+	static void *operator new(size_t size) { return MemoryPool::allocate(size); }
+	/// Gives the memory of a unit back to the pool.
+	static void operator delete(void *p, size_t size) { MemoryPool::deallocate(p, size); }
 	/// Loads the unit from YAML.
 	void load(const YAML::Node& node);
 	/// Saves the unit to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads the unit from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the unit to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Gets the BattleUnit's ID.
 	int getId() const;
 	/// Sets the unit's position
@@ -217,12 +226,6 @@ public:
 	std::vector<BattleUnit*> *getVisibleUnits();
 	/// Clear visible units.
 	void clearVisibleUnits();
-	/// Add unit to visible tiles.
-	bool addToVisibleTiles(Tile *tile);
-	/// Get the list of visible tiles.
-	std::vector<Tile*> *getVisibleTiles();
-	/// Clear visible tiles.
-	void clearVisibleTiles();
 	/// Calculate firing accuracy.
 	double getFiringAccuracy(BattleActionType actionType, BattleItem *item);
 	/// Calculate accuracy modifier.
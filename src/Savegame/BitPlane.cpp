@@ -0,0 +1,76 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "BitPlane.h"
+#include <cstring>
+
+namespace OpenXcom
+{
+
+/**
+ * Creates a bit plane without any bits.
+ */
+BitPlane::BitPlane() : _size(0)
+{
+}
+
+/**
+ *
+ */
+BitPlane::~BitPlane()
+{
+}
+
+/**
+ * Resizes the bit plane to hold a number of bits, all of them cleared.
+ * @param size Number of bits.
+ */
+void BitPlane::resize(int size)
+{
+	_size = size;
+	_words.assign((size + 31) / 32, 0);
+}
+
+/**
+ * Clears all the bits of the plane.
+ */
+void BitPlane::clear()
+{
+	if (!_words.empty())
+	{
+		memset(&_words[0], 0, _words.size() * sizeof(Uint32));
+	}
+}
+
+/**
+ * Sets all the bits of the plane.
+ */
+void BitPlane::fill()
+{
+	if (!_words.empty())
+	{
+		memset(&_words[0], 0xFF, _words.size() * sizeof(Uint32));
+		// keep the unused bits of the last word clear
+		if (_size % 32)
+		{
+			_words.back() = (1u << (_size % 32)) - 1;
+		}
+	}
+}
+
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_BITPLANE_H
+#define OPENXCOM_BITPLANE_H
+
+#include <vector>
+#include <SDL_types.h>
+
+namespace OpenXcom
+{
+
+/**
+ * One bit for every tile of the battlescape, packed into words
+ * so whole planes can be cleared and filled a word at a time.
+ */
+class BitPlane
+{
+private:
+	std::vector<Uint32> _words;
+	int _size;
+public:
+	/// Creates an empty bit plane.
+	BitPlane();
+	/// Cleans up the bit plane.
+	~BitPlane();
+	/// Resizes the bit plane, clearing all bits.
+	void resize(int size);
+	/// Gets the number of bits.
+	int size() const { return _size; }
+	/// Gets a bit.
+	bool get(int index) const { return (_words[index >> 5] >> (index & 31)) & 1; }
+	/// Sets a bit.
+	void set(int index) { _words[index >> 5] |= 1u << (index & 31); }
+	/// Clears a bit.
+	void reset(int index) { _words[index >> 5] &= ~(1u << (index & 31)); }
+	/// Clears all bits.
+	void clear();
+	/// Sets all bits.
+	void fill();
+};
+
+}
+
+#endif
@@ -19,6 +19,7 @@
 #include "Country.h"
 #include "../Ruleset/RuleCountry.h"
 #include "../Engine/RNG.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -74,6 +75,35 @@ void Country::save(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the country from binary.
+ * @param buffer Pointer to the country data.
+ * @param end End of the save data.
+ */
+void Country::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	_funding = unserializeIntList(buffer, end);
+	_activityXcom = unserializeIntList(buffer, end);
+	_activityAlien = unserializeIntList(buffer, end);
+	_pact = unserializeInt(buffer, end) != 0;
+	_newPact = unserializeInt(buffer, end) != 0;
+}
+
+/**
+ * Saves the country to binary, its type first
+ * for the loader to make it with.
+ * @param buffer Buffer to add the country to.
+ */
+void Country::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeString(buffer, _rules->getType());
+	serializeIntList(buffer, _funding);
+	serializeIntList(buffer, _activityXcom);
+	serializeIntList(buffer, _activityAlien);
+	serializeInt(buffer, _pact);
+	serializeInt(buffer, _newPact);
+}
+
 /**
  * Returns the ruleset for the country's type.
  * @return Pointer to ruleset.
@@ -19,6 +19,8 @@
 #ifndef OPENXCOM_COUNTRY_H
 #define OPENXCOM_COUNTRY_H
 
+#include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
 
 namespace OpenXcom
@@ -47,6 +49,10 @@ public:
 	void load(const YAML::Node& node);
 	/// Saves the country to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads the country from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the country to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Gets the country's ruleset.
 	RuleCountry *getRules() const;
 	/// Gets the country's funding.
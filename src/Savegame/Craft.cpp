@@ -35,6 +35,7 @@
 #include "AlienBase.h"
 #include "Vehicle.h"
 #include "../Ruleset/RuleItem.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -94,54 +95,7 @@ void Craft::load(const YAML::Node &node, const Ruleset *rule, SavedGame *save)
 		int id;
 		(*pName)["type"] >> type;
 		(*pName)["id"] >> id;
-		if (type == "STR_BASE")
-		{
-			returnToBase();
-		}
-		else if (type == "STR_UFO")
-		{
-			for (std::vector<Ufo*>::iterator i = save->getUfos()->begin(); i != save->getUfos()->end(); ++i)
-			{
-				if ((*i)->getId() == id)
-				{
-					setDestination(*i);
-					break;
-				}
-			}
-		}
-		else if (type == "STR_WAYPOINT")
-		{
-			for (std::vector<Waypoint*>::iterator i = save->getWaypoints()->begin(); i != save->getWaypoints()->end(); ++i)
-			{
-				if ((*i)->getId() == id)
-				{
-					setDestination(*i);
-					break;
-				}
-			}
-		}
-		else if (type == "STR_TERROR_SITE")
-		{
-			for (std::vector<TerrorSite*>::iterator i = save->getTerrorSites()->begin(); i != save->getTerrorSites()->end(); ++i)
-			{
-				if ((*i)->getId() == id)
-				{
-					setDestination(*i);
-					break;
-				}
-			}
-		}
-		else if (type == "STR_ALIEN_BASE")
-		{
-			for (std::vector<AlienBase*>::iterator i = save->getAlienBases()->begin(); i != save->getAlienBases()->end(); ++i)
-			{
-				if ((*i)->getId() == id)
-				{
-					setDestination(*i);
-					break;
-				}
-			}
-		}
+		loadDestination(type, id, save);
 	}
 
 	unsigned int j = 0;
@@ -181,6 +135,65 @@ void Craft::load(const YAML::Node &node, const Ruleset *rule, SavedGame *save)
 		setSpeed(0);
 }
 
+/**
+ * Finds the destination of the craft being loaded by its
+ * type and ID. Destinations that are gone are left unset.
+ * @param type Type of target.
+ * @param id ID of the target.
+ * @param save The game the targets are in.
+ */
+void Craft::loadDestination(const std::string &type, int id, SavedGame *save)
+{
+	if (type == "STR_BASE")
+	{
+		returnToBase();
+	}
+	else if (type == "STR_UFO")
+	{
+		for (std::vector<Ufo*>::iterator i = save->getUfos()->begin(); i != save->getUfos()->end(); ++i)
+		{
+			if ((*i)->getId() == id)
+			{
+				setDestination(*i);
+				break;
+			}
+		}
+	}
+	else if (type == "STR_WAYPOINT")
+	{
+		for (std::vector<Waypoint*>::iterator i = save->getWaypoints()->begin(); i != save->getWaypoints()->end(); ++i)
+		{
+			if ((*i)->getId() == id)
+			{
+				setDestination(*i);
+				break;
+			}
+		}
+	}
+	else if (type == "STR_TERROR_SITE")
+	{
+		for (std::vector<TerrorSite*>::iterator i = save->getTerrorSites()->begin(); i != save->getTerrorSites()->end(); ++i)
+		{
+			if ((*i)->getId() == id)
+			{
+				setDestination(*i);
+				break;
+			}
+		}
+	}
+	else if (type == "STR_ALIEN_BASE")
+	{
+		for (std::vector<AlienBase*>::iterator i = save->getAlienBases()->begin(); i != save->getAlienBases()->end(); ++i)
+		{
+			if ((*i)->getId() == id)
+			{
+				setDestination(*i);
+				break;
+			}
+		}
+	}
+}
+
 /**
  * Saves the craft to a YAML file.
  * @param out YAML emitter.
@@ -238,6 +251,107 @@ void Craft::saveId(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the craft from binary.
+ * @param buffer Pointer to the craft data.
+ * @param end End of the save data.
+ * @param rule Ruleset for the saved game.
+ * @param save The game the craft's destination is in.
+ */
+void Craft::loadBinary(Uint8 **buffer, const Uint8 *end, const Ruleset *rule, SavedGame *save)
+{
+	MovingTarget::loadBinary(buffer, end);
+	_id = unserializeInt(buffer, end);
+	_fuel = unserializeInt(buffer, end);
+	_damage = unserializeInt(buffer, end);
+
+	if (unserializeInt(buffer, end))
+	{
+		std::string type;
+		int id;
+		Target::loadIdBinary(buffer, end, &type, &id);
+		loadDestination(type, id, save);
+	}
+
+	unsigned int j = 0;
+	int weapons = unserializeInt(buffer, end);
+	for (int i = 0; i < weapons; ++i)
+	{
+		if (unserializeInt(buffer, end))
+		{
+			CraftWeapon *w = new CraftWeapon(rule->getCraftWeapon(unserializeString(buffer, end)), 0);
+			w->loadBinary(buffer, end);
+			_weapons[j++] = w;
+		}
+	}
+
+	_items->loadBinary(buffer, end);
+	int vehicles = unserializeInt(buffer, end);
+	for (int i = 0; i < vehicles; ++i)
+	{
+		Vehicle *v = new Vehicle(rule->getItem(unserializeString(buffer, end)), 0);
+		v->loadBinary(buffer, end);
+		_vehicles.push_back(v);
+	}
+	_status = unserializeString(buffer, end);
+	_lowFuel = unserializeInt(buffer, end) != 0;
+	_inBattlescape = unserializeInt(buffer, end) != 0;
+	_interceptionOrder = unserializeInt(buffer, end);
+	_name = Language::utf8ToWstr(unserializeString(buffer, end));
+	if (_inBattlescape)
+		setSpeed(0);
+}
+
+/**
+ * Saves the craft to binary, its type first for the loader
+ * to make it with. Like in YAML, dogfights aren't saved.
+ * @param buffer Buffer to add the craft to.
+ */
+void Craft::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeString(buffer, _rules->getType());
+	MovingTarget::saveBinary(buffer);
+	serializeInt(buffer, _id);
+	serializeInt(buffer, _fuel);
+	serializeInt(buffer, _damage);
+	serializeInt(buffer, _dest != 0);
+	if (_dest != 0)
+	{
+		_dest->saveIdBinary(buffer);
+	}
+	serializeInt(buffer, _weapons.size());
+	for (std::vector<CraftWeapon*>::const_iterator i = _weapons.begin(); i != _weapons.end(); ++i)
+	{
+		serializeInt(buffer, *i != 0);
+		if (*i != 0)
+		{
+			(*i)->saveBinary(buffer);
+		}
+	}
+	_items->saveBinary(buffer);
+	serializeInt(buffer, _vehicles.size());
+	for (std::vector<Vehicle*>::const_iterator i = _vehicles.begin(); i != _vehicles.end(); ++i)
+	{
+		(*i)->saveBinary(buffer);
+	}
+	serializeString(buffer, _status);
+	serializeInt(buffer, _lowFuel);
+	serializeInt(buffer, _inBattlescape);
+	serializeInt(buffer, _interceptionOrder);
+	serializeString(buffer, Language::wstrToUtf8(_name));
+}
+
+/**
+ * Saves the craft's unique identifiers to binary.
+ * @param buffer Buffer to add the identifiers to.
+ */
+void Craft::saveIdBinary(std::vector<Uint8> &buffer) const
+{
+	MovingTarget::saveIdBinary(buffer);
+	serializeString(buffer, _rules->getType());
+	serializeInt(buffer, _id);
+}
+
 /**
  * Returns the ruleset for the craft's type.
  * @return Pointer to ruleset.
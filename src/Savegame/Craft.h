@@ -55,6 +55,9 @@ private:
 	bool _inBattlescape;
 	bool _inDogfight;
 	std::wstring _name;
+
+	/// Finds the destination of the craft being loaded.
+	void loadDestination(const std::string &type, int id, SavedGame *save);
 public:
 	/// Creates a craft of the specified type.
 	Craft(RuleCraft *rules, Base *base, int id = 0);
@@ -66,6 +69,12 @@ public:
 	void save(YAML::Emitter& out) const;
 	/// Saves the craft's ID to YAML.
 	void saveId(YAML::Emitter& out) const;
+	/// Loads the craft from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end, const Ruleset *rule, SavedGame *save);
+	/// Saves the craft to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
+	/// Saves the craft's ID to binary.
+	void saveIdBinary(std::vector<Uint8> &buffer) const;
 	/// Gets the craft's ruleset.
 	RuleCraft *getRules() const;
 	/// Sets the craft's ruleset.
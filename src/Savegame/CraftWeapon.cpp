@@ -19,6 +19,7 @@
 #include "CraftWeapon.h"
 #include "../Ruleset/RuleCraftWeapon.h"
 #include "CraftWeaponProjectile.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -62,6 +63,29 @@ void CraftWeapon::save(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the craft weapon from binary.
+ * @param buffer Pointer to the craft weapon data.
+ * @param end End of the save data.
+ */
+void CraftWeapon::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	_ammo = unserializeInt(buffer, end);
+	_rearming = unserializeInt(buffer, end) != 0;
+}
+
+/**
+ * Saves the craft weapon to binary, its type first
+ * for the loader to make it with.
+ * @param buffer Buffer to add the craft weapon to.
+ */
+void CraftWeapon::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeString(buffer, _rules->getType());
+	serializeInt(buffer, _ammo);
+	serializeInt(buffer, _rearming);
+}
+
 /**
  * Returns the ruleset for the craft weapon's type.
  * @return Pointer to ruleset.
@@ -20,6 +20,8 @@
 #define OPENXCOM_CRAFTWEAPON_H
 
 #include <string>
+#include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
 
 namespace OpenXcom
@@ -48,6 +50,10 @@ public:
 	void load(const YAML::Node& node);
 	/// Saves the craft weapon to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads the craft weapon from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the craft weapon to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Gets the craft weapon's ruleset.
 	RuleCraftWeapon *getRules() const;
 	/// Gets the craft weapon's ammo.
@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "EquipmentLayoutItem.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -30,6 +31,16 @@ EquipmentLayoutItem::EquipmentLayoutItem(const YAML::Node &node)
 	load(node);
 }
 
+/**
+ * Initializes a new soldier-equipment layout item from binary.
+ * @param buffer Pointer to the layout item data.
+ * @param end End of the save data.
+ */
+EquipmentLayoutItem::EquipmentLayoutItem(Uint8 **buffer, const Uint8 *end)
+{
+	loadBinary(buffer, end);
+}
+
 /**
  * Initializes a new soldier-equipment layout item.
  * @param itemType Item's type.
@@ -134,4 +145,33 @@ void EquipmentLayoutItem::save(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the soldier-equipment layout item from binary.
+ * @param buffer Pointer to the layout item data.
+ * @param end End of the save data.
+ */
+void EquipmentLayoutItem::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	_itemType = unserializeString(buffer, end);
+	_slot = unserializeString(buffer, end);
+	_slotX = unserializeInt(buffer, end);
+	_slotY = unserializeInt(buffer, end);
+	_ammoItem = unserializeString(buffer, end);
+	_explodeTurn = unserializeInt(buffer, end);
+}
+
+/**
+ * Saves the soldier-equipment layout item to binary.
+ * @param buffer Buffer to add the layout item to.
+ */
+void EquipmentLayoutItem::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeString(buffer, _itemType);
+	serializeString(buffer, _slot);
+	serializeInt(buffer, _slotX);
+	serializeInt(buffer, _slotY);
+	serializeString(buffer, _ammoItem);
+	serializeInt(buffer, _explodeTurn);
+}
+
 }
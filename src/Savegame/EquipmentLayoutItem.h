@@ -20,6 +20,8 @@
 #define OPENXCOM_EQUIPMENTLAYOUTITEM_H
 
 #include <string>
+#include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
 
 namespace OpenXcom
@@ -40,6 +42,8 @@ private:
 public:
 	/// Creates a new soldier-equipment layout item and loads its contents from YAML.
 	EquipmentLayoutItem(const YAML::Node& node);
+	/// Creates a new soldier-equipment layout item and loads its contents from binary.
+	EquipmentLayoutItem(Uint8 **buffer, const Uint8 *end);
 	/// Creates a new soldier-equipment layout item.
 	EquipmentLayoutItem(std::string itemType, std::string slot, int slotX, int slotY, std::string ammoItem, int explodeTurn);
 	/// Cleans up the soldier-equipment layout item.
@@ -60,6 +64,10 @@ public:
 	void load(const YAML::Node& node);
 	/// Saves the soldier-equipment layout item to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads the soldier-equipment layout item from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the soldier-equipment layout item to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 };
 
 }
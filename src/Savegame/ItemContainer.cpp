@@ -19,6 +19,7 @@
 #include "ItemContainer.h"
 #include "../Ruleset/Ruleset.h"
 #include "../Ruleset/RuleItem.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -55,6 +56,25 @@ void ItemContainer::save(YAML::Emitter &out) const
 	out << _qty;
 }
 
+/**
+ * Loads the item container from binary.
+ * @param buffer Pointer to the item container data.
+ * @param end End of the save data.
+ */
+void ItemContainer::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	_qty = unserializeIntMap(buffer, end);
+}
+
+/**
+ * Saves the item container to binary.
+ * @param buffer Buffer to add the item container to.
+ */
+void ItemContainer::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeIntMap(buffer, _qty);
+}
+
 /**
  * Adds an item amount to the container.
  * @param id Item ID.
@@ -21,6 +21,8 @@
 
 #include <string>
 #include <map>
+#include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
 
 namespace OpenXcom
@@ -46,6 +48,10 @@ public:
 	void load(const YAML::Node& node);
 	/// Saves the item container to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads the item container from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the item container to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Adds an item to the container.
 	void addItem(const std::string &id, int qty = 1);
 	/// Removes an item from the container.
@@ -19,6 +19,7 @@
 #define _USE_MATH_DEFINES
 #include "MovingTarget.h"
 #include <cmath>
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -76,6 +77,34 @@ void MovingTarget::save(YAML::Emitter &out) const
 	out << YAML::Key << "speed" << YAML::Value << _speed;
 }
 
+/**
+ * Loads the moving target from binary. The destination
+ * is left to the subclasses, which each find it their own way.
+ * @param buffer Pointer to the moving target data.
+ * @param end End of the save data.
+ */
+void MovingTarget::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	Target::loadBinary(buffer, end);
+	_speedLon = unserializeDouble(buffer, end);
+	_speedLat = unserializeDouble(buffer, end);
+	_speedRadian = unserializeDouble(buffer, end);
+	_speed = unserializeInt(buffer, end);
+}
+
+/**
+ * Saves the moving target to binary, all but the destination.
+ * @param buffer Buffer to add the moving target to.
+ */
+void MovingTarget::saveBinary(std::vector<Uint8> &buffer) const
+{
+	Target::saveBinary(buffer);
+	serializeDouble(buffer, _speedLon);
+	serializeDouble(buffer, _speedLat);
+	serializeDouble(buffer, _speedRadian);
+	serializeInt(buffer, _speed);
+}
+
 /**
  * Returns the destination the moving target is heading to.
  * @return Pointer to destination.
@@ -48,6 +48,10 @@ public:
 	virtual void load(const YAML::Node& node);
 	/// Saves the moving target to YAML.
 	virtual void save(YAML::Emitter& out) const;
+	/// Loads the moving target from binary.
+	virtual void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the moving target to binary.
+	virtual void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Gets the moving target's destination.
 	Target *getDestination() const;
 	/// Sets the moving target's destination.
@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "Node.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -87,6 +88,52 @@ void Node::save(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the node from binary.
+ * @param buffer Pointer to the node data.
+ * @param end End of the save data.
+ */
+void Node::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	_id = unserializeInt(buffer, end);
+	_pos.x = unserializeInt(buffer, end);
+	_pos.y = unserializeInt(buffer, end);
+	_pos.z = unserializeInt(buffer, end);
+	_type = unserializeInt(buffer, end);
+	_rank = unserializeInt(buffer, end);
+	_flags = unserializeInt(buffer, end);
+	_priority = unserializeInt(buffer, end);
+	_allocated = unserializeInt(buffer, end) != 0;
+	int links = unserializeInt(buffer, end);
+	_nodeLinks.clear();
+	for (int i = 0; i < links; ++i)
+	{
+		_nodeLinks.push_back(unserializeInt(buffer, end));
+	}
+}
+
+/**
+ * Saves the node to binary.
+ * @param buffer Buffer to add the node to.
+ */
+void Node::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeInt(buffer, _id);
+	serializeInt(buffer, _pos.x);
+	serializeInt(buffer, _pos.y);
+	serializeInt(buffer, _pos.z);
+	serializeInt(buffer, _type);
+	serializeInt(buffer, _rank);
+	serializeInt(buffer, _flags);
+	serializeInt(buffer, _priority);
+	serializeInt(buffer, _allocated);
+	serializeInt(buffer, _nodeLinks.size());
+	for (std::vector<int>::const_iterator i = _nodeLinks.begin(); i != _nodeLinks.end(); ++i)
+	{
+		serializeInt(buffer, *i);
+	}
+}
+
 /**
  * Get the node's id
  * @return unique id
@@ -20,6 +20,8 @@
 #define OPENXCOM_NODE_H
 
 #include "../Battlescape/Position.h"
+#include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
 
 namespace OpenXcom
@@ -58,6 +60,10 @@ public:
 	void load(const YAML::Node& node);
 	/// Saves the node to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads the node from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the node to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 	/// get the node's id
 	int getID() const;
 	/// get the node's paths
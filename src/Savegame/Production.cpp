@@ -26,6 +26,7 @@
 #include "../Ruleset/RuleItem.h"
 #include "../Engine/Options.h"
 #include <limits>
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -165,4 +166,29 @@ void Production::load(const YAML::Node &node)
 	setTimeSpent(spent);
 	setAmountTotal(amount);
 }
+
+/**
+ * Loads the production from binary.
+ * @param buffer Pointer to the production data.
+ * @param end End of the save data.
+ */
+void Production::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	setAssignedEngineers(unserializeInt(buffer, end));
+	setTimeSpent(unserializeInt(buffer, end));
+	setAmountTotal(unserializeInt(buffer, end));
+}
+
+/**
+ * Saves the production to binary, its item first
+ * for the loader to make it with.
+ * @param buffer Buffer to add the production to.
+ */
+void Production::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeString(buffer, _rules->getName());
+	serializeInt(buffer, _engineers);
+	serializeInt(buffer, _timeSpent);
+	serializeInt(buffer, _amount);
+}
 };
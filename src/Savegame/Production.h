@@ -19,6 +19,8 @@
 #ifndef OPENXCOM_PRODUCTION_H
 #define OPENXCOM_PRODUCTION_H
 
+#include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
 
 namespace OpenXcom
@@ -44,6 +46,8 @@ public:
 	void startItem(Base * b, SavedGame * g);
 	void save(YAML::Emitter &out);
 	void load(const YAML::Node &node);
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	void saveBinary(std::vector<Uint8> &buffer) const;
 private:
 	const RuleManufacture * _rules;
 	int _amount;
@@ -18,6 +18,7 @@
  */
 #include "Region.h"
 #include "../Ruleset/RuleRegion.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -62,6 +63,29 @@ void Region::save(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the region from binary.
+ * @param buffer Pointer to the region data.
+ * @param end End of the save data.
+ */
+void Region::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	_activityXcom = unserializeIntList(buffer, end);
+	_activityAlien = unserializeIntList(buffer, end);
+}
+
+/**
+ * Saves the region to binary, its type first
+ * for the loader to make it with.
+ * @param buffer Buffer to add the region to.
+ */
+void Region::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeString(buffer, _rules->getType());
+	serializeIntList(buffer, _activityXcom);
+	serializeIntList(buffer, _activityAlien);
+}
+
 /**
  * Returns the ruleset for the region's type.
  * @return Pointer to ruleset.
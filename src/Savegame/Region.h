@@ -20,6 +20,7 @@
 #define OPENXCOM_REGION_H
 
 #include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
 
 namespace OpenXcom
@@ -46,6 +47,10 @@ public:
 	void load(const YAML::Node& node);
 	/// Saves the region to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads the region from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the region to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Gets the region's ruleset.
 	RuleRegion *getRules() const;
 	/// add xcom activity in this region
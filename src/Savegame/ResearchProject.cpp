@@ -20,6 +20,7 @@
 #include "../Ruleset/RuleResearch.h"
 #include "../Ruleset/Ruleset.h"
 #include <algorithm>
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -136,6 +137,31 @@ void ResearchProject::save(YAML::Emitter& out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the research project from binary.
+ * @param buffer Pointer to the research project data.
+ * @param end End of the save data.
+ */
+void ResearchProject::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	setAssigned(unserializeInt(buffer, end));
+	setSpent(unserializeInt(buffer, end));
+	setCost(unserializeInt(buffer, end));
+}
+
+/**
+ * Saves the research project to binary, its project first
+ * for the loader to make it with.
+ * @param buffer Buffer to add the research project to.
+ */
+void ResearchProject::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeString(buffer, getRules()->getName());
+	serializeInt(buffer, getAssigned());
+	serializeInt(buffer, getSpent());
+	serializeInt(buffer, getCost());
+}
+
 /**
  * Return a string describing Research progress.
  * @return a string describing Research progress.
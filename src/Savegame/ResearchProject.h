@@ -19,6 +19,8 @@
 #ifndef OPENXCOM_RESEARCHPROJECT_H
 #define OPENXCOM_RESEARCHPROJECT_H
 
+#include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
 
 namespace OpenXcom
@@ -58,6 +60,10 @@ public:
 	void load(const YAML::Node& node);
 	/// save the ResearchProject to YAML
 	void save(YAML::Emitter& out) const;
+	/// Loads the research project from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the research project to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Get a string describing current progress.
 	std::string getResearchProgress () const;
 };
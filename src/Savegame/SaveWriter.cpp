@@ -0,0 +1,211 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SaveWriter.h"
+#include <memory>
+#include "../Engine/Exception.h"
+#include "../Engine/Logger.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Starts the writer thread. If it can't be started,
+ * saves are written right away on the calling thread.
+ */
+SaveWriter::SaveWriter() : _thread(0), _pending(), _busy(false), _quit(false)
+{
+	_mutex = SDL_CreateMutex();
+	_wake = SDL_CreateCond();
+	_thread = SDL_CreateThread(work, this);
+	if (_thread == 0)
+	{
+		Log(LOG_WARNING) << "Couldn't start save thread: " << SDL_GetError();
+	}
+}
+
+/**
+ * Waits for the save in progress and the ones
+ * waiting to be written, then stops the thread.
+ */
+SaveWriter::~SaveWriter()
+{
+	if (_thread != 0)
+	{
+		SDL_LockMutex(_mutex);
+		_quit = true;
+		SDL_CondSignal(_wake);
+		SDL_UnlockMutex(_mutex);
+		SDL_WaitThread(_thread, 0);
+	}
+	for (std::vector<SaveSnapshot*>::iterator i = _pending.begin(); i != _pending.end(); ++i)
+	{
+		delete *i;
+	}
+	SDL_DestroyCond(_wake);
+	SDL_DestroyMutex(_mutex);
+}
+
+/**
+ * Writes the snapshots handed over until the writer is stopped
+ * and there are none left. Failures are kept for the game thread
+ * to report, as is the info of the saves written, for the saves index.
+ * @param writer Pointer to the writer.
+ * @return Thread exit code.
+ */
+int SaveWriter::work(void *writer)
+{
+	SaveWriter *self = (SaveWriter*)writer;
+	SDL_LockMutex(self->_mutex);
+	while (true)
+	{
+		while (!self->_quit && self->_pending.empty())
+		{
+			SDL_CondWait(self->_wake, self->_mutex);
+		}
+		if (self->_pending.empty())
+		{
+			break;
+		}
+		std::auto_ptr<SaveSnapshot> snapshot(self->_pending.front());
+		self->_pending.erase(self->_pending.begin());
+		self->_busy = true;
+		SDL_UnlockMutex(self->_mutex);
+
+		std::string error;
+		try
+		{
+			SavedGame::writeSnapshot(snapshot.get());
+		}
+		catch (std::exception &e)
+		{
+			error = e.what();
+		}
+
+		SDL_LockMutex(self->_mutex);
+		self->_busy = false;
+		if (error.empty())
+		{
+			self->_written.push_back(snapshot->info);
+		}
+		else
+		{
+			self->_errors.push_back(error);
+		}
+	}
+	SDL_UnlockMutex(self->_mutex);
+	return 0;
+}
+
+/**
+ * Copies a game into a snapshot and hands it to the writer thread.
+ * A full save replaces any save to the same file still waiting to be
+ * written, a delta save has to wait for the save it was made against.
+ * @param game Game to save.
+ * @param filename Save filename.
+ * @param delta Whether to save only what changed in the battle.
+ */
+void SaveWriter::save(const SavedGame *game, const std::string &filename, bool delta)
+{
+	SaveSnapshot *snapshot = game->snapshot(filename, delta);
+	if (_thread == 0)
+	{
+		std::string error;
+		try
+		{
+			SavedGame::writeSnapshot(snapshot);
+		}
+		catch (std::exception &e)
+		{
+			error = e.what();
+		}
+		SDL_LockMutex(_mutex);
+		if (error.empty())
+			_written.push_back(snapshot->info);
+		else
+			_errors.push_back(error);
+		SDL_UnlockMutex(_mutex);
+		delete snapshot;
+		return;
+	}
+	SDL_LockMutex(_mutex);
+	if (!snapshot->append)
+	{
+		for (std::vector<SaveSnapshot*>::iterator i = _pending.begin(); i != _pending.end();)
+		{
+			if ((*i)->path == snapshot->path)
+			{
+				delete *i;
+				i = _pending.erase(i);
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+	_pending.push_back(snapshot);
+	SDL_CondSignal(_wake);
+	SDL_UnlockMutex(_mutex);
+}
+
+/**
+ * Checks if a save is waiting to be written or being written.
+ * @return True if the writer is busy.
+ */
+bool SaveWriter::isSaving()
+{
+	SDL_LockMutex(_mutex);
+	bool saving = (!_pending.empty() || _busy);
+	SDL_UnlockMutex(_mutex);
+	return saving;
+}
+
+/**
+ * Puts the saves written since the last update in the saves index,
+ * on the game thread so the index is never written by two threads,
+ * and gets the first failure to report to the player.
+ * @param error Returns the error message of a failed save.
+ * @return True if a save failed.
+ */
+bool SaveWriter::update(std::string *error)
+{
+	std::vector<SaveInfo> written;
+	std::vector<std::string> errors;
+	SDL_LockMutex(_mutex);
+	written.swap(_written);
+	errors.swap(_errors);
+	SDL_UnlockMutex(_mutex);
+
+	for (std::vector<SaveInfo>::iterator i = written.begin(); i != written.end(); ++i)
+	{
+		SavedGame::addToIndex(*i);
+	}
+	for (std::vector<std::string>::iterator i = errors.begin(); i != errors.end(); ++i)
+	{
+		Log(LOG_ERROR) << *i;
+	}
+	if (errors.empty())
+	{
+		return false;
+	}
+	*error = errors.front();
+	return true;
+}
+
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_SAVEWRITER_H
+#define OPENXCOM_SAVEWRITER_H
+
+#include <string>
+#include <vector>
+#include <SDL.h>
+#include "SavedGame.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Writes saves on a thread of its own, so the game carries on while
+ * a save is compressed and written to disk. The game is copied into
+ * a snapshot on the game thread first, which is quick, and only the
+ * snapshot is handed over. If saves come in faster than they can be
+ * written, the newest one replaces those still waiting for the same
+ * file, except for delta saves, which wait behind them.
+ */
+class SaveWriter
+{
+private:
+	SDL_Thread *_thread;
+	SDL_mutex *_mutex;
+	SDL_cond *_wake;
+	std::vector<SaveSnapshot*> _pending;
+	bool _busy, _quit;
+	std::vector<SaveInfo> _written;
+	std::vector<std::string> _errors;
+	/// Entry point of the writer thread.
+	static int work(void *writer);
+public:
+	/// Creates the writer and starts its thread.
+	SaveWriter();
+	/// Finishes the save in progress and stops the thread.
+	~SaveWriter();
+	/// Saves a game in the background.
+	void save(const SavedGame *game, const std::string &filename, bool delta = false);
+	/// Checks if a save is waiting or being written.
+	bool isSaving();
+	/// Handles the saves written since the last update.
+	bool update(std::string *error);
+};
+
+}
+
+#endif
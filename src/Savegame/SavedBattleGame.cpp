@@ -20,8 +20,11 @@
 #include "SavedBattleGame.h"
 #include "SavedGame.h"
 #include "Tile.h"
+#include "TileArena.h"
 #include "Node.h"
 #include <SDL.h>
+#include <ctime>
+#include <assert.h>
 #include "../Ruleset/MapDataSet.h"
 #include "../Battlescape/Pathfinding.h"
 #include "../Battlescape/TileEngine.h"
@@ -37,6 +40,7 @@
 #include "../Engine/Options.h"
 #include "../Engine/Logger.h"
 #include "SerializationHelper.h"
+#include "../Engine/Exception.h"
 
 namespace OpenXcom
 {
@@ -44,8 +48,10 @@ namespace OpenXcom
 /**
  * Initializes a brand new battlescape saved game.
  */
-SavedBattleGame::SavedBattleGame() : _mapsize_x(0), _mapsize_y(0), _mapsize_z(0), _tiles(), _selectedUnit(0), _lastSelectedUnit(0), _nodes(), _units(), _items(), _pathfinding(0), _tileEngine(0), _missionType(""), _globalShade(0), _side(FACTION_PLAYER), _turn(1), _debugMode(false), _aborted(false), _itemId(0), _objectiveDestroyed(false), _fallingUnits(), _unitsFalling(false), _strafeEnabled(false)
+SavedBattleGame::SavedBattleGame() : _mapsize_x(0), _mapsize_y(0), _mapsize_z(0), _tileArena(0), _tiles(0), _selectedUnit(0), _lastSelectedUnit(0), _nodes(), _units(), _items(), _pathfinding(0), _tileEngine(0), _missionType(""), _globalShade(0), _side(FACTION_PLAYER), _turn(1), _debugMode(false), _aborted(false), _itemId(0), _objectiveDestroyed(false), _fallingUnits(), _unitsFalling(false), _strafeEnabled(false)
 {
+	_deltaSaves = 0;
+	_deltaBaseId = 0;
 	_dragButton = Options::getInt("battleScrollDragButton");
 	_dragInvert = Options::getBool("battleScrollDragInvert");
 	_dragTimeTolerance = Options::getInt("battleScrollDragTimeTolerance");
@@ -58,11 +64,7 @@ SavedBattleGame::SavedBattleGame() : _mapsize_x(0), _mapsize_y(0), _mapsize_z(0)
  */
 SavedBattleGame::~SavedBattleGame()
 {
-	for (int i = 0; i < _mapsize_z * _mapsize_y * _mapsize_x; ++i)
-	{
-		delete _tiles[i];
-	}
-	delete[] _tiles;
+	delete _tileArena;
 
 	for (std::vector<Node*>::iterator i = _nodes.begin(); i != _nodes.end(); ++i)
 	{
@@ -121,7 +123,9 @@ void SavedBattleGame::load(const YAML::Node &node, Ruleset *rule, SavedGame* sav
 			(*i)["position"][0] >> pos.x;
 			(*i)["position"][1] >> pos.y;
 			(*i)["position"][2] >> pos.z;
-			getTile(pos)->load((*i));
+			Uint8 discovered;
+			getTile(pos)->load((*i), &discovered);
+			loadTileDiscovered(getTileIndex(pos), discovered);
 		}
 	} else 
 	{
@@ -142,13 +146,31 @@ void SavedBattleGame::load(const YAML::Node &node, Ruleset *rule, SavedGame* sav
 		node["binTiles"] >> binTiles;
 
 		Uint8 *r = (Uint8*)binTiles.data();
+		std::vector<Uint8> inflated;
+		if (const YAML::Node *compression = node.FindValue("tileCompression"))
+		{
+			std::string method;
+			*compression >> method;
+			if (method != "zlib")
+			{
+				throw Exception("Unknown tile compression " + method);
+			}
+			decompressData(binTiles.data(), binTiles.size(), inflated);
+			if (inflated.size() < totalTiles * serKey.totalBytes)
+			{
+				throw Exception("Save data is truncated");
+			}
+			r = &inflated[0];
+		}
 		Uint8 *dataEnd = r + totalTiles * serKey.totalBytes;
 
 		while (r < dataEnd)
 		{
 			int index = unserializeInt(&r, serKey.index);
 			assert (index < _mapsize_x * _mapsize_z * _mapsize_y);
-			_tiles[index]->loadBinary(&r, serKey);
+			Uint8 discovered;
+			_tiles[index]->loadBinary(&r, serKey, &discovered);
+			loadTileDiscovered(index, discovered);
 		}		
 	}
 
@@ -306,13 +328,11 @@ void SavedBattleGame::loadMapResources(ResourcePack *res)
 	}
 
 	initUtilities(res);
+	getTileEngine()->calculateVoxelShapes();
 	getTileEngine()->calculateSunShading();
 	getTileEngine()->calculateTerrainLighting();
 	getTileEngine()->calculateUnitLighting();
-	for (std::vector<BattleUnit*>::iterator bu = _units.begin(); bu != _units.end(); ++bu)
-	{
-		_tileEngine->calculateFOV(*bu);
-	}
+	_tileEngine->calculateFOV(_units);
 }
 
 /**
@@ -345,7 +365,7 @@ void SavedBattleGame::save(YAML::Emitter &out) const
 	{
 		if (!_tiles[i]->isVoid())
 		{
-			_tiles[i]->save(out);
+			_tiles[i]->save(out, getTileDiscovered(i));
 		}
 	}
 	out << YAML::EndSeq;
@@ -367,7 +387,7 @@ void SavedBattleGame::save(YAML::Emitter &out) const
 		if (!_tiles[i]->isVoid())
 		{
 			serializeInt(&w, Tile::serializationKey.index, i);
-			_tiles[i]->saveBinary(&w);
+			_tiles[i]->saveBinary(&w, getTileDiscovered(i));
 		}
 		else
 		{
@@ -375,8 +395,18 @@ void SavedBattleGame::save(YAML::Emitter &out) const
 		}
 	}
 	out << YAML::Key << "totalTiles" << YAML::Value << tileDataSize / Tile::serializationKey.totalBytes; // not strictly necessary, just convenient
-	out << YAML::Key << "binTiles" << YAML::Value << YAML::Binary(tileData, tileDataSize);
-    free(tileData);
+	if (Options::getBool("compressSaves") && tileDataSize != 0)
+	{
+		std::vector<Uint8> compressed;
+		compressData(tileData, tileDataSize, compressed);
+		out << YAML::Key << "tileCompression" << YAML::Value << "zlib";
+		out << YAML::Key << "binTiles" << YAML::Value << YAML::Binary(&compressed[0], compressed.size());
+	}
+	else
+	{
+		out << YAML::Key << "binTiles" << YAML::Value << YAML::Binary(tileData, tileDataSize);
+	}
+	free(tileData);
 
 
 #endif
@@ -417,6 +447,16 @@ Tile **SavedBattleGame::getTiles() const
 	return _tiles;
 }
 
+/**
+ * Gets the arena the tiles live in, which keeps the state of all tiles
+ * that passes over the whole map look at in one array per field.
+ * @return Pointer to the tile arena.
+ */
+TileArena *SavedBattleGame::getTileArena() const
+{
+	return _tileArena;
+}
+
 /**
  * Initializes the array of tiles + creates a pathfinding object.
  * @param mapsize_x
@@ -425,14 +465,9 @@ Tile **SavedBattleGame::getTiles() const
  */
 void SavedBattleGame::initMap(int mapsize_x, int mapsize_y, int mapsize_z)
 {
+	delete _tileArena;
 	if (!_nodes.empty())
 	{
-		for (int i = 0; i < _mapsize_y * _mapsize_y * _mapsize_x; ++i)
-		{
-			delete _tiles[i];
-		}
-		delete[] _tiles;
-
 		for (std::vector<Node*>::iterator i = _nodes.begin(); i != _nodes.end(); ++i)
 		{
 			delete *i;
@@ -444,15 +479,14 @@ void SavedBattleGame::initMap(int mapsize_x, int mapsize_y, int mapsize_z)
 	_mapsize_x = mapsize_x;
 	_mapsize_y = mapsize_y;
 	_mapsize_z = mapsize_z;
-	_tiles = new Tile*[_mapsize_z * _mapsize_y * _mapsize_x];
-	/* create tile objects */
-	for (int i = 0; i < _mapsize_z * _mapsize_y * _mapsize_x; ++i)
+	/* create tile objects, all in one block */
+	_tileArena = new TileArena(_mapsize_x, _mapsize_y, _mapsize_z);
+	_tiles = _tileArena->getTiles();
+	for (int i = 0; i < 3; ++i)
 	{
-		Position pos;
-		getTileCoords(i, &pos.x, &pos.y, &pos.z);
-		_tiles[i] = new Tile(pos);
+		_visibleTiles[i].resize(_mapsize_z * _mapsize_y * _mapsize_x);
+		_discoveredTiles[i].resize(_mapsize_z * _mapsize_y * _mapsize_x);
 	}
-
 }
 
 /**
@@ -568,6 +602,509 @@ void SavedBattleGame::getTileCoords(int index, int *x, int *y, int *z) const
 }
 
 
+/**
+ * Marks a tile as seen by one of a faction's units this turn.
+ * @param faction The faction.
+ * @param tile The tile.
+ */
+void SavedBattleGame::setTileVisible(UnitFaction faction, Tile *tile)
+{
+	_visibleTiles[faction].set(getTileIndex(tile->getPosition()));
+}
+
+/**
+ * Forgets which tiles the units of every faction have seen,
+ * so their field of view can be worked out again.
+ */
+void SavedBattleGame::clearVisibleTiles()
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		_visibleTiles[i].clear();
+	}
+}
+
+/**
+ * Sets whether the player has discovered a part of a tile.
+ * Discovering the content of a tile discovers its walls too.
+ * @param tile The tile.
+ * @param flag True if discovered.
+ * @param part 0-2 westwall/northwall/content+floor
+ */
+void SavedBattleGame::setTileDiscovered(Tile *tile, bool flag, int part)
+{
+	int index = getTileIndex(tile->getPosition());
+	if (_discoveredTiles[part].get(index) != flag)
+	{
+		if (flag)
+		{
+			_discoveredTiles[part].set(index);
+			if (part == 2)
+			{
+				_discoveredTiles[0].set(index);
+				_discoveredTiles[1].set(index);
+			}
+		}
+		else
+		{
+			_discoveredTiles[part].reset(index);
+		}
+		// if light on tile changes, units and objects on it change light too
+		if (tile->getUnit() != 0)
+		{
+			tile->getUnit()->setCache(0);
+		}
+	}
+}
+
+/**
+ * Gets which parts of a tile the player has discovered, the way tiles are saved.
+ * @param index Index of the tile.
+ * @return 1 westwall, 2 northwall, 4 content+floor.
+ */
+Uint8 SavedBattleGame::getTileDiscovered(int index) const
+{
+	Uint8 discovered = 0;
+	for (int part = 0; part < 3; ++part)
+	{
+		if (_discoveredTiles[part].get(index))
+		{
+			discovered |= 1 << part;
+		}
+	}
+	return discovered;
+}
+
+/**
+ * Loads the battle from the binary save format. The data is the same
+ * as the YAML save, in the same order, only without the names.
+ * A delta save is loaded on top of the base save it was made from:
+ * the map comes from the base with the tiles in the delta laid over it,
+ * everything else comes from the delta.
+ * @param buffer Pointer to the battle data.
+ * @param end End of the battle data.
+ * @param rule Ruleset for the saved game.
+ * @param savedGame Pointer to saved game.
+ * @param delta Pointer to the data of the latest delta save, if any.
+ * @param deltaEnd End of the delta save data.
+ */
+void SavedBattleGame::loadBinary(Uint8 **buffer, const Uint8 *end, Ruleset *rule, SavedGame* savedGame, Uint8 **delta, const Uint8 *deltaEnd)
+{
+	std::vector<std::string> mapDataSets;
+	int selectedUnit = loadBinaryHeader(buffer, end, &mapDataSets);
+	for (std::vector<std::string>::iterator i = mapDataSets.begin(); i != mapDataSets.end(); ++i)
+	{
+		_mapDataSets.push_back(new MapDataSet(*i));
+	}
+
+	initMap(_mapsize_x, _mapsize_y, _mapsize_z);
+	loadBinaryTiles(buffer, end);
+
+	if (delta != 0)
+	{
+		int mapsize_x = _mapsize_x, mapsize_y = _mapsize_y, mapsize_z = _mapsize_z;
+		selectedUnit = loadBinaryHeader(delta, deltaEnd, &mapDataSets);
+		if (_mapsize_x != mapsize_x || _mapsize_y != mapsize_y || _mapsize_z != mapsize_z || mapDataSets.size() != _mapDataSets.size())
+		{
+			throw Exception("Delta save doesn't match its base");
+		}
+		loadBinaryTiles(delta, deltaEnd);
+		buffer = delta;
+		end = deltaEnd;
+	}
+
+	int nodes = unserializeInt(buffer, end);
+	for (int i = 0; i < nodes; ++i)
+	{
+		Node *n = new Node();
+		n->loadBinary(buffer, end);
+		_nodes.push_back(n);
+	}
+
+	int units = unserializeInt(buffer, end);
+	for (int i = 0; i < units; ++i)
+	{
+		UnitFaction faction = (UnitFaction)unserializeInt(buffer, end);
+		int id = unserializeInt(buffer, end);
+		std::string type = unserializeString(buffer, end);
+		std::string armor = unserializeString(buffer, end);
+		BattleUnit *b;
+		if (id < BattleUnit::MAX_SOLDIER_ID) // Unit is linked to a geoscape soldier
+		{
+			b = new BattleUnit(savedGame->getSoldier(id), faction, rule);
+		}
+		else
+		{
+			b = new BattleUnit(rule->getUnit(type), faction, id, rule->getArmor(armor));
+		}
+		b->loadBinary(buffer, end);
+		_units.push_back(b);
+		if (faction == FACTION_PLAYER && b->getId() == selectedUnit)
+		{
+			_selectedUnit = b;
+		}
+	}
+
+	// the AI states come after all the units, so they can point at any of them
+	for (std::vector<BattleUnit*>::iterator i = _units.begin(); i != _units.end(); ++i)
+	{
+		std::string state = unserializeString(buffer, end);
+		BattleAIState *aiState = 0;
+		if (state == "PATROL")
+		{
+			aiState = new PatrolBAIState(this, *i, 0);
+		}
+		else if (state == "AGGRO")
+		{
+			aiState = new AggroBAIState(this, *i);
+		}
+		else if (!state.empty())
+		{
+			throw Exception("Save data has an unknown AI state " + state);
+		}
+		if (aiState)
+		{
+			aiState->loadBinary(buffer, end);
+			if ((*i)->getFaction() != FACTION_PLAYER && (*i)->getStatus() != STATUS_DEAD)
+			{
+				(*i)->setAIState(aiState);
+			}
+			else
+			{
+				delete aiState;
+			}
+		}
+	}
+	updateExposedUnits();
+	resetUnitTiles();
+
+	int items = unserializeInt(buffer, end);
+	std::vector<int> ammoItems;
+	for (int i = 0; i < items; ++i)
+	{
+		_itemId = unserializeInt(buffer, end);
+		std::string type = unserializeString(buffer, end);
+		int owner = unserializeInt(buffer, end);
+		int unit = unserializeInt(buffer, end);
+		std::string slot = unserializeString(buffer, end);
+		Position pos;
+		pos.x = unserializeInt(buffer, end);
+		pos.y = unserializeInt(buffer, end);
+		pos.z = unserializeInt(buffer, end);
+		ammoItems.push_back(unserializeInt(buffer, end));
+
+		BattleItem *item = new BattleItem(rule->getItem(type), &_itemId);
+		item->loadBinary(buffer, end);
+		if (slot != "NULL")
+			item->setSlot(rule->getInventory(slot));
+		for (std::vector<BattleUnit*>::iterator bu = _units.begin(); bu != _units.end(); ++bu)
+		{
+			if ((*bu)->getId() == owner)
+			{
+				item->moveToOwner(*bu);
+			}
+			if ((*bu)->getId() == unit)
+			{
+				item->setUnit(*bu);
+			}
+		}
+		if (item->getSlot() && item->getSlot()->getType() == INV_GROUND && pos.x != -1)
+		{
+			getTile(pos)->addItem(item, rule->getInventory("STR_GROUND"));
+		}
+		_items.push_back(item);
+	}
+
+	// tie ammo items to their weapons
+	for (size_t i = 0; i < _items.size(); ++i)
+	{
+		if (ammoItems[i] == -1)
+			continue;
+		for (std::vector<BattleItem*>::iterator ammoi = _items.begin(); ammoi != _items.end(); ++ammoi)
+		{
+			if ((*ammoi)->getId() == ammoItems[i])
+			{
+				_items[i]->setAmmoItem(*ammoi);
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * Reads the header of a binary battle save: the map size,
+ * the mission, the turn and the map data sets.
+ * @param buffer Pointer to the battle data.
+ * @param end End of the battle data.
+ * @param mapDataSets Returns the names of the map data sets.
+ * @return ID of the selected unit.
+ */
+int SavedBattleGame::loadBinaryHeader(Uint8 **buffer, const Uint8 *end, std::vector<std::string> *mapDataSets)
+{
+	_mapsize_x = unserializeInt(buffer, end);
+	_mapsize_y = unserializeInt(buffer, end);
+	_mapsize_z = unserializeInt(buffer, end);
+	_missionType = unserializeString(buffer, end);
+	_globalShade = unserializeInt(buffer, end);
+	_turn = unserializeInt(buffer, end);
+	int selectedUnit = unserializeInt(buffer, end);
+
+	mapDataSets->clear();
+	int count = unserializeInt(buffer, end);
+	for (int i = 0; i < count; ++i)
+	{
+		mapDataSets->push_back(unserializeString(buffer, end));
+	}
+	return selectedUnit;
+}
+
+/**
+ * Reads the tiles of a binary battle save. They are kept the way
+ * the YAML save keeps them, without the base64, each with its index,
+ * so a delta save can hold only some of them.
+ * @param buffer Pointer to the tile data.
+ * @param end End of the battle data.
+ */
+void SavedBattleGame::loadBinaryTiles(Uint8 **buffer, const Uint8 *end)
+{
+	Tile::SerializationKey serKey;
+	serKey.index = unserializeInt(buffer, end);
+	serKey.totalBytes = unserializeInt(buffer, end);
+	serKey._fire = unserializeInt(buffer, end);
+	serKey._smoke = unserializeInt(buffer, end);
+	serKey._mapDataID = unserializeInt(buffer, end);
+	serKey._mapDataSetID = unserializeInt(buffer, end);
+	size_t totalTiles = unserializeInt(buffer, end);
+	if ((size_t)(end - *buffer) < totalTiles * serKey.totalBytes)
+	{
+		throw Exception("Save data is truncated");
+	}
+	Uint8 *dataEnd = *buffer + totalTiles * serKey.totalBytes;
+	while (*buffer < dataEnd)
+	{
+		int index = unserializeInt(buffer, serKey.index);
+		if (index < 0 || index >= _mapsize_x * _mapsize_y * _mapsize_z)
+		{
+			throw Exception("Save data has a tile off the map");
+		}
+		Uint8 discovered;
+		_tiles[index]->loadBinary(buffer, serKey, &discovered);
+		loadTileDiscovered(index, discovered);
+	}
+}
+
+/**
+ * Saves the battle to the binary save format.
+ * @param buffer Buffer to add the battle to.
+ */
+void SavedBattleGame::saveBinary(std::vector<Uint8> &buffer) const
+{
+	std::vector<Uint8> records;
+	saveTileRecords(records);
+	saveBinary(buffer, records, 0);
+}
+
+/**
+ * Saves the battle to the binary save format as the base that
+ * later delta saves to the same file are made against. Every base
+ * gets a new ID, so deltas can't be applied to a base from before.
+ * @param buffer Buffer to add the battle to.
+ * @param file Path of the save file.
+ */
+void SavedBattleGame::saveBinaryBase(std::vector<Uint8> &buffer, const std::string &file)
+{
+	saveTileRecords(_deltaBase);
+	saveBinary(buffer, _deltaBase, 0);
+	_deltaFile = file;
+	_deltaSaves = 0;
+	static int lastBaseId = (int)time(0);
+	if (++lastBaseId == 0)
+	{
+		++lastBaseId;
+	}
+	_deltaBaseId = lastBaseId;
+}
+
+/**
+ * Saves what changed in the battle since the base save of a file:
+ * the tiles that are different, and all of the rest, which is small
+ * next to the map. There is no delta if the base was saved to another
+ * file, or if the file already has as many deltas as allowed, so
+ * the caller saves a new base instead, which keeps the file from growing.
+ * @param buffer Buffer to add the delta to.
+ * @param file Path of the save file.
+ * @param limit Most deltas a save file can have.
+ * @return True if a delta was saved.
+ */
+bool SavedBattleGame::saveBinaryDelta(std::vector<Uint8> &buffer, const std::string &file, int limit)
+{
+	if (file != _deltaFile || _deltaSaves >= limit || _deltaBase.empty())
+	{
+		return false;
+	}
+	std::vector<Uint8> records;
+	saveTileRecords(records);
+	if (records.size() != _deltaBase.size())
+	{
+		return false;
+	}
+	saveBinary(buffer, records, &_deltaBase);
+	++_deltaSaves;
+	return true;
+}
+
+/**
+ * Returns the ID of the last base save, which its
+ * delta saves are marked with.
+ * @return Base ID, 0 if there's no base.
+ */
+int SavedBattleGame::getDeltaBaseId() const
+{
+	return _deltaBaseId;
+}
+
+/**
+ * Serializes every tile of the map, with its index, in tile index order.
+ * Every record is the same size, so two sets of them can be compared tile by tile.
+ * @param records Buffer to put the records in.
+ */
+void SavedBattleGame::saveTileRecords(std::vector<Uint8> &records) const
+{
+	records.resize(Tile::serializationKey.totalBytes * _mapsize_z * _mapsize_y * _mapsize_x);
+	if (records.empty())
+	{
+		return;
+	}
+	Uint8 *w = &records[0];
+	for (int i = 0; i < _mapsize_z * _mapsize_y * _mapsize_x; ++i)
+	{
+		serializeInt(&w, Tile::serializationKey.index, i);
+		_tiles[i]->saveBinary(&w, getTileDiscovered(i));
+	}
+}
+
+/**
+ * Saves the battle to the binary save format, with all the tiles
+ * that aren't void, or only the ones that differ from a base save.
+ * @param buffer Buffer to add the battle to.
+ * @param records Records of all the tiles.
+ * @param base Records of all the tiles in the base save, if this is a delta.
+ */
+void SavedBattleGame::saveBinary(std::vector<Uint8> &buffer, const std::vector<Uint8> &records, const std::vector<Uint8> *base) const
+{
+	serializeInt(buffer, _mapsize_x);
+	serializeInt(buffer, _mapsize_y);
+	serializeInt(buffer, _mapsize_z);
+	serializeString(buffer, _missionType);
+	serializeInt(buffer, _globalShade);
+	serializeInt(buffer, _turn);
+	serializeInt(buffer, _selectedUnit ? _selectedUnit->getId() : -1);
+
+	serializeInt(buffer, _mapDataSets.size());
+	for (std::vector<MapDataSet*>::const_iterator i = _mapDataSets.begin(); i != _mapDataSets.end(); ++i)
+	{
+		serializeString(buffer, (*i)->getName());
+	}
+
+	serializeInt(buffer, Tile::serializationKey.index);
+	serializeInt(buffer, Tile::serializationKey.totalBytes);
+	serializeInt(buffer, Tile::serializationKey._fire);
+	serializeInt(buffer, Tile::serializationKey._smoke);
+	serializeInt(buffer, Tile::serializationKey._mapDataID);
+	serializeInt(buffer, Tile::serializationKey._mapDataSetID);
+	size_t size = Tile::serializationKey.totalBytes;
+	size_t totalTilesAt = buffer.size();
+	serializeInt(buffer, 0);
+	int totalTiles = 0;
+	for (int i = 0; i < _mapsize_z * _mapsize_y * _mapsize_x; ++i)
+	{
+		const Uint8 *record = &records[i * size];
+		bool save;
+		if (base != 0)
+		{
+			save = !std::equal(record, record + size, &(*base)[i * size]);
+		}
+		else
+		{
+			save = !_tiles[i]->isVoid();
+		}
+		if (save)
+		{
+			buffer.insert(buffer.end(), record, record + size);
+			++totalTiles;
+		}
+	}
+	Uint8 *w = &buffer[totalTilesAt];
+	serializeInt(&w, 4, totalTiles);
+
+	serializeInt(buffer, _nodes.size());
+	for (std::vector<Node*>::const_iterator i = _nodes.begin(); i != _nodes.end(); ++i)
+	{
+		(*i)->saveBinary(buffer);
+	}
+
+	serializeInt(buffer, _units.size());
+	for (std::vector<BattleUnit*>::const_iterator i = _units.begin(); i != _units.end(); ++i)
+	{
+		serializeInt(buffer, (*i)->getFaction());
+		serializeInt(buffer, (*i)->getId());
+		serializeString(buffer, (*i)->getType());
+		serializeString(buffer, (*i)->getArmor()->getType());
+		(*i)->saveBinary(buffer);
+	}
+	for (std::vector<BattleUnit*>::const_iterator i = _units.begin(); i != _units.end(); ++i)
+	{
+		if ((*i)->getCurrentAIState())
+		{
+			(*i)->getCurrentAIState()->saveBinary(buffer);
+		}
+		else
+		{
+			serializeString(buffer, "");
+		}
+	}
+
+	serializeInt(buffer, _items.size());
+	for (std::vector<BattleItem*>::const_iterator i = _items.begin(); i != _items.end(); ++i)
+	{
+		serializeInt(buffer, (*i)->getId());
+		serializeString(buffer, (*i)->getRules()->getType());
+		serializeInt(buffer, (*i)->getOwner() ? (*i)->getOwner()->getId() : -1);
+		serializeInt(buffer, (*i)->getUnit() ? (*i)->getUnit()->getId() : -1);
+		serializeString(buffer, (*i)->getSlot() ? (*i)->getSlot()->getId() : "NULL");
+		if ((*i)->getTile())
+		{
+			serializeInt(buffer, (*i)->getTile()->getPosition().x);
+			serializeInt(buffer, (*i)->getTile()->getPosition().y);
+			serializeInt(buffer, (*i)->getTile()->getPosition().z);
+		}
+		else
+		{
+			serializeInt(buffer, -1);
+			serializeInt(buffer, -1);
+			serializeInt(buffer, -1);
+		}
+		serializeInt(buffer, (*i)->getAmmoItem() ? (*i)->getAmmoItem()->getId() : -1);
+		(*i)->saveBinary(buffer);
+	}
+}
+
+/**
+ * Restores which parts of a tile the player had discovered.
+ * @param index Index of the tile.
+ * @param discovered 1 westwall, 2 northwall, 4 content+floor.
+ */
+void SavedBattleGame::loadTileDiscovered(int index, Uint8 discovered)
+{
+	for (int part = 0; part < 3; ++part)
+	{
+		if (discovered & (1 << part))
+		{
+			_discoveredTiles[part].set(index);
+		}
+	}
+}
+
 /**
  * Gets the currently selected unit
  * @return pointer to BattleUnit.
@@ -845,8 +1382,11 @@ void SavedBattleGame::endTurn()
 		{
 			(*i)->prepareNewTurn();
 		}
-		_tileEngine->calculateFOV(*i);
 	}
+	// everyone looks around again, so start what they see from scratch
+	clearVisibleTiles();
+	_tileEngine->invalidateFOVCache();
+	_tileEngine->calculateFOV(_units);
 
 	if (_side != FACTION_PLAYER)
 		selectNextPlayerUnit();
@@ -857,9 +1397,13 @@ void SavedBattleGame::endTurn()
  */
 void SavedBattleGame::setDebugMode()
 {
-	for (int i = 0; i < _mapsize_z * _mapsize_y * _mapsize_x; ++i)
+	for (int i = 0; i < 3; ++i)
+	{
+		_discoveredTiles[i].fill();
+	}
+	for (std::vector<BattleUnit*>::iterator i = _units.begin(); i != _units.end(); ++i)
 	{
-		_tiles[i]->setDiscovered(true, 2);
+		(*i)->setCache(0);
 	}
 
 	_debugMode = true;
@@ -1091,17 +1635,17 @@ void SavedBattleGame::prepareNewTurn()
 	std::vector<Tile*> tilesOnFire;
 	std::vector<Tile*> tilesOnSmoke;
 
-	// prepare a list of tiles on fire/smoke
-	for (int i = 0; i < _mapsize_x * _mapsize_y * _mapsize_z; ++i)
+	// prepare a list of tiles on fire/smoke; the arena keeps track of them,
+	// in the same order a pass over the map would find them, so the random spread stays the same
+	const std::vector<int> &burning = _tileArena->getBurningTiles();
+	for (std::vector<int>::const_iterator i = burning.begin(); i != burning.end(); ++i)
 	{
-		if (getTiles()[i]->getFire() > 0)
-		{
-			tilesOnFire.push_back(getTiles()[i]);
-		}
-		if (getTiles()[i]->getSmoke() > 0)
-		{
-			tilesOnSmoke.push_back(getTiles()[i]);
-		}
+		tilesOnFire.push_back(_tiles[*i]);
+	}
+	const std::vector<int> &smoking = _tileArena->getSmokingTiles();
+	for (std::vector<int>::const_iterator i = smoking.begin(); i != smoking.end(); ++i)
+	{
+		tilesOnSmoke.push_back(_tiles[*i]);
 	}
 
 	// smoke spreads in 1 random direction, but the direction is same for all smoke
@@ -1182,8 +1726,14 @@ void SavedBattleGame::prepareNewTurn()
 				}
 			}
 		}
+		int terrainRevision = (*i)->getTerrainRevision();
 		if (!_objectiveDestroyed)
 			_objectiveDestroyed = (*i)->prepareNewTurn();
+		// burnt out objects are destroyed, which changes what can be seen through the tile
+		if ((*i)->getTerrainRevision() != terrainRevision)
+		{
+			getTileEngine()->invalidateFOVCache((*i)->getPosition());
+		}
 	}
 
 	if (!tilesOnFire.empty())
@@ -26,11 +26,13 @@
 #include <yaml-cpp/yaml.h>
 #include "BattleItem.h"
 #include "BattleUnit.h"
+#include "BitPlane.h"
 
 namespace OpenXcom
 {
 
 class Tile;
+class TileArena;
 class SavedGame;
 class MapDataSet;
 class RuleUnit;
@@ -57,7 +59,9 @@ class SavedBattleGame
 private:
 	int _mapsize_x, _mapsize_y, _mapsize_z;
 	std::vector<MapDataSet*> _mapDataSets;
+	TileArena *_tileArena;
 	Tile **_tiles;
+	BitPlane _visibleTiles[3], _discoveredTiles[3];
 	BattleUnit *_selectedUnit, *_lastSelectedUnit;
 	std::vector<Node*> _nodes;
 	std::vector<BattleUnit*> _units;
@@ -79,6 +83,21 @@ private:
 	std::vector<BattleUnit*> _exposedUnits;
 	std::vector<BattleUnit*> _fallingUnits;
 	bool _unitsFalling, _strafeEnabled;
+	std::vector<Uint8> _deltaBase;
+	std::string _deltaFile;
+	int _deltaSaves, _deltaBaseId;
+	/// Gets which parts of a tile the player has discovered.
+	Uint8 getTileDiscovered(int index) const;
+	/// Restores which parts of a tile the player had discovered.
+	void loadTileDiscovered(int index, Uint8 discovered);
+	/// Reads the header of a binary battle save.
+	int loadBinaryHeader(Uint8 **buffer, const Uint8 *end, std::vector<std::string> *mapDataSets);
+	/// Reads the tiles of a binary battle save.
+	void loadBinaryTiles(Uint8 **buffer, const Uint8 *end);
+	/// Serializes every tile of the map.
+	void saveTileRecords(std::vector<Uint8> &records) const;
+	/// Saves the battle to binary, all the tiles or only the changed ones.
+	void saveBinary(std::vector<Uint8> &buffer, const std::vector<Uint8> &records, const std::vector<Uint8> *base) const;
 public:
 	/// Creates a new battle save, based on current generic save.
 	SavedBattleGame();
@@ -88,6 +107,16 @@ public:
 	void load(const YAML::Node& node, Ruleset *rule, SavedGame* savedGame);
 	/// Saves a saved battle game to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads a saved battle game from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end, Ruleset *rule, SavedGame* savedGame, Uint8 **delta = 0, const Uint8 *deltaEnd = 0);
+	/// Saves a saved battle game to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
+	/// Saves a saved battle game to binary as the base of delta saves.
+	void saveBinaryBase(std::vector<Uint8> &buffer, const std::string &file);
+	/// Saves the changes since the base save to binary.
+	bool saveBinaryDelta(std::vector<Uint8> &buffer, const std::string &file, int limit);
+	/// Gets the ID of the last base save.
+	int getDeltaBaseId() const;
 	/// Set the dimensions of the map and initializes it.
 	void initMap(int mapsize_x, int mapsize_y, int mapsize_z);
 	/// initialises pathfinding and tileengine
@@ -106,6 +135,8 @@ public:
 	int getGlobalShade() const;
 	/// Gets pointer to the tiles, a tile is the smallest component of battlescape.
 	Tile **getTiles() const;
+	/// Gets the arena holding the tiles and their hot state.
+	TileArena *getTileArena() const;
 	/// Get pointer to the list of nodes.
 	std::vector<Node*> *getNodes();
 	/// Get pointer to the list of items.
@@ -154,6 +185,32 @@ public:
 
 		return _tiles[getTileIndex(pos)];
 	}
+	/**
+	 * Checks if a faction's units have seen the tile at a position this turn.
+	 * @param faction The faction.
+	 * @param pos Position of the tile, which must be on the map.
+	 * @return True if the tile was seen.
+	 */
+	inline bool isTileVisible(UnitFaction faction, const Position& pos) const
+	{
+		return _visibleTiles[faction].get(getTileIndex(pos));
+	}
+	/**
+	 * Checks if the player has discovered a part of the tile at a position.
+	 * @param pos Position of the tile, which must be on the map.
+	 * @param part 0-2 westwall/northwall/content+floor
+	 * @return True if the part was discovered.
+	 */
+	inline bool isTileDiscovered(const Position& pos, int part) const
+	{
+		return _discoveredTiles[part].get(getTileIndex(pos));
+	}
+	/// Marks a tile as seen by a faction's units this turn.
+	void setTileVisible(UnitFaction faction, Tile *tile);
+	/// Forgets which tiles all factions have seen.
+	void clearVisibleTiles();
+	/// Sets whether the player has discovered a part of a tile.
+	void setTileDiscovered(Tile *tile, bool flag, int part);
 	/// get the currently selected unit
 	BattleUnit *getSelectedUnit() const;
 	/// set the currently selected unit
@@ -48,10 +48,101 @@
 #include "AlienBase.h"
 #include "AlienStrategy.h"
 #include "AlienMission.h"
+#include "SerializationHelper.h"
 #include "../Ruleset/RuleRegion.h"
 
 namespace OpenXcom
 {
+
+/// First bytes of a binary save, YAML saves can't start with them.
+const char BINARY_MAGIC[] = "OXCB";
+/// Version of the binary save format, raised when a chunk changes.
+/// Version 2 added compressed chunks, version 3 delta saves,
+/// version 4 the geoscape in binary instead of YAML text.
+const int BINARY_VERSION = 4;
+
+/**
+ * Writes a chunk of a binary save. A compressed chunk goes in
+ * a ZLIB chunk holding its tag and its deflated contents.
+ * @param out Stream to write to.
+ * @param tag Four letter name of the chunk.
+ * @param data Contents of the chunk.
+ * @param compress Whether to compress the contents.
+ */
+static void writeBinaryChunk(std::ostream &out, const char *tag, const std::vector<Uint8> &data, bool compress = false)
+{
+	if (compress && !data.empty())
+	{
+		std::vector<Uint8> compressed;
+		compressData(&data[0], data.size(), compressed);
+		compressed.insert(compressed.begin(), tag, tag + 4);
+		writeBinaryChunk(out, "ZLIB", compressed);
+		return;
+	}
+	Uint8 header[8];
+	Uint8 *w = header + 4;
+	std::copy(tag, tag + 4, header);
+	serializeInt(&w, 4, data.size());
+	out.write((const char*)header, 8);
+	if (!data.empty())
+	{
+		out.write((const char*)&data[0], data.size());
+	}
+}
+
+/**
+ * Reads the next chunk of a binary save, inflating it if it was compressed.
+ * @param in Stream to read from.
+ * @param tag Returns the four letter name of the chunk.
+ * @param data Returns the contents of the chunk.
+ * @return False if there are no more chunks.
+ */
+static bool readBinaryChunk(std::istream &in, std::string &tag, std::vector<Uint8> &data)
+{
+	Uint8 header[8];
+	if (!in.read((char*)header, 8))
+	{
+		return false;
+	}
+	tag.assign((const char*)header, 4);
+	Uint8 *r = header + 4;
+	Uint32 size = unserializeInt(&r, 4);
+	data.resize(size);
+	if (size != 0 && !in.read((char*)&data[0], size))
+	{
+		throw Exception("Save data is truncated");
+	}
+	if (tag == "ZLIB")
+	{
+		if (size < 4)
+		{
+			throw Exception("Save data is truncated");
+		}
+		std::vector<Uint8> compressed;
+		compressed.swap(data);
+		tag.assign((const char*)&compressed[0], 4);
+		decompressData(&compressed[0] + 4, size - 4, data);
+	}
+	return true;
+}
+
+/**
+ * Reads the game time from the info chunk of a binary save.
+ * @param buffer Pointer to the time data.
+ * @param end End of the chunk.
+ * @param time Game time to set.
+ */
+static void loadBinaryTime(Uint8 **buffer, const Uint8 *end, GameTime *time)
+{
+	int weekday = unserializeInt(buffer, end);
+	int day = unserializeInt(buffer, end);
+	int month = unserializeInt(buffer, end);
+	int year = unserializeInt(buffer, end);
+	int hour = unserializeInt(buffer, end);
+	int minute = unserializeInt(buffer, end);
+	int second = unserializeInt(buffer, end);
+	*time = GameTime(weekday, day, month, year, hour, minute, second);
+}
 struct findRuleResearch : public std::unary_function<ResearchProject *,
 								bool>
 {
@@ -137,33 +228,196 @@ SavedGame::~SavedGame()
 	delete _battleGame;
 }
 
+/**
+ * Reads what the saves list shows about a save from the save itself,
+ * the brief info document of a YAML save or the info chunk of a binary one.
+ * @param file Filename of the save in the user folder.
+ * @return Info about the save, without the file's time and size.
+ */
+SaveInfo SavedGame::readSaveInfo(const std::string &file)
+{
+	std::string fullname = Options::getUserFolder() + file;
+	std::ifstream fin(fullname.c_str(), std::ios::in | std::ios::binary);
+	if (!fin)
+	{
+		throw Exception("Failed to load " + file);
+	}
+	SaveInfo info;
+	info.file = file;
+	info.battle = false;
+	GameTime time = GameTime(6, 1, 1, 1999, 12, 0, 0);
+	char magic[4] = {0};
+	fin.read(magic, 4);
+	if (fin && std::equal(magic, magic + 4, BINARY_MAGIC))
+	{
+		std::string tag;
+		std::vector<Uint8> data;
+		while (readBinaryChunk(fin, tag, data) && tag != "INFO");
+		if (tag != "INFO" || data.empty())
+		{
+			throw Exception("Failed to load " + file);
+		}
+		Uint8 *r = &data[0];
+		const Uint8 *end = r + data.size();
+		info.version = unserializeString(&r, end);
+		loadBinaryTime(&r, end, &time);
+		// saves from before the battle flag end here
+		if (r < end)
+		{
+			info.battle = unserializeInt(&r, end) != 0;
+		}
+	}
+	else
+	{
+		fin.clear();
+		fin.seekg(0);
+		YAML::Parser parser(fin);
+		YAML::Node doc;
+
+		parser.GetNextDocument(doc);
+		doc["version"] >> info.version;
+		time.load(doc["time"]);
+		if (const YAML::Node *pName = doc.FindValue("battle"))
+		{
+			*pName >> info.battle;
+		}
+	}
+	fin.close();
+	info.weekday = time.getWeekday();
+	info.day = time.getDay();
+	info.month = time.getMonth();
+	info.year = time.getYear();
+	info.hour = time.getHour();
+	info.minute = time.getMinute();
+	info.second = time.getSecond();
+	info.modified = 0;
+	info.size = 0;
+	return info;
+}
+
+/**
+ * Loads the index of the saves in the user folder.
+ * A missing or broken index is just empty, it only makes the list slower.
+ * @return Info about the saves, by filename.
+ */
+std::map<std::string, SaveInfo> SavedGame::loadIndex()
+{
+	std::map<std::string, SaveInfo> index;
+	std::string s = Options::getUserFolder() + "saves.idx";
+	std::ifstream fin(s.c_str());
+	if (!fin)
+	{
+		return index;
+	}
+	try
+	{
+		YAML::Parser parser(fin);
+		YAML::Node doc;
+
+		parser.GetNextDocument(doc);
+		for (YAML::Iterator i = doc.begin(); i != doc.end(); ++i)
+		{
+			SaveInfo info;
+			(*i)["file"] >> info.file;
+			(*i)["version"] >> info.version;
+			(*i)["time"][0] >> info.weekday;
+			(*i)["time"][1] >> info.day;
+			(*i)["time"][2] >> info.month;
+			(*i)["time"][3] >> info.year;
+			(*i)["time"][4] >> info.hour;
+			(*i)["time"][5] >> info.minute;
+			(*i)["time"][6] >> info.second;
+			(*i)["modified"] >> info.modified;
+			(*i)["size"] >> info.size;
+			(*i)["battle"] >> info.battle;
+			index[info.file] = info;
+		}
+	}
+	catch (YAML::Exception &e)
+	{
+		Log(LOG_WARNING) << "Ignoring broken saves index: " << e.what();
+		index.clear();
+	}
+	fin.close();
+	return index;
+}
+
+/**
+ * Saves the index of the saves in the user folder.
+ * @param index Info about the saves, by filename.
+ */
+void SavedGame::saveIndex(const std::map<std::string, SaveInfo> &index)
+{
+	std::string s = Options::getUserFolder() + "saves.idx";
+	std::ofstream sav(s.c_str());
+	if (!sav)
+	{
+		Log(LOG_WARNING) << "Failed to save saves index";
+		return;
+	}
+	YAML::Emitter out;
+	out << YAML::BeginSeq;
+	for (std::map<std::string, SaveInfo>::const_iterator i = index.begin(); i != index.end(); ++i)
+	{
+		const SaveInfo &info = i->second;
+		out << YAML::BeginMap;
+		out << YAML::Key << "file" << YAML::Value << info.file;
+		out << YAML::Key << "version" << YAML::Value << info.version;
+		out << YAML::Key << "time" << YAML::Value << YAML::Flow << YAML::BeginSeq;
+		out << info.weekday << info.day << info.month << info.year << info.hour << info.minute << info.second;
+		out << YAML::EndSeq;
+		out << YAML::Key << "modified" << YAML::Value << info.modified;
+		out << YAML::Key << "size" << YAML::Value << info.size;
+		out << YAML::Key << "battle" << YAML::Value << info.battle;
+		out << YAML::EndMap;
+	}
+	out << YAML::EndSeq;
+	sav << out.c_str();
+	sav.close();
+}
+
 /**
  * Gets all the saves found in the user folder
- * and adds them to a text list.
+ * and adds them to a text list. What the list shows comes
+ * from the saves index, only saves that changed since
+ * the index was written are read.
  * @param list Text list.
  * @param lang Loaded language.
  */
 void SavedGame::getList(TextList *list, Language *lang)
 {
 	std::vector<std::string> saves = CrossPlatform::getFolderContents(Options::getUserFolder(), "sav");
+	std::map<std::string, SaveInfo> index = loadIndex();
+	std::map<std::string, SaveInfo> found;
+	bool changed = false;
 
 	for (std::vector<std::string>::iterator i = saves.begin(); i != saves.end(); ++i)
 	{
 		std::string file = (*i);
 		std::string fullname = Options::getUserFolder() + file;
-		std::ifstream fin(fullname.c_str());
 		try
 		{
-			if (!fin)
+			long modified, size;
+			if (!CrossPlatform::getFileInfo(fullname, &modified, &size))
 			{
 				throw Exception("Failed to load " + file);
 			}
-			YAML::Parser parser(fin);
-			YAML::Node doc;
+			SaveInfo info;
+			std::map<std::string, SaveInfo>::const_iterator cached = index.find(file);
+			if (cached != index.end() && cached->second.modified == modified && cached->second.size == size)
+			{
+				info = cached->second;
+			}
+			else
+			{
+				info = readSaveInfo(file);
+				info.modified = modified;
+				info.size = size;
+				changed = true;
+			}
+			found[file] = info;
 
-			parser.GetNextDocument(doc);
-			GameTime time = GameTime(6, 1, 1, 1999, 12, 0, 0);
-			time.load(doc["time"]);
+			GameTime time = GameTime(info.weekday, info.day, info.month, info.year, info.hour, info.minute, info.second);
 			std::stringstream saveTime;
 			std::wstringstream saveDay, saveMonth, saveYear;
 			saveTime << time.getHour() << ":" << std::setfill('0') << std::setw(2) << time.getMinute();
@@ -178,7 +432,6 @@ void SavedGame::getList(TextList *list, Language *lang)
 			std::wstring wstr = Language::utf8ToWstr(s);
 #endif
 			list->addRow(5, wstr.c_str(), Language::utf8ToWstr(saveTime.str()).c_str(), saveDay.str().c_str(), saveMonth.str().c_str(), saveYear.str().c_str());
-			fin.close();
 		}
 		catch (Exception &e)
 		{
@@ -191,22 +444,40 @@ void SavedGame::getList(TextList *list, Language *lang)
 			continue;
 		}
 	}
+
+	// saves that were deleted or renamed drop out too
+	if (changed || found.size() != index.size())
+	{
+		saveIndex(found);
+	}
 }
 
 /**
- * Loads a saved game's contents from a YAML file.
+ * Loads a saved game's contents from a file, which can be
+ * a binary save or a YAML one.
  * @note Assumes the saved game is blank.
- * @param filename YAML filename.
+ * @param filename Save filename.
  * @param rule Ruleset for the saved game.
  */
 void SavedGame::load(const std::string &filename, Ruleset *rule)
 {
 	std::string s = Options::getUserFolder() + filename + ".sav";
-	std::ifstream fin(s.c_str());
+	std::ifstream fin(s.c_str(), std::ios::in | std::ios::binary);
 	if (!fin)
 	{
 		throw Exception("Failed to load " + filename + ".sav");
 	}
+	char magic[4] = {0};
+	fin.read(magic, 4);
+	if (fin && std::equal(magic, magic + 4, BINARY_MAGIC))
+	{
+		loadBinary(fin, rule);
+		fin.close();
+		return;
+	}
+	fin.clear();
+	fin.seekg(0);
+
 	YAML::Parser parser(fin);
 	YAML::Node doc;
 
@@ -222,6 +493,24 @@ void SavedGame::load(const std::string &filename, Ruleset *rule)
 
 	// Get full save data
 	parser.GetNextDocument(doc);
+	loadGeoscape(doc, rule);
+
+	if (const YAML::Node *pName = doc.FindValue("battleGame"))
+	{
+		_battleGame = new SavedBattleGame();
+		_battleGame->load(*pName, rule, this);
+	}
+
+	fin.close();
+}
+
+/**
+ * Loads everything but the battle from the full save document.
+ * @param doc YAML node with the full save data.
+ * @param rule Ruleset for the saved game.
+ */
+void SavedGame::loadGeoscape(const YAML::Node &doc, Ruleset *rule)
+{
 	int a = 0;
 	doc["difficulty"] >> a;
 	_difficulty = (GameDifficulty)a;
@@ -331,24 +620,28 @@ void SavedGame::load(const std::string &filename, Ruleset *rule)
 	}
 
 	_alienStrategy->load(rule, doc["alienStrategy"]);
-
-	if (const YAML::Node *pName = doc.FindValue("battleGame"))
-	{
-		_battleGame = new SavedBattleGame();
-		_battleGame->load(*pName, rule, this);
-	}
-
-	fin.close();
 }
 
 /**
- * Saves a saved game's contents to a YAML file.
- * @param filename YAML filename.
+ * Saves a saved game's contents to a file, binary unless
+ * the binarySaves option is off. The file is written under
+ * a temporary name and then renamed over the old save,
+ * so a failed save never leaves a broken file behind.
+ * @param filename Save filename.
  */
 void SavedGame::save(const std::string &filename) const
 {
+	if (Options::getBool("binarySaves"))
+	{
+		std::auto_ptr<SaveSnapshot> snap(snapshot(filename));
+		writeSnapshot(snap.get());
+		addToIndex(snap->info);
+		return;
+	}
+
 	std::string s = Options::getUserFolder() + filename + ".sav";
-	std::ofstream sav(s.c_str());
+	std::string tmp = s + ".tmp";
+	std::ofstream sav(tmp.c_str(), std::ios::out | std::ios::binary);
 	if (!sav)
 	{
 		throw Exception("Failed to save " + filename + ".sav");
@@ -361,11 +654,76 @@ void SavedGame::save(const std::string &filename) const
 	out << YAML::Key << "version" << YAML::Value << Options::getVersion();
 	out << YAML::Key << "time" << YAML::Value;
 	_time->save(out);
+	out << YAML::Key << "battle" << YAML::Value << (_battleGame != 0);
 	out << YAML::EndMap;
 
 	// Saves the full game data to the save
 	out << YAML::BeginDoc;
 	out << YAML::BeginMap;
+	saveGeoscape(out);
+	if (_battleGame != 0)
+	{
+		out << YAML::Key << "battleGame" << YAML::Value;
+		_battleGame->save(out);
+	}
+	out << YAML::EndMap;
+	sav << out.c_str();
+	sav.close();
+	if (!sav || !CrossPlatform::moveFile(tmp, s))
+	{
+		CrossPlatform::deleteFile(tmp);
+		throw Exception("Failed to save " + filename + ".sav");
+	}
+
+	SaveInfo info = getSaveInfo(filename + ".sav");
+	if (CrossPlatform::getFileInfo(s, &info.modified, &info.size))
+	{
+		addToIndex(info);
+	}
+}
+
+/**
+ * Gets what the saves list shows about this game.
+ * @param file Filename of the save in the user folder.
+ * @return Info about the save, without the file's time and size.
+ */
+SaveInfo SavedGame::getSaveInfo(const std::string &file) const
+{
+	SaveInfo info;
+	info.file = file;
+	info.version = Options::getVersion();
+	info.weekday = _time->getWeekday();
+	info.day = _time->getDay();
+	info.month = _time->getMonth();
+	info.year = _time->getYear();
+	info.hour = _time->getHour();
+	info.minute = _time->getMinute();
+	info.second = _time->getSecond();
+	info.modified = 0;
+	info.size = 0;
+	info.battle = (_battleGame != 0);
+	return info;
+}
+
+/**
+ * Puts a save in the saves index, after it was written to a file,
+ * so the saves list doesn't need to read it back.
+ * @param info Info about the save.
+ */
+void SavedGame::addToIndex(const SaveInfo &info)
+{
+	std::map<std::string, SaveInfo> index = loadIndex();
+	index[info.file] = info;
+	saveIndex(index);
+}
+
+/**
+ * Saves everything but the battle to the full save document,
+ * as keys of the map the caller has begun.
+ * @param out YAML emitter.
+ */
+void SavedGame::saveGeoscape(YAML::Emitter &out) const
+{
 	out << YAML::Key << "difficulty" << YAML::Value << _difficulty;
 	out << YAML::Key << "monthsPassed" << YAML::Value << _monthsPassed;
 	out << YAML::Key << "radarLines" << YAML::Value << _radarLines;
@@ -450,14 +808,423 @@ void SavedGame::save(const std::string &filename) const
 	out << YAML::EndSeq;
 	out << YAML::Key << "alienStrategy" << YAML::Value;
 	_alienStrategy->save(out);
+}
+
+/**
+ * Loads everything but the battle from the geoscape chunk of a binary
+ * save, in the same order as loadGeoscape so everything a target or
+ * mission refers to is there before it.
+ * @param buffer Pointer to the geoscape data.
+ * @param end End of the chunk.
+ * @param rule Ruleset for the saved game.
+ */
+void SavedGame::loadGeoscapeBinary(Uint8 **buffer, const Uint8 *end, Ruleset *rule)
+{
+	_difficulty = (GameDifficulty)unserializeInt(buffer, end);
+	long count = unserializeInt(buffer, end);
+	unsigned int seed = unserializeInt(buffer, end);
+	RNG::init(count, seed);
+	_monthsPassed = unserializeInt(buffer, end);
+	_radarLines = unserializeInt(buffer, end) != 0;
+	_detail = unserializeInt(buffer, end) != 0;
+	_graphRegionToggles = unserializeString(buffer, end);
+	_graphCountryToggles = unserializeString(buffer, end);
+	_graphFinanceToggles = unserializeString(buffer, end);
+	_funds = unserializeIntList(buffer, end);
+	_maintenance = unserializeIntList(buffer, end);
+	_researchScores = unserializeIntList(buffer, end);
+	_warned = unserializeInt(buffer, end) != 0;
+	_globeLon = unserializeDouble(buffer, end);
+	_globeLat = unserializeDouble(buffer, end);
+	_globeZoom = unserializeInt(buffer, end);
+	_ids = unserializeIntMap(buffer, end);
+
+	int countries = unserializeInt(buffer, end);
+	for (int i = 0; i < countries; ++i)
+	{
+		Country *c = new Country(rule->getCountry(unserializeString(buffer, end)), false);
+		c->loadBinary(buffer, end);
+		_countries.push_back(c);
+	}
+
+	int regions = unserializeInt(buffer, end);
+	for (int i = 0; i < regions; ++i)
+	{
+		Region *r = new Region(rule->getRegion(unserializeString(buffer, end)));
+		r->loadBinary(buffer, end);
+		_regions.push_back(r);
+	}
+
+	// Alien bases must be loaded before alien missions
+	int alienBases = unserializeInt(buffer, end);
+	for (int i = 0; i < alienBases; ++i)
+	{
+		AlienBase *b = new AlienBase();
+		b->loadBinary(buffer, end);
+		_alienBases.push_back(b);
+	}
+
+	// Missions must be loaded before UFOs.
+	int missions = unserializeInt(buffer, end);
+	for (int i = 0; i < missions; ++i)
+	{
+		const RuleAlienMission &mRule = *rule->getAlienMission(unserializeString(buffer, end));
+		std::auto_ptr<AlienMission> mission(new AlienMission(mRule));
+		mission->loadBinary(buffer, end, *this);
+		_activeMissions.push_back(mission.release());
+	}
+
+	int ufos = unserializeInt(buffer, end);
+	for (int i = 0; i < ufos; ++i)
+	{
+		Ufo *u = new Ufo(rule->getUfo(unserializeString(buffer, end)));
+		u->loadBinary(buffer, end, *rule, *this);
+		_ufos.push_back(u);
+	}
+
+	int waypoints = unserializeInt(buffer, end);
+	for (int i = 0; i < waypoints; ++i)
+	{
+		Waypoint *w = new Waypoint();
+		w->loadBinary(buffer, end);
+		_waypoints.push_back(w);
+	}
+
+	int terrorSites = unserializeInt(buffer, end);
+	for (int i = 0; i < terrorSites; ++i)
+	{
+		TerrorSite *t = new TerrorSite();
+		t->loadBinary(buffer, end);
+		_terrorSites.push_back(t);
+	}
+
+	// Crafts look for their destination among everything above
+	int bases = unserializeInt(buffer, end);
+	for (int i = 0; i < bases; ++i)
+	{
+		Base *b = new Base(rule);
+		b->loadBinary(buffer, end, this);
+		_bases.push_back(b);
+	}
+
+	int discovered = unserializeInt(buffer, end);
+	for (int i = 0; i < discovered; ++i)
+	{
+		_discovered.push_back(rule->getResearch(unserializeString(buffer, end)));
+	}
+
+	_alienStrategy->loadBinary(buffer, end);
+}
+
+/**
+ * Saves everything but the battle to the geoscape chunk of a binary
+ * save. Unlike the YAML save, the bases go after the UFOs, waypoints
+ * and terror sites, since their crafts can be headed for those.
+ * @param buffer Buffer to add the geoscape to.
+ */
+void SavedGame::saveGeoscapeBinary(std::vector<Uint8> &buffer) const
+{
+	serializeInt(buffer, _difficulty);
+	serializeInt(buffer, RNG::getCount());
+	serializeInt(buffer, RNG::getSeed());
+	serializeInt(buffer, _monthsPassed);
+	serializeInt(buffer, _radarLines);
+	serializeInt(buffer, _detail);
+	serializeString(buffer, _graphRegionToggles);
+	serializeString(buffer, _graphCountryToggles);
+	serializeString(buffer, _graphFinanceToggles);
+	serializeIntList(buffer, _funds);
+	serializeIntList(buffer, _maintenance);
+	serializeIntList(buffer, _researchScores);
+	serializeInt(buffer, _warned);
+	serializeDouble(buffer, _globeLon);
+	serializeDouble(buffer, _globeLat);
+	serializeInt(buffer, _globeZoom);
+	serializeIntMap(buffer, _ids);
+	serializeInt(buffer, _countries.size());
+	for (std::vector<Country*>::const_iterator i = _countries.begin(); i != _countries.end(); ++i)
+	{
+		(*i)->saveBinary(buffer);
+	}
+	serializeInt(buffer, _regions.size());
+	for (std::vector<Region*>::const_iterator i = _regions.begin(); i != _regions.end(); ++i)
+	{
+		(*i)->saveBinary(buffer);
+	}
+	// Alien bases must be saved before alien missions.
+	serializeInt(buffer, _alienBases.size());
+	for (std::vector<AlienBase*>::const_iterator i = _alienBases.begin(); i != _alienBases.end(); ++i)
+	{
+		(*i)->saveBinary(buffer);
+	}
+	// Missions must be saved before UFOs, but after alien bases.
+	serializeInt(buffer, _activeMissions.size());
+	for (std::vector<AlienMission *>::const_iterator i = _activeMissions.begin(); i != _activeMissions.end(); ++i)
+	{
+		(*i)->saveBinary(buffer);
+	}
+	serializeInt(buffer, _ufos.size());
+	for (std::vector<Ufo*>::const_iterator i = _ufos.begin(); i != _ufos.end(); ++i)
+	{
+		(*i)->saveBinary(buffer);
+	}
+	serializeInt(buffer, _waypoints.size());
+	for (std::vector<Waypoint*>::const_iterator i = _waypoints.begin(); i != _waypoints.end(); ++i)
+	{
+		(*i)->saveBinary(buffer);
+	}
+	serializeInt(buffer, _terrorSites.size());
+	for (std::vector<TerrorSite*>::const_iterator i = _terrorSites.begin(); i != _terrorSites.end(); ++i)
+	{
+		(*i)->saveBinary(buffer);
+	}
+	serializeInt(buffer, _bases.size());
+	for (std::vector<Base*>::const_iterator i = _bases.begin(); i != _bases.end(); ++i)
+	{
+		(*i)->saveBinary(buffer);
+	}
+	serializeInt(buffer, _discovered.size());
+	for (std::vector<const RuleResearch *>::const_iterator i = _discovered.begin(); i != _discovered.end(); ++i)
+	{
+		serializeString(buffer, (*i)->getName());
+	}
+	_alienStrategy->saveBinary(buffer);
+}
+
+/**
+ * Loads a saved game in the binary format, the chunks after the magic.
+ * Chunks this version doesn't know are from a newer one and are skipped.
+ * @param in Stream positioned after the magic.
+ * @param rule Ruleset for the saved game.
+ */
+void SavedGame::loadBinary(std::istream &in, Ruleset *rule)
+{
+	std::string tag;
+	std::vector<Uint8> data;
+	if (!readBinaryChunk(in, tag, data) || tag != "VERS" || data.size() < 4)
+	{
+		throw Exception("Not a binary save");
+	}
+	Uint8 *r = &data[0];
+	int version = unserializeInt(&r, 4);
+	if (version > BINARY_VERSION)
+	{
+		throw Exception("Version mismatch");
+	}
+
+	std::vector<Uint8> battle, delta;
+	int baseId = 0;
+	while (true)
+	{
+		try
+		{
+			if (!readBinaryChunk(in, tag, data))
+			{
+				break;
+			}
+		}
+		catch (Exception &e)
+		{
+			// delta saves are appended, a game that stopped in the middle of one
+			// leaves it cut short, and the deltas before it are still good
+			if (battle.empty())
+			{
+				throw;
+			}
+			Log(LOG_WARNING) << "Ignoring the end of a save: " << e.what();
+			break;
+		}
+		if (data.empty())
+		{
+			continue;
+		}
+		r = &data[0];
+		const Uint8 *end = r + data.size();
+		if (tag == "INFO")
+		{
+			if (unserializeString(&r, end) != Options::getVersion())
+			{
+				throw Exception("Version mismatch");
+			}
+			loadBinaryTime(&r, end, _time);
+		}
+		else if (tag == "GEOS" && version < 4)
+		{
+			std::istringstream geoscape(std::string((const char*)r, data.size()));
+			YAML::Parser parser(geoscape);
+			YAML::Node doc;
+			parser.GetNextDocument(doc);
+			loadGeoscape(doc, rule);
+		}
+		else if (tag == "GEOS")
+		{
+			loadGeoscapeBinary(&r, end, rule);
+		}
+		else if (tag == "DBAS")
+		{
+			baseId = unserializeInt(&r, end);
+		}
+		else if (tag == "BATL")
+		{
+			battle.swap(data);
+		}
+		else if (tag == "BDLT")
+		{
+			// only the latest delta counts, each one has everything that changed since the base;
+			// deltas made against another base were appended after that base failed to be written
+			if (baseId != 0 && unserializeInt(&r, end) == baseId)
+			{
+				delta.swap(data);
+			}
+		}
+	}
+
+	if (!battle.empty())
+	{
+		r = &battle[0];
+		const Uint8 *end = r + battle.size();
+		_battleGame = new SavedBattleGame();
+		if (delta.empty())
+		{
+			_battleGame->loadBinary(&r, end, rule, this);
+		}
+		else
+		{
+			Uint8 *d = &delta[0] + 4;
+			const Uint8 *deltaEnd = &delta[0] + delta.size();
+			long count = unserializeInt(&d, deltaEnd);
+			unsigned int seed = unserializeInt(&d, deltaEnd);
+			RNG::init(count, seed);
+			_battleGame->loadBinary(&r, end, rule, this, &d, deltaEnd);
+		}
+	}
+}
+
+/**
+ * Copies the game into a snapshot of the binary format, chunks that are
+ * each a four letter tag, a size and the data. The geoscape and the
+ * battle are both written field by field, in the order the YAML save
+ * has them, apart from what the loader needs first. This is the quick part of
+ * saving, compressing and writing the snapshot is left to writeSnapshot,
+ * which doesn't touch the game and so can run on another thread.
+ * A delta snapshot of a battle only has what changed since the last
+ * full one to the same file, and is appended to it; every so many
+ * deltas, set by the battleDeltaSaves option, a full one is made
+ * again so loading never has too much to go through.
+ * @param filename Save filename.
+ * @param delta Whether to make a delta of the battle if there is a base for it.
+ * @return New snapshot, owned by the caller.
+ */
+SaveSnapshot *SavedGame::snapshot(const std::string &filename, bool delta) const
+{
+	std::auto_ptr<SaveSnapshot> snap(new SaveSnapshot());
+	snap->path = Options::getUserFolder() + filename + ".sav";
+	snap->info = getSaveInfo(filename + ".sav");
+	snap->compress = Options::getBool("compressSaves");
+	snap->append = false;
+
+	std::vector<Uint8> data;
+	if (delta && _battleGame != 0 && CrossPlatform::fileExists(snap->path))
+	{
+		serializeInt(data, _battleGame->getDeltaBaseId());
+		serializeInt(data, RNG::getCount());
+		serializeInt(data, RNG::getSeed());
+		if (_battleGame->saveBinaryDelta(data, snap->path, Options::getInt("battleDeltaSaves")))
+		{
+			snap->chunks.push_back(std::make_pair(std::string("BDLT"), data));
+			snap->append = true;
+			return snap.release();
+		}
+		data.clear();
+	}
+
+	serializeInt(data, BINARY_VERSION);
+	snap->chunks.push_back(std::make_pair(std::string("VERS"), data));
+
+	data.clear();
+	serializeString(data, Options::getVersion());
+	serializeInt(data, _time->getWeekday());
+	serializeInt(data, _time->getDay());
+	serializeInt(data, _time->getMonth());
+	serializeInt(data, _time->getYear());
+	serializeInt(data, _time->getHour());
+	serializeInt(data, _time->getMinute());
+	serializeInt(data, _time->getSecond());
+	serializeInt(data, _battleGame != 0);
+	snap->chunks.push_back(std::make_pair(std::string("INFO"), data));
+
+	data.clear();
+	saveGeoscapeBinary(data);
+	snap->chunks.push_back(std::make_pair(std::string("GEOS"), data));
+
 	if (_battleGame != 0)
 	{
-		out << YAML::Key << "battleGame" << YAML::Value;
-		_battleGame->save(out);
+		data.clear();
+		if (delta)
+		{
+			_battleGame->saveBinaryBase(data, snap->path);
+			std::vector<Uint8> id;
+			serializeInt(id, _battleGame->getDeltaBaseId());
+			snap->chunks.push_back(std::make_pair(std::string("DBAS"), id));
+		}
+		else
+		{
+			_battleGame->saveBinary(data);
+		}
+		snap->chunks.push_back(std::make_pair(std::string("BATL"), data));
 	}
-	out << YAML::EndMap;
-	sav << out.c_str();
-	sav.close();
+	return snap.release();
+}
+
+/**
+ * Writes a snapshot to its file, compressing all but the version and
+ * info chunks if it asks for it; those two are left alone so the saves
+ * list can read them cheaply. The file is written under a temporary name
+ * and renamed over the old save once it's complete. A delta is
+ * appended to the save instead, a cut short delta is ignored on loading.
+ * @param snapshot Snapshot to write, gets the time and size of the file.
+ */
+void SavedGame::writeSnapshot(SaveSnapshot *snapshot)
+{
+	if (snapshot->append)
+	{
+		std::ofstream out(snapshot->path.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+		if (!out)
+		{
+			throw Exception("Failed to save " + snapshot->info.file);
+		}
+		for (std::vector<std::pair<std::string, std::vector<Uint8> > >::const_iterator i = snapshot->chunks.begin(); i != snapshot->chunks.end(); ++i)
+		{
+			writeBinaryChunk(out, i->first.c_str(), i->second, snapshot->compress);
+		}
+		out.close();
+		if (!out)
+		{
+			throw Exception("Failed to save " + snapshot->info.file);
+		}
+		CrossPlatform::getFileInfo(snapshot->path, &snapshot->info.modified, &snapshot->info.size);
+		return;
+	}
+
+	std::string tmp = snapshot->path + ".tmp";
+	std::ofstream out(tmp.c_str(), std::ios::out | std::ios::binary);
+	if (!out)
+	{
+		throw Exception("Failed to save " + snapshot->info.file);
+	}
+	out.write(BINARY_MAGIC, 4);
+	for (std::vector<std::pair<std::string, std::vector<Uint8> > >::const_iterator i = snapshot->chunks.begin(); i != snapshot->chunks.end(); ++i)
+	{
+		bool compress = snapshot->compress && i->first != "VERS" && i->first != "INFO";
+		writeBinaryChunk(out, i->first.c_str(), i->second, compress);
+	}
+	out.close();
+	if (!out || !CrossPlatform::moveFile(tmp, snapshot->path))
+	{
+		CrossPlatform::deleteFile(tmp);
+		throw Exception("Failed to save " + snapshot->info.file);
+	}
+	CrossPlatform::getFileInfo(snapshot->path, &snapshot->info.modified, &snapshot->info.size);
 }
 
 /**
@@ -22,6 +22,9 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <iosfwd>
+#include <SDL_types.h>
+#include <yaml-cpp/yaml.h>
 
 namespace OpenXcom
 {
@@ -51,6 +54,31 @@ class Target;
  */
 enum GameDifficulty { DIFF_BEGINNER = 0, DIFF_EXPERIENCED, DIFF_VETERAN, DIFF_GENIUS, DIFF_SUPERHUMAN };
 
+/**
+ * What the saves list shows about a save, kept in an index
+ * in the user folder along with the time and size of the file,
+ * so the list only has to read the saves that changed.
+ */
+struct SaveInfo
+{
+	std::string file, version;
+	int weekday, day, month, year, hour, minute, second;
+	long modified, size;
+	bool battle;
+};
+
+/**
+ * A copy of a game in the binary save format, the chunks before
+ * they are compressed and written, so that can happen on another thread.
+ */
+struct SaveSnapshot
+{
+	std::string path;
+	SaveInfo info;
+	bool compress, append;
+	std::vector<std::pair<std::string, std::vector<Uint8> > > chunks;
+};
+
 /**
  * The game data that gets written to disk when the game is saved.
  * A saved game holds all the variable info in a game like funds,
@@ -83,6 +111,24 @@ private:
 	std::string _graphFinanceToggles;
 
 	void getDependableResearchBasic (std::vector<RuleResearch *> & dependables, const RuleResearch *research, const Ruleset * ruleset, Base * base) const;
+	/// Loads everything but the battle from YAML.
+	void loadGeoscape(const YAML::Node &doc, Ruleset *rule);
+	/// Saves everything but the battle to YAML.
+	void saveGeoscape(YAML::Emitter &out) const;
+	/// Loads everything but the battle from binary.
+	void loadGeoscapeBinary(Uint8 **buffer, const Uint8 *end, Ruleset *rule);
+	/// Saves everything but the battle to binary.
+	void saveGeoscapeBinary(std::vector<Uint8> &buffer) const;
+	/// Loads a saved game from the binary format.
+	void loadBinary(std::istream &in, Ruleset *rule);
+	/// Reads the saves list info from a save.
+	static SaveInfo readSaveInfo(const std::string &file);
+	/// Loads the saves index.
+	static std::map<std::string, SaveInfo> loadIndex();
+	/// Saves the saves index.
+	static void saveIndex(const std::map<std::string, SaveInfo> &index);
+	/// Gets the saves list info of this game.
+	SaveInfo getSaveInfo(const std::string &file) const;
 public:
 	/// Creates a new saved game.
 	SavedGame();
@@ -90,10 +136,16 @@ public:
 	~SavedGame();
 	/// Gets list of saves in the user directory.
 	static void getList(TextList *list, Language *lang);
-	/// Loads a saved game from YAML.
+	/// Loads a saved game from a binary or YAML file.
 	void load(const std::string &filename, Ruleset *rule);
-	/// Saves a saved game to YAML.
+	/// Saves a saved game to a binary or YAML file.
 	void save(const std::string &filename) const;
+	/// Copies the game into a snapshot of a binary save.
+	SaveSnapshot *snapshot(const std::string &filename, bool delta = false) const;
+	/// Writes a snapshot to its file.
+	static void writeSnapshot(SaveSnapshot *snapshot);
+	/// Puts a save in the saves index.
+	static void addToIndex(const SaveInfo &info);
 	/// Gets game difficulty.
 	GameDifficulty getDifficulty() const;
 	/// Sets game difficulty.
@@ -0,0 +1,255 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SerializationHelper.h"
+#include <assert.h>
+#include <cstring>
+#include <cstdlib>
+#include "../Engine/Exception.h"
+#include "../lodepng.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Reads an int of 1, 2 or 4 bytes from a buffer and moves past it.
+ */
+int unserializeInt(Uint8 **buffer, Uint8 sizeKey)
+{
+	int ret = 0;
+	switch(sizeKey)
+	{
+	case 1:
+		ret = **buffer;
+		break;
+	case 2:
+		ret = *(Sint16*)*buffer;
+		break;
+	case 3:
+		assert(false); // no.
+		break;
+	case 4:
+		ret = *(Uint32*)*buffer;
+		break;
+	default:
+		assert(false); // get out.
+	}
+
+	*buffer += sizeKey;
+
+	return ret;
+}
+
+/**
+ * Writes an int of 1, 2 or 4 bytes to a buffer and moves past it.
+ */
+void serializeInt(Uint8 **buffer, Uint8 sizeKey, int value)
+{
+	switch(sizeKey)
+	{
+	case 1:
+		assert(value < 256);
+		**buffer = value;
+		break;
+	case 2:
+		assert(value < 65536);
+		*(Sint16*)*buffer = value;
+		break;
+	case 3:
+		assert(false); // no.
+		break;
+	case 4:
+		*(Uint32*)*buffer = value;
+		break;
+	default:
+		assert(false); // get out.
+	}
+
+	*buffer += sizeKey;
+}
+
+/**
+ * Appends a 4 byte int to a buffer that grows as it is written,
+ * for data whose size isn't known up front like the binary saves.
+ */
+void serializeInt(std::vector<Uint8> &buffer, int value)
+{
+	size_t at = buffer.size();
+	buffer.resize(at + 4);
+	Uint8 *w = &buffer[at];
+	serializeInt(&w, 4, value);
+}
+
+/**
+ * Reads a 4 byte int written by the growable buffer version of serializeInt,
+ * without going past the end of the buffer.
+ */
+int unserializeInt(Uint8 **buffer, const Uint8 *end)
+{
+	if (end - *buffer < 4)
+	{
+		throw Exception("Save data is truncated");
+	}
+	return unserializeInt(buffer, 4);
+}
+
+/**
+ * Appends a string to a growable buffer, as its length and then its bytes.
+ */
+void serializeString(std::vector<Uint8> &buffer, const std::string &value)
+{
+	serializeInt(buffer, value.size());
+	buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+/**
+ * Reads a string written by serializeString, without going past the end of the buffer.
+ */
+std::string unserializeString(Uint8 **buffer, const Uint8 *end)
+{
+	size_t size = unserializeInt(buffer, end);
+	if ((size_t)(end - *buffer) < size)
+	{
+		throw Exception("Save data is truncated");
+	}
+	std::string ret((const char*)*buffer, size);
+	*buffer += size;
+	return ret;
+}
+
+/**
+ * Appends an 8 byte double to a growable buffer, as its bytes in memory.
+ */
+void serializeDouble(std::vector<Uint8> &buffer, double value)
+{
+	size_t at = buffer.size();
+	buffer.resize(at + sizeof(double));
+	memcpy(&buffer[at], &value, sizeof(double));
+}
+
+/**
+ * Reads a double written by serializeDouble, without going past the end of the buffer.
+ */
+double unserializeDouble(Uint8 **buffer, const Uint8 *end)
+{
+	if ((size_t)(end - *buffer) < sizeof(double))
+	{
+		throw Exception("Save data is truncated");
+	}
+	double ret;
+	memcpy(&ret, *buffer, sizeof(double));
+	*buffer += sizeof(double);
+	return ret;
+}
+
+/**
+ * Appends a list of ints to a growable buffer, as its length and then the ints.
+ */
+void serializeIntList(std::vector<Uint8> &buffer, const std::vector<int> &values)
+{
+	serializeInt(buffer, values.size());
+	for (std::vector<int>::const_iterator i = values.begin(); i != values.end(); ++i)
+	{
+		serializeInt(buffer, *i);
+	}
+}
+
+/**
+ * Reads a list of ints written by serializeIntList, without going past the end of the buffer.
+ */
+std::vector<int> unserializeIntList(Uint8 **buffer, const Uint8 *end)
+{
+	int size = unserializeInt(buffer, end);
+	std::vector<int> ret;
+	for (int i = 0; i < size; ++i)
+	{
+		ret.push_back(unserializeInt(buffer, end));
+	}
+	return ret;
+}
+
+/**
+ * Appends a map of names to ints to a growable buffer, as its size and then each name and int.
+ */
+void serializeIntMap(std::vector<Uint8> &buffer, const std::map<std::string, int> &values)
+{
+	serializeInt(buffer, values.size());
+	for (std::map<std::string, int>::const_iterator i = values.begin(); i != values.end(); ++i)
+	{
+		serializeString(buffer, i->first);
+		serializeInt(buffer, i->second);
+	}
+}
+
+/**
+ * Reads a map of names to ints written by serializeIntMap, without going past the end of the buffer.
+ */
+std::map<std::string, int> unserializeIntMap(Uint8 **buffer, const Uint8 *end)
+{
+	int size = unserializeInt(buffer, end);
+	std::map<std::string, int> ret;
+	for (int i = 0; i < size; ++i)
+	{
+		std::string key = unserializeString(buffer, end);
+		ret[key] = unserializeInt(buffer, end);
+	}
+	return ret;
+}
+
+/**
+ * Compresses save data with the zlib deflate in lodepng.
+ * @param in Data to compress.
+ * @param size Size of the data.
+ * @param out Returns the compressed data.
+ */
+void compressData(const Uint8 *in, size_t size, std::vector<Uint8> &out)
+{
+	unsigned char *data = 0;
+	size_t dataSize = 0;
+	unsigned error = lodepng_zlib_compress(&data, &dataSize, in, size, &lodepng_default_compress_settings);
+	if (error)
+	{
+		free(data);
+		throw Exception(std::string("Failed to compress save data: ") + lodepng_error_text(error));
+	}
+	out.assign(data, data + dataSize);
+	free(data);
+}
+
+/**
+ * Decompresses save data written by compressData.
+ * @param in Data to decompress.
+ * @param size Size of the data.
+ * @param out Returns the decompressed data.
+ */
+void decompressData(const Uint8 *in, size_t size, std::vector<Uint8> &out)
+{
+	unsigned char *data = 0;
+	size_t dataSize = 0;
+	unsigned error = lodepng_zlib_decompress(&data, &dataSize, in, size, &lodepng_default_decompress_settings);
+	if (error)
+	{
+		free(data);
+		throw Exception(std::string("Failed to decompress save data: ") + lodepng_error_text(error));
+	}
+	out.assign(data, data + dataSize);
+	free(data);
+}
+
+}
@@ -21,61 +21,42 @@
 #define OPENXCOM_SERHELP_H
 
 #include <SDL_types.h>
-#include <assert.h>
+#include <string>
+#include <vector>
+#include <map>
 
 namespace OpenXcom
 {
 
-static int unserializeInt(Uint8 **buffer, Uint8 sizeKey)
-{
-	int ret = 0;
-	switch(sizeKey)
-	{
-	case 1:
-		ret = **buffer;
-		break;
-	case 2:
-		ret = *(Sint16*)*buffer;
-		break;
-	case 3:
-		assert(false); // no.
-		break;
-	case 4:
-		ret = *(Uint32*)*buffer;
-		break;
-	default:
-		assert(false); // get out.
-	}
-
-	*buffer += sizeKey;
-
-	return ret;
-}
-
-static void serializeInt(Uint8 **buffer, Uint8 sizeKey, int value)
-{
-	switch(sizeKey)
-	{
-	case 1:
-		assert(value < 256);
-		**buffer = value;
-		break;
-	case 2:
-		assert(value < 65536);
-		*(Sint16*)*buffer = value;
-		break;
-	case 3:
-		assert(false); // no.
-		break;
-	case 4:
-		*(Uint32*)*buffer = value;
-		break;
-	default:
-		assert(false); // get out.
-	}
-
-	*buffer += sizeKey;
-}
+/// Reads an int of 1, 2 or 4 bytes from a buffer.
+int unserializeInt(Uint8 **buffer, Uint8 sizeKey);
+/// Writes an int of 1, 2 or 4 bytes to a buffer.
+void serializeInt(Uint8 **buffer, Uint8 sizeKey, int value);
+/// Appends a 4 byte int to a growable buffer.
+void serializeInt(std::vector<Uint8> &buffer, int value);
+/// Reads a 4 byte int without going past the end of the buffer.
+int unserializeInt(Uint8 **buffer, const Uint8 *end);
+/// Appends a string to a growable buffer.
+void serializeString(std::vector<Uint8> &buffer, const std::string &value);
+/// Reads a string without going past the end of the buffer.
+std::string unserializeString(Uint8 **buffer, const Uint8 *end);
+/// Appends a double to a growable buffer.
+void serializeDouble(std::vector<Uint8> &buffer, double value);
+/// Reads a double without going past the end of the buffer.
+double unserializeDouble(Uint8 **buffer, const Uint8 *end);
+/// Appends a list of ints to a growable buffer.
+void serializeIntList(std::vector<Uint8> &buffer, const std::vector<int> &values);
+/// Reads a list of ints without going past the end of the buffer.
+std::vector<int> unserializeIntList(Uint8 **buffer, const Uint8 *end);
+/// Appends a map of names to ints to a growable buffer.
+void serializeIntMap(std::vector<Uint8> &buffer, const std::map<std::string, int> &values);
+/// Reads a map of names to ints without going past the end of the buffer.
+std::map<std::string, int> unserializeIntMap(Uint8 **buffer, const Uint8 *end);
+
+/// Compresses save data.
+void compressData(const Uint8 *in, size_t size, std::vector<Uint8> &out);
+/// Decompresses save data.
+void decompressData(const Uint8 *in, size_t size, std::vector<Uint8> &out);
 
 }
 
@@ -26,6 +26,7 @@
 #include "../Ruleset/Armor.h"
 #include "../Ruleset/Ruleset.h"
 #include  "BattleUnit.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -177,6 +178,102 @@ void Soldier::save(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Reads a soldier's stats from binary.
+ * @param buffer Pointer to the stats.
+ * @param end End of the save data.
+ * @param stats Stats to set.
+ */
+static void loadBinaryStats(Uint8 **buffer, const Uint8 *end, UnitStats *stats)
+{
+	stats->tu = unserializeInt(buffer, end);
+	stats->stamina = unserializeInt(buffer, end);
+	stats->health = unserializeInt(buffer, end);
+	stats->bravery = unserializeInt(buffer, end);
+	stats->reactions = unserializeInt(buffer, end);
+	stats->firing = unserializeInt(buffer, end);
+	stats->throwing = unserializeInt(buffer, end);
+	stats->strength = unserializeInt(buffer, end);
+	stats->psiStrength = unserializeInt(buffer, end);
+	stats->psiSkill = unserializeInt(buffer, end);
+	stats->melee = unserializeInt(buffer, end);
+}
+
+/**
+ * Writes a soldier's stats to binary.
+ * @param buffer Buffer to add the stats to.
+ * @param stats Stats to write.
+ */
+static void saveBinaryStats(std::vector<Uint8> &buffer, const UnitStats &stats)
+{
+	serializeInt(buffer, stats.tu);
+	serializeInt(buffer, stats.stamina);
+	serializeInt(buffer, stats.health);
+	serializeInt(buffer, stats.bravery);
+	serializeInt(buffer, stats.reactions);
+	serializeInt(buffer, stats.firing);
+	serializeInt(buffer, stats.throwing);
+	serializeInt(buffer, stats.strength);
+	serializeInt(buffer, stats.psiStrength);
+	serializeInt(buffer, stats.psiSkill);
+	serializeInt(buffer, stats.melee);
+}
+
+/**
+ * Loads the soldier from binary. The craft it's assigned
+ * to is matched up by the base, like when loading from YAML.
+ * @param buffer Pointer to the soldier data.
+ * @param end End of the save data.
+ * @param rule Game ruleset.
+ */
+void Soldier::loadBinary(Uint8 **buffer, const Uint8 *end, const Ruleset *rule)
+{
+	_id = unserializeInt(buffer, end);
+	_name = Language::utf8ToWstr(unserializeString(buffer, end));
+	loadBinaryStats(buffer, end, &_initialStats);
+	loadBinaryStats(buffer, end, &_currentStats);
+	_rank = (SoldierRank)unserializeInt(buffer, end);
+	_gender = (SoldierGender)unserializeInt(buffer, end);
+	_look = (SoldierLook)unserializeInt(buffer, end);
+	_missions = unserializeInt(buffer, end);
+	_kills = unserializeInt(buffer, end);
+	_recovery = unserializeInt(buffer, end);
+	_armor = rule->getArmor(unserializeString(buffer, end));
+	_psiTraining = unserializeInt(buffer, end) != 0;
+	_type = unserializeString(buffer, end);
+	int layout = unserializeInt(buffer, end);
+	for (int i = 0; i < layout; ++i)
+	{
+		_equipmentLayout.push_back(new EquipmentLayoutItem(buffer, end));
+	}
+}
+
+/**
+ * Saves the soldier to binary, all but its craft.
+ * @param buffer Buffer to add the soldier to.
+ */
+void Soldier::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeInt(buffer, _id);
+	serializeString(buffer, Language::wstrToUtf8(_name));
+	saveBinaryStats(buffer, _initialStats);
+	saveBinaryStats(buffer, _currentStats);
+	serializeInt(buffer, _rank);
+	serializeInt(buffer, _gender);
+	serializeInt(buffer, _look);
+	serializeInt(buffer, _missions);
+	serializeInt(buffer, _kills);
+	serializeInt(buffer, _recovery);
+	serializeString(buffer, _armor->getType());
+	serializeInt(buffer, _psiTraining);
+	serializeString(buffer, _type);
+	serializeInt(buffer, _equipmentLayout.size());
+	for (std::vector<EquipmentLayoutItem*>::const_iterator i = _equipmentLayout.begin(); i != _equipmentLayout.end(); ++i)
+	{
+		(*i)->saveBinary(buffer);
+	}
+}
+
 /**
  * Returns the soldier's full name.
  * @return Soldier name.
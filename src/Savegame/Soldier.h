@@ -20,6 +20,8 @@
 #define OPENXCOM_SOLDIER_H
 
 #include <string>
+#include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
 #include "../Ruleset/Unit.h"
 
@@ -71,6 +73,10 @@ public:
 	void load(const YAML::Node& node, const Ruleset *rule);
 	/// Saves the soldier to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads the soldier from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end, const Ruleset *rule);
+	/// Saves the soldier to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Gets the soldier's name.
 	std::wstring getName() const;
 	/// Sets the soldier's name.
@@ -21,6 +21,7 @@
 #include <cmath>
 #include "../Engine/Language.h"
 #include "Craft.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -79,6 +80,54 @@ void Target::saveId(YAML::Emitter &out) const
 	out << YAML::Key << "lat" << YAML::Value << _lat;
 }
 
+/**
+ * Loads the target from binary.
+ * @param buffer Pointer to the target data.
+ * @param end End of the save data.
+ */
+void Target::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	_lon = unserializeDouble(buffer, end);
+	_lat = unserializeDouble(buffer, end);
+}
+
+/**
+ * Saves the target to binary.
+ * @param buffer Buffer to add the target to.
+ */
+void Target::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeDouble(buffer, _lon);
+	serializeDouble(buffer, _lat);
+}
+
+/**
+ * Saves the target's unique identifiers to binary.
+ * @param buffer Buffer to add the identifiers to.
+ */
+void Target::saveIdBinary(std::vector<Uint8> &buffer) const
+{
+	serializeDouble(buffer, _lon);
+	serializeDouble(buffer, _lat);
+}
+
+/**
+ * Reads the unique identifiers of a target saved by saveIdBinary,
+ * for the loader to find the target with. The coordinates saved
+ * with them aren't needed for that and are skipped.
+ * @param buffer Pointer to the identifiers.
+ * @param end End of the save data.
+ * @param type Returns the type of target.
+ * @param id Returns the ID of the target.
+ */
+void Target::loadIdBinary(Uint8 **buffer, const Uint8 *end, std::string *type, int *id)
+{
+	unserializeDouble(buffer, end);
+	unserializeDouble(buffer, end);
+	*type = unserializeString(buffer, end);
+	*id = unserializeInt(buffer, end);
+}
+
 /**
  * Returns the longitude coordinate of the target.
  * @return Longitude in radian.
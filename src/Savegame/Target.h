@@ -21,6 +21,7 @@
 
 #include <string>
 #include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
 
 namespace OpenXcom
@@ -48,6 +49,14 @@ public:
 	virtual void save(YAML::Emitter& out) const;
 	/// Saves the target's ID to YAML.
 	virtual void saveId(YAML::Emitter& out) const;
+	/// Loads the target from binary.
+	virtual void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the target to binary.
+	virtual void saveBinary(std::vector<Uint8> &buffer) const;
+	/// Saves the target's ID to binary.
+	virtual void saveIdBinary(std::vector<Uint8> &buffer) const;
+	/// Reads the type and ID saved by saveIdBinary.
+	static void loadIdBinary(Uint8 **buffer, const Uint8 *end, std::string *type, int *id);
 	/// Gets the target's longitude.
 	double getLongitude() const;
 	/// Sets the target's longitude.
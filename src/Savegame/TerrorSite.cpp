@@ -19,6 +19,7 @@
 #include "TerrorSite.h"
 #include <sstream>
 #include "../Engine/Language.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -76,6 +77,44 @@ void TerrorSite::saveId(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the terror site from binary.
+ * @param buffer Pointer to the terror site data.
+ * @param end End of the save data.
+ */
+void TerrorSite::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	Target::loadBinary(buffer, end);
+	_id = unserializeInt(buffer, end);
+	_secondsRemaining = unserializeInt(buffer, end);
+	_race = unserializeString(buffer, end);
+	_inBattlescape = unserializeInt(buffer, end) != 0;
+}
+
+/**
+ * Saves the terror site to binary.
+ * @param buffer Buffer to add the terror site to.
+ */
+void TerrorSite::saveBinary(std::vector<Uint8> &buffer) const
+{
+	Target::saveBinary(buffer);
+	serializeInt(buffer, _id);
+	serializeInt(buffer, _secondsRemaining);
+	serializeString(buffer, _race);
+	serializeInt(buffer, _inBattlescape);
+}
+
+/**
+ * Saves the terror site's unique identifiers to binary.
+ * @param buffer Buffer to add the identifiers to.
+ */
+void TerrorSite::saveIdBinary(std::vector<Uint8> &buffer) const
+{
+	Target::saveIdBinary(buffer);
+	serializeString(buffer, "STR_TERROR_SITE");
+	serializeInt(buffer, _id);
+}
+
 /**
  * Returns the terror site's unique ID.
  * @return Unique ID.
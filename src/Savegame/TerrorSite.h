@@ -47,6 +47,12 @@ public:
 	void save(YAML::Emitter& out) const;
 	/// Saves the terror site's ID to YAML.
 	void saveId(YAML::Emitter& out) const;
+	/// Loads the terror site from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the terror site to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
+	/// Saves the terror site's ID to binary.
+	void saveIdBinary(std::vector<Uint8> &buffer) const;
 	/// Gets the terror site's ID.
 	int getId() const;
 	/// Sets the terror site's ID.
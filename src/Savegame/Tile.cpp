@@ -17,6 +17,7 @@
  * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include "Tile.h"
+#include "TileArena.h"
 #include "../Ruleset/MapData.h"
 #include "../Ruleset/MapDataSet.h"
 #include "../Engine/SurfaceSet.h"
@@ -47,24 +48,13 @@ Tile::SerializationKey Tile::serializationKey =
 * constructor
 * @param pos Position.
 */
-Tile::Tile(const Position& pos): _smoke(0), _fire(0),  _explosive(0), _pos(pos), _unit(0), _animationOffset(0), _markerColor(0), _visible(false)
+Tile::Tile(const Position& pos, TileArena *arena, int index): _arena(arena), _index(index), _explosive(0), _pos(pos), _animationOffset(0), _markerColor(0), _voxelShape(-1), _terrainRevision(0)
 {
 	for (int i = 0; i < 4; ++i)
 	{
 		_objects[i] = 0;
-		_mapDataID[i] = -1;
-		_mapDataSetID[i] = -1;
 		_currentFrame[i] = 0;
 	}
-	for (int layer = 0; layer < LIGHTLAYERS; layer++)
-	{
-		_light[layer] = 0;
-		_lastLight[layer] = -1;
-	}
-	for (int i = 0; i < 3; ++i)
-	{
-		_discovered[i] = false;
-	}
 }
 
 /**
@@ -78,60 +68,72 @@ Tile::~Tile()
 /**
  * Load the tile from a YAML node.
  * @param node YAML node.
+ * @param discovered Returns which parts of the tile were discovered: 1 westwall, 2 northwall, 4 content+floor.
  */
-void Tile::load(const YAML::Node &node)
+void Tile::load(const YAML::Node &node, Uint8 *discovered)
 {
 	//node["position"] >> _pos;
 	for (int i =0; i < 4; i++)
 	{
-		node["mapDataID"][i] >> _mapDataID[i];
-		node["mapDataSetID"][i] >> _mapDataSetID[i];
+		node["mapDataID"][i] >> _arena->mapDataID(_index, i);
+		node["mapDataSetID"][i] >> _arena->mapDataSetID(_index, i);
 	}
 	if(const YAML::Node *pName = node.FindValue("fire"))
 	{
-		*pName >> _fire;
+		int fire;
+		*pName >> fire;
+		_arena->setFire(_index, fire);
 	}
 	else
 	{
-		_fire = 0;
+		_arena->setFire(_index, 0);
 	}
 	if(const YAML::Node *pName = node.FindValue("smoke"))
 	{
-		*pName >> _smoke;
+		int smoke;
+		*pName >> smoke;
+		_arena->setSmoke(_index, smoke);
 	}
 	else
 	{
-		_smoke = 0;
+		_arena->setSmoke(_index, 0);
 	}
+	*discovered = 0;
 	if(const YAML::Node *pName = node.FindValue("discovered"))
 	{
-		(*pName)[0] >> _discovered[0];
-		(*pName)[1] >> _discovered[1];
-		(*pName)[2] >> _discovered[2];
+		for (int i = 0; i < 3; ++i)
+		{
+			bool flag;
+			(*pName)[i] >> flag;
+			if (flag)
+			{
+				*discovered |= 1 << i;
+			}
+		}
 	}
 }
 
 /**
  * Load the tile from binary.
  * @param buffer pointer to buffer.
+ * @param serKey How many bytes each field was saved with.
+ * @param discovered Returns which parts of the tile were discovered: 1 westwall, 2 northwall, 4 content+floor.
  */
-void Tile::loadBinary(Uint8 **buffer, Tile::SerializationKey& serKey)
+void Tile::loadBinary(Uint8 **buffer, Tile::SerializationKey& serKey, Uint8 *discovered)
 {
-	_mapDataID[0] = unserializeInt(buffer, serKey._mapDataID);
-	_mapDataID[1] = unserializeInt(buffer, serKey._mapDataID);
-	_mapDataID[2] = unserializeInt(buffer, serKey._mapDataID);
-	_mapDataID[3] = unserializeInt(buffer, serKey._mapDataID);
-	_mapDataSetID[0] = unserializeInt(buffer, serKey._mapDataSetID);
-	_mapDataSetID[1] = unserializeInt(buffer, serKey._mapDataSetID);
-	_mapDataSetID[2] = unserializeInt(buffer, serKey._mapDataSetID);
-	_mapDataSetID[3] = unserializeInt(buffer, serKey._mapDataSetID);
+	_arena->mapDataID(_index, 0) = unserializeInt(buffer, serKey._mapDataID);
+	_arena->mapDataID(_index, 1) = unserializeInt(buffer, serKey._mapDataID);
+	_arena->mapDataID(_index, 2) = unserializeInt(buffer, serKey._mapDataID);
+	_arena->mapDataID(_index, 3) = unserializeInt(buffer, serKey._mapDataID);
+	_arena->mapDataSetID(_index, 0) = unserializeInt(buffer, serKey._mapDataSetID);
+	_arena->mapDataSetID(_index, 1) = unserializeInt(buffer, serKey._mapDataSetID);
+	_arena->mapDataSetID(_index, 2) = unserializeInt(buffer, serKey._mapDataSetID);
+	_arena->mapDataSetID(_index, 3) = unserializeInt(buffer, serKey._mapDataSetID);
 
-	_smoke = unserializeInt(buffer, serKey._smoke);
-	_fire = unserializeInt(buffer, serKey._fire);
+	_arena->setSmoke(_index, unserializeInt(buffer, serKey._smoke));
+	_arena->setFire(_index, unserializeInt(buffer, serKey._fire));
 
-	_discovered[0] = (**buffer & 1) ? true : false;
-	_discovered[1] = (**buffer & 2) ? true : false;
-	_discovered[2] = (**buffer & 4) ? true : false;
+	*discovered = **buffer & 7;
 	++(*buffer);
 }
 
@@ -139,45 +141,47 @@ void Tile::loadBinary(Uint8 **buffer, Tile::SerializationKey& serKey)
 /**
  * Saves the tile to a YAML node.
  * @param out YAML emitter.
+ * @param discovered Which parts of the tile are discovered: 1 westwall, 2 northwall, 4 content+floor.
  */
-void Tile::save(YAML::Emitter &out) const
+void Tile::save(YAML::Emitter &out, Uint8 discovered) const
 {
 	out << YAML::BeginMap;
 	out << YAML::Key << "position" << YAML::Value << _pos;
 	out << YAML::Key << "mapDataID" << YAML::Value << YAML::Flow;
-	out << YAML::BeginSeq << _mapDataID[0] << _mapDataID[1] << _mapDataID[2] << _mapDataID[3] << YAML::EndSeq;
+	out << YAML::BeginSeq << _arena->mapDataID(_index, 0) << _arena->mapDataID(_index, 1) << _arena->mapDataID(_index, 2) << _arena->mapDataID(_index, 3) << YAML::EndSeq;
 	out << YAML::Key << "mapDataSetID" << YAML::Value << YAML::Flow;
-	out << YAML::BeginSeq << _mapDataSetID[0] << _mapDataSetID[1] << _mapDataSetID[2] << _mapDataSetID[3] << YAML::EndSeq;
-	if (_smoke)
-		out << YAML::Key << "smoke" << YAML::Value << _smoke;
-	if (_fire)
-		out << YAML::Key << "fire" << YAML::Value << _fire;
-	if (_discovered[0] || _discovered[1] || _discovered[2])
+	out << YAML::BeginSeq << _arena->mapDataSetID(_index, 0) << _arena->mapDataSetID(_index, 1) << _arena->mapDataSetID(_index, 2) << _arena->mapDataSetID(_index, 3) << YAML::EndSeq;
+	if (_arena->getSmoke(_index))
+		out << YAML::Key << "smoke" << YAML::Value << _arena->getSmoke(_index);
+	if (_arena->getFire(_index))
+		out << YAML::Key << "fire" << YAML::Value << _arena->getFire(_index);
+	if (discovered)
 	{
 		out << YAML::Key << "discovered" << YAML::Value << YAML::Flow;
-		out << YAML::BeginSeq << _discovered[0] << _discovered[1] << _discovered[2] << YAML::EndSeq;
+		out << YAML::BeginSeq << ((discovered & 1) != 0) << ((discovered & 2) != 0) << ((discovered & 4) != 0) << YAML::EndSeq;
 	}
 	out << YAML::EndMap;
 }
 /**
  * Saves the tile to binary.
  * @param buffer pointer to buffer.
+ * @param discovered Which parts of the tile are discovered: 1 westwall, 2 northwall, 4 content+floor.
  */
-void Tile::saveBinary(Uint8** buffer) const
+void Tile::saveBinary(Uint8** buffer, Uint8 discovered) const
 {
-	serializeInt(buffer, serializationKey._mapDataID, _mapDataID[0]);
-	serializeInt(buffer, serializationKey._mapDataID, _mapDataID[1]);
-	serializeInt(buffer, serializationKey._mapDataID, _mapDataID[2]);
-	serializeInt(buffer, serializationKey._mapDataID, _mapDataID[3]);
-	serializeInt(buffer, serializationKey._mapDataSetID, _mapDataSetID[0]);
-	serializeInt(buffer, serializationKey._mapDataSetID, _mapDataSetID[1]);
-	serializeInt(buffer, serializationKey._mapDataSetID, _mapDataSetID[2]);
-	serializeInt(buffer, serializationKey._mapDataSetID, _mapDataSetID[3]);
+	serializeInt(buffer, serializationKey._mapDataID, _arena->mapDataID(_index, 0));
+	serializeInt(buffer, serializationKey._mapDataID, _arena->mapDataID(_index, 1));
+	serializeInt(buffer, serializationKey._mapDataID, _arena->mapDataID(_index, 2));
+	serializeInt(buffer, serializationKey._mapDataID, _arena->mapDataID(_index, 3));
+	serializeInt(buffer, serializationKey._mapDataSetID, _arena->mapDataSetID(_index, 0));
+	serializeInt(buffer, serializationKey._mapDataSetID, _arena->mapDataSetID(_index, 1));
+	serializeInt(buffer, serializationKey._mapDataSetID, _arena->mapDataSetID(_index, 2));
+	serializeInt(buffer, serializationKey._mapDataSetID, _arena->mapDataSetID(_index, 3));
 
-	serializeInt(buffer, serializationKey._smoke, _smoke);
-	serializeInt(buffer, serializationKey._fire, _fire);
+	serializeInt(buffer, serializationKey._smoke, _arena->getSmoke(_index));
+	serializeInt(buffer, serializationKey._fire, _arena->getFire(_index));
 
-	**buffer = (_discovered[0]?1:0) + (_discovered[1]?2:0) + (_discovered[2]?4:0);
+	**buffer = discovered;
 	++(*buffer);
 }
 
@@ -204,8 +208,10 @@ MapData *Tile::getMapData(int part) const
 void Tile::setMapData(MapData *dat, int mapDataID, int mapDataSetID, int part)
 {
 	_objects[part] = dat;
-	_mapDataID[part] = mapDataID;
-	_mapDataSetID[part] = mapDataSetID;
+	_arena->mapDataID(_index, part) = mapDataID;
+	_arena->mapDataSetID(_index, part) = mapDataSetID;
+	_voxelShape = -1;
+	_terrainRevision = _arena->changeTerrain();
 }
 
 /**
@@ -215,8 +221,8 @@ void Tile::setMapData(MapData *dat, int mapDataID, int mapDataSetID, int part)
  */
 void Tile::getMapData(int *mapDataID, int *mapDataSetID, int part) const
 {
-	*mapDataID = _mapDataID[part];
-	*mapDataSetID = _mapDataSetID[part];
+	*mapDataID = _arena->mapDataID(_index, part);
+	*mapDataSetID = _arena->mapDataSetID(_index, part);
 }
 
 /**
@@ -225,7 +231,7 @@ void Tile::getMapData(int *mapDataID, int *mapDataSetID, int part) const
  */
 bool Tile::isVoid() const
 {
-	return _objects[0] == 0 && _objects[1] == 0 && _objects[2] == 0 && _objects[3] == 0 && _smoke == 0 && _inventory.size() == 0;
+	return _objects[0] == 0 && _objects[1] == 0 && _objects[2] == 0 && _objects[3] == 0 && _arena->getSmoke(_index) == 0 && _inventory.size() == 0;
 }
 
 /**
@@ -330,7 +336,7 @@ int Tile::openDoor(int part, BattleUnit *unit, bool debug)
 	{
 		if (unit && unit->getTimeUnits() < _objects[part]->getTUCost(unit->getArmor()->getMovementType()) && !debug)
 			return 4;
-		setMapData(_objects[part]->getDataset()->getObjects()->at(_objects[part]->getAltMCD()), _objects[part]->getAltMCD(), _mapDataSetID[part],
+		setMapData(_objects[part]->getDataset()->getObjects()->at(_objects[part]->getAltMCD()), _objects[part]->getAltMCD(), _arena->mapDataSetID(_index, part),
 				   _objects[part]->getDataset()->getObjects()->at(_objects[part]->getAltMCD())->getObjectType());
 		setMapData(0, -1, -1, part);
 		return 0;
@@ -340,6 +346,8 @@ int Tile::openDoor(int part, BattleUnit *unit, bool debug)
 		if (unit && unit->getTimeUnits() < _objects[part]->getTUCost(unit->getArmor()->getMovementType()) && !debug)
 			return 4;
 		_currentFrame[part] = 1; // start opening door
+		_voxelShape = -1;
+		_terrainRevision = _arena->changeTerrain();
 		return 1;
 	}
 	if (_objects[part]->isUFODoor() && _currentFrame[part] != 7) // ufo door != part 7 - door is still opening
@@ -373,6 +381,8 @@ int Tile::closeUfoDoor()
 		if (isUfoDoorOpen(part))
 		{
 			_currentFrame[part] = 0;
+			_voxelShape = -1;
+			_terrainRevision = _arena->changeTerrain();
 			retval = 1;
 		}
 	}
@@ -380,48 +390,13 @@ int Tile::closeUfoDoor()
 	return retval;
 }
 
-/**
- * Sets the tile's cache flag. - TODO: set this for each object separately?
- * @param flag true/false
- * @param part 0-2 westwall/northwall/content+floor
- */
-void Tile::setDiscovered(bool flag, int part)
-{
-	if (_discovered[part] != flag)
-	{
-		_discovered[part] = flag;
-		if (part == 2 && flag == true)
-		{
-			_discovered[0] = true;
-			_discovered[1] = true;
-		}
-		// if light on tile changes, units and objects on it change light too
-		if (_unit != 0)
-		{
-			_unit->setCache(0);
-		}
-	}
-}
-
-/**
- * Get the black fog of war state of this tile.
- * @param part 0-2 westwall/northwall/content+floor
- * @return bool True = discovered the tile.
- */
-bool Tile::isDiscovered(int part) const
-{
-	return _discovered[part];
-}
-
-
 /**
  * Reset the light amount on the tile. This is done before a light level recalculation.
  * @param layer Light is separated in 3 layers: Ambient, Static and Dynamic.
  */
 void Tile::resetLight(int layer)
 {
-	_light[layer] = 0;
-	_lastLight[layer] = _light[layer];
+	_arena->light(_index, layer) = 0;
 }
 
 /**
@@ -431,8 +406,8 @@ void Tile::resetLight(int layer)
  */
 void Tile::addLight(int light, int layer)
 {
-	if (_light[layer] < light)
-		_light[layer] = light;
+	if (_arena->light(_index, layer) < light)
+		_arena->light(_index, layer) = light;
 }
 
 /**
@@ -444,10 +419,10 @@ int Tile::getShade() const
 {
 	int light = 0;
 
-	for (int layer = 0; layer < LIGHTLAYERS; layer++)
+	for (int layer = 0; layer < TileArena::LIGHTLAYERS; layer++)
 	{
-		if (_light[layer] > light)
-			light = _light[layer];
+		if (_arena->light(_index, layer) > light)
+			light = _arena->light(_index, layer);
 	}
 
 	return 15 - light;
@@ -467,7 +442,7 @@ bool Tile::destroy(int part)
 	{
 		_objective = _objects[part]->getSpecialType() == MUST_DESTROY;
 		MapData *originalPart = _objects[part];
-		int originalMapDataSetID = _mapDataSetID[part];
+		int originalMapDataSetID = _arena->mapDataSetID(_index, part);
 		setMapData(0, -1, -1, part);
 		if (originalPart->getDieMCD())
 		{
@@ -632,6 +607,10 @@ void Tile::animate()
 			{
 				newframe = 0;
 			}
+			if (_objects[i]->isUFODoor())
+			{
+				_terrainRevision = _arena->changeTerrain(); // the door stops costing TUs once it starts opening
+			}
 			_currentFrame[i] = newframe;
 		}
 	}
@@ -660,7 +639,7 @@ void Tile::setUnit(BattleUnit *unit, Tile *tileBelow)
 	{
 		unit->setTile(this, tileBelow);
 	}
-	_unit = unit;
+	_arena->setUnit(_index, unit);
 }
 
 /**
@@ -669,7 +648,7 @@ void Tile::setUnit(BattleUnit *unit, Tile *tileBelow)
  */
 BattleUnit *Tile::getUnit() const
 {
-	return _unit;
+	return _arena->getUnit(_index);
 }
 
 /**
@@ -678,7 +657,7 @@ BattleUnit *Tile::getUnit() const
  */
 void Tile::setFire(int fire)
 {
-	_fire = fire;
+	_arena->setFire(_index, fire);
 	_animationOffset = RNG::generate(0,3);
 }
 
@@ -688,7 +667,7 @@ void Tile::setFire(int fire)
  */
 int Tile::getFire() const
 {
-	return _fire;
+	return _arena->getFire(_index);
 }
 
 /**
@@ -697,8 +676,9 @@ int Tile::getFire() const
  */
 void Tile::addSmoke(int smoke)
 {
-	_smoke += smoke;
-	if (_smoke > 40) _smoke = 40;
+	int total = _arena->getSmoke(_index) + smoke;
+	if (total > 40) total = 40;
+	_arena->setSmoke(_index, total);
 	_animationOffset = RNG::generate(0,3);
 }
 
@@ -708,7 +688,7 @@ void Tile::addSmoke(int smoke)
  */
 int Tile::getSmoke() const
 {
-	return _smoke;
+	return _arena->getSmoke(_index);
 }
 
 /**
@@ -777,10 +757,14 @@ bool Tile::prepareNewTurn()
 {
 	bool objective = false;
 
-	_smoke--;
-	if (_smoke < 0) _smoke = 0;
+	int smoke = _arena->getSmoke(_index);
+	int fire = _arena->getFire(_index);
 
-	if (_fire == 1)
+	smoke--;
+	if (smoke < 0) smoke = 0;
+	_arena->setSmoke(_index, smoke);
+
+	if (fire == 1)
 	{
 		// fire will be finished in this turn
 		// destroy all objects that burned, and try to ignite again
@@ -800,13 +784,14 @@ bool Tile::prepareNewTurn()
 		}
 		else
 		{
-			_fire = 0;
+			_arena->setFire(_index, 0);
 		}
 	}
 	else
 	{
-		_fire--;
-		if (_fire < 0) _fire = 0;
+		fire--;
+		if (fire < 0) fire = 0;
+		_arena->setFire(_index, fire);
 	}
 
 	return objective;
@@ -841,19 +826,33 @@ int Tile::getMarkerColor()
 }
 
 /**
- * Set the tile visible flag.
+ * Get the index of the tile's merged terrain voxels in the tile engine's shape cache.
+ * @return shape index, or -1 if the terrain changed since it was last cached.
+ */
+int Tile::getVoxelShape() const
+{
+	return _voxelShape;
+}
+
+/**
+ * Set the index of the tile's merged terrain voxels in the tile engine's shape cache.
+ * Any change to the tile parts or to a ufo door resets it to -1.
+ * @param shape shape index
  */
-void Tile::setVisible(int visibility)
+void Tile::setVoxelShape(int shape)
 {
-	_visible += visibility;
+	_voxelShape = shape;
 }
 
 /**
- * Get the tile visible flag.
+ * Get a counter that goes up every time the terrain of this tile changes:
+ * parts replaced or destroyed, doors opened or ufo doors animating.
+ * Used by the pathfinding to know which cached move costs are stale.
+ * @return terrain revision
  */
-int Tile::getVisible()
+int Tile::getTerrainRevision() const
 {
-	return _visible;
+	return _terrainRevision;
 }
 
 }
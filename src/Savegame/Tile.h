@@ -35,9 +35,12 @@ class MapData;
 class BattleUnit;
 class BattleItem;
 class RuleInventory;
+class TileArena;
 
 /**
  * Basic element of which a battle map is build.
+ * Tiles live in a TileArena, which also keeps their fire, smoke,
+ * light, unit and map data IDs.
  * @sa http://www.ufopaedia.org/index.php?title=MAPS
  */
 class Tile
@@ -62,35 +65,33 @@ public:
 	int closestAlienDSqr;
 
 protected:
-	static const int LIGHTLAYERS = 3;
+	TileArena *_arena;
+	int _index;
 	MapData *_objects[4];
-	int _mapDataID[4];
-	int _mapDataSetID[4];
 	int _currentFrame[4];
-	bool _discovered[3];
-	int _light[LIGHTLAYERS], _lastLight[LIGHTLAYERS];
-	int _smoke;
-	int _fire;
 	int _explosive;
 	Position _pos;
-	BattleUnit *_unit;
 	std::vector<BattleItem *> _inventory;
 	int _animationOffset;
 	int _markerColor;
-	int _visible;
+	int _voxelShape;
+	int _terrainRevision;
+private:
+	Tile(const Tile&);
+	Tile &operator=(const Tile&);
 public:
-	/// Creates a tile.
-	Tile(const Position& pos);
+	/// Creates a tile in an arena.
+	Tile(const Position& pos, TileArena *arena, int index);
 	/// Cleans up a tile.
 	~Tile();
 	/// Load the tile from yaml
-	void load(const YAML::Node &node);
+	void load(const YAML::Node &node, Uint8 *discovered);
 	/// Load the tile from binary buffer in memory
-	void loadBinary(Uint8 **buffer, Tile::SerializationKey& serializationKey);
+	void loadBinary(Uint8 **buffer, Tile::SerializationKey& serializationKey, Uint8 *discovered);
 	/// Saves the tile to yaml
-	void save(YAML::Emitter &out) const;
+	void save(YAML::Emitter &out, Uint8 discovered) const;
 	/// Saves the tile to binary
-	void saveBinary(Uint8** buffer) const;
+	void saveBinary(Uint8** buffer, Uint8 discovered) const;
 	/// Gets a pointer to the mapdata for a specific part of the tile.
 	MapData *getMapData(int part) const;
 	/// Sets the pointer to the mapdata for a specific part of the tile
@@ -117,10 +118,6 @@ public:
 	bool isUfoDoorOpen(int part) const;
 	/// Close ufo door.
 	int closeUfoDoor();
-	/// Sets the black fog of war status of this tile.
-	void setDiscovered(bool flag, int part);
-	/// Gets the black fog of war status of this tile.
-	bool isDiscovered(int part) const;
 	/// Reset light to zero for this tile.
 	void resetLight(int layer);
 	/// Add light to this tile.
@@ -173,10 +170,12 @@ public:
 	void setMarkerColor(int color);
 	/// Get the tile marker color.
 	int getMarkerColor();
-	/// Set the tile visible flag.
-	void setVisible(int visibility);
-	/// Get the tile visible flag.
-	int getVisible();
+	/// Get the index of the tile's cached voxel shape.
+	int getVoxelShape() const;
+	/// Set the index of the tile's cached voxel shape.
+	void setVoxelShape(int shape);
+	/// Get how many times the tile's terrain has changed.
+	int getTerrainRevision() const;
 
 };
 
@@ -0,0 +1,230 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "TileArena.h"
+#include <new>
+#include <algorithm>
+#include "Tile.h"
+
+namespace OpenXcom
+{
+
+/**
+ * Creates the tiles of a map, empty and unlit, in one block.
+ * @param mapsize_x Width of the map.
+ * @param mapsize_y Length of the map.
+ * @param mapsize_z Height of the map.
+ */
+TileArena::TileArena(int mapsize_x, int mapsize_y, int mapsize_z) : _size(mapsize_x * mapsize_y * mapsize_z), _block(0), _tiles(_size), _fire(_size, 0), _smoke(_size, 0), _units(_size, (BattleUnit*)0), _terrainRevision(0)
+{
+	for (int layer = 0; layer < LIGHTLAYERS; ++layer)
+	{
+		_light[layer].assign(_size, 0);
+	}
+	for (int part = 0; part < 4; ++part)
+	{
+		_mapDataIDs[part].assign(_size, -1);
+		_mapDataSetIDs[part].assign(_size, -1);
+	}
+
+	_burningListed.resize(_size);
+	_smokingListed.resize(_size);
+
+	_block = static_cast<Tile*>(::operator new(sizeof(Tile) * _size));
+	for (int i = 0; i < _size; ++i)
+	{
+		// same order as SavedBattleGame::getTileIndex
+		Position pos(i % mapsize_x, (i / mapsize_x) % mapsize_y, i / (mapsize_x * mapsize_y));
+		_tiles[i] = new (&_block[i]) Tile(pos, this, i);
+	}
+}
+
+/**
+ * Cleans up the tiles.
+ */
+TileArena::~TileArena()
+{
+	for (int i = 0; i < _size; ++i)
+	{
+		_block[i].~Tile();
+	}
+	::operator delete(_block);
+}
+
+/**
+ * Puts out the light of a layer on every tile, before it is worked out again.
+ * @param layer Light is separated in 3 layers: Ambient, Static and Dynamic.
+ */
+void TileArena::resetLight(int layer)
+{
+	std::fill(_light[layer].begin(), _light[layer].end(), 0);
+}
+
+/**
+ * Sets the number of turns a tile is on fire, and lists it
+ * among the burning tiles if it wasn't already.
+ * @param index Index of the tile.
+ * @param fire Number of turns, 0 for no fire.
+ */
+void TileArena::setFire(int index, int fire)
+{
+	_fire[index] = fire;
+	if (fire > 0 && !_burningListed.get(index))
+	{
+		_burningListed.set(index);
+		_burning.push_back(index);
+	}
+}
+
+/**
+ * Sets the number of turns a tile is smoking, and lists it
+ * among the smoking tiles if it wasn't already.
+ * @param index Index of the tile.
+ * @param smoke Number of turns, 0 for no smoke.
+ */
+void TileArena::setSmoke(int index, int smoke)
+{
+	_smoke[index] = smoke;
+	if (smoke > 0 && !_smokingListed.get(index))
+	{
+		_smokingListed.set(index);
+		_smoking.push_back(index);
+	}
+}
+
+/**
+ * Sets the unit on a tile, and puts the tile on the list of occupied
+ * tiles or takes it off. Unlike the fire and smoke lists, this one is
+ * kept in order as it goes, since it's short, and so can be read by the
+ * pathfinding on several threads at once.
+ * @param index Index of the tile.
+ * @param unit Pointer to the unit, 0 for none.
+ */
+void TileArena::setUnit(int index, BattleUnit *unit)
+{
+	if ((_units[index] == 0) != (unit == 0))
+	{
+		std::vector<int>::iterator i = std::lower_bound(_occupied.begin(), _occupied.end(), index);
+		if (unit != 0)
+		{
+			_occupied.insert(i, index);
+		}
+		else
+		{
+			_occupied.erase(i);
+		}
+	}
+	_units[index] = unit;
+}
+
+/**
+ * Drops the tiles that went out from a list and puts the rest in tile index order,
+ * the order a pass over the whole map would find them in.
+ * @param tiles The list of tiles.
+ * @param listed Which tiles are in the list.
+ * @param values The fire or smoke of every tile.
+ */
+void TileArena::prune(std::vector<int> &tiles, BitPlane &listed, const std::vector<int> &values)
+{
+	std::vector<int>::iterator end = tiles.begin();
+	for (std::vector<int>::iterator i = tiles.begin(); i != tiles.end(); ++i)
+	{
+		if (values[*i] > 0)
+		{
+			*end++ = *i;
+		}
+		else
+		{
+			listed.reset(*i);
+		}
+	}
+	tiles.erase(end, tiles.end());
+	std::sort(tiles.begin(), tiles.end());
+}
+
+/**
+ * Gets the tiles on fire, in tile index order.
+ * @return Indexes of the tiles.
+ */
+const std::vector<int> &TileArena::getBurningTiles()
+{
+	prune(_burning, _burningListed, _fire);
+	return _burning;
+}
+
+/**
+ * Gets the smoking tiles, in tile index order.
+ * @return Indexes of the tiles.
+ */
+const std::vector<int> &TileArena::getSmokingTiles()
+{
+	prune(_smoking, _smokingListed, _smoke);
+	return _smoking;
+}
+
+/**
+ * Creates an empty snapshot of the units on an arena.
+ * @param state Function giving the part of a unit's state that counts.
+ */
+OccupancySnapshot::OccupancySnapshot(StateFunction state) : _state(state)
+{
+}
+
+/**
+ * Takes a new snapshot of the units on an arena and finds the tiles a unit came onto
+ * or left, or where the unit's state changed, since the last one. Both lists of
+ * occupied tiles are in tile index order, so they're merged in one pass.
+ * @param arena The tiles of the map.
+ * @param changed The vector to add the indexes of the tiles to, in tile index order.
+ */
+void OccupancySnapshot::update(const TileArena *arena, std::vector<int> *changed)
+{
+	const std::vector<int> &occupied = arena->getOccupiedTiles();
+	std::vector<Occupant> occupants;
+	occupants.reserve(occupied.size());
+	for (std::vector<int>::const_iterator i = occupied.begin(); i != occupied.end(); ++i)
+	{
+		BattleUnit *unit = arena->getUnit(*i);
+		Occupant occupant = { *i, unit, _state(unit) };
+		occupants.push_back(occupant);
+	}
+	size_t i = 0, j = 0;
+	while (i < occupants.size() || j < _occupants.size())
+	{
+		if (j == _occupants.size() || (i < occupants.size() && occupants[i].index < _occupants[j].index))
+		{
+			changed->push_back(occupants[i++].index);
+		}
+		else if (i == occupants.size() || _occupants[j].index < occupants[i].index)
+		{
+			changed->push_back(_occupants[j++].index);
+		}
+		else
+		{
+			if (occupants[i].unit != _occupants[j].unit || occupants[i].state != _occupants[j].state)
+			{
+				changed->push_back(occupants[i].index);
+			}
+			++i;
+			++j;
+		}
+	}
+	_occupants.swap(occupants);
+}
+
+}
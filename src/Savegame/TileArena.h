@@ -0,0 +1,136 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef OPENXCOM_TILEARENA_H
+#define OPENXCOM_TILEARENA_H
+
+#include <vector>
+#include "BitPlane.h"
+
+namespace OpenXcom
+{
+
+class Tile;
+class BattleUnit;
+
+/**
+ * All the tiles of a battle map in one block of memory, in tile index order.
+ * The state of the tiles that passes over the whole map look at (fire, smoke,
+ * light, units and map data IDs) is kept out of the tiles, in one array
+ * per field indexed by tile index, so such a pass only touches the field
+ * it needs. The tiles themselves read and write their entries in the arrays,
+ * so code going through a Tile sees no difference.
+ * The arena also keeps lists of the tiles that are on fire or smoking
+ * or have a unit on them, and counts terrain changes, so the turn's fire
+ * and smoke and the pathfinding's checks for changes don't need a pass
+ * over the whole map at all.
+ */
+class TileArena
+{
+public:
+	static const int LIGHTLAYERS = 3;
+private:
+	int _size;
+	Tile *_block;
+	std::vector<Tile*> _tiles;
+	std::vector<int> _fire, _smoke;
+	std::vector<int> _burning, _smoking;
+	BitPlane _burningListed, _smokingListed;
+	/// Drops the tiles that went out from a list and sorts it.
+	void prune(std::vector<int> &tiles, BitPlane &listed, const std::vector<int> &values);
+	std::vector<int> _light[LIGHTLAYERS];
+	std::vector<BattleUnit*> _units;
+	std::vector<int> _occupied;
+	int _terrainRevision;
+	std::vector<int> _mapDataIDs[4], _mapDataSetIDs[4];
+	TileArena(const TileArena&);
+	TileArena &operator=(const TileArena&);
+public:
+	/// Creates the tiles of a map.
+	TileArena(int mapsize_x, int mapsize_y, int mapsize_z);
+	/// Cleans up the tiles.
+	~TileArena();
+	/// Gets the number of tiles.
+	int getSize() const { return _size; }
+	/// Gets the pointers to the tiles, in tile index order.
+	Tile **getTiles() { return _tiles.empty() ? 0 : &_tiles[0]; }
+	/// Gets the number of turns a tile is on fire.
+	int getFire(int index) const { return _fire[index]; }
+	/// Sets the number of turns a tile is on fire.
+	void setFire(int index, int fire);
+	/// Gets the number of turns a tile is smoking.
+	int getSmoke(int index) const { return _smoke[index]; }
+	/// Sets the number of turns a tile is smoking.
+	void setSmoke(int index, int smoke);
+	/// Gets the light of a tile on a layer.
+	int &light(int index, int layer) { return _light[layer][index]; }
+	/// Gets the unit on a tile.
+	BattleUnit *getUnit(int index) const { return _units[index]; }
+	/// Sets the unit on a tile.
+	void setUnit(int index, BattleUnit *unit);
+	/// Gets the ID of a tile part's map data.
+	int &mapDataID(int index, int part) { return _mapDataIDs[part][index]; }
+	/// Gets the ID of a tile part's map data set.
+	int &mapDataSetID(int index, int part) { return _mapDataSetIDs[part][index]; }
+	/// Gets the tiles on fire.
+	const std::vector<int> &getBurningTiles();
+	/// Gets the smoking tiles.
+	const std::vector<int> &getSmokingTiles();
+	/// Gets the tiles with a unit on them.
+	const std::vector<int> &getOccupiedTiles() const { return _occupied; }
+	/// Counts a change to the terrain of a tile.
+	int changeTerrain() { return ++_terrainRevision; }
+	/// Gets the count of terrain changes on the whole map.
+	int getTerrainRevision() const { return _terrainRevision; }
+	/// Puts out the light of a layer on every tile.
+	void resetLight(int layer);
+};
+
+/**
+ * The units on the tiles of an arena, as they were at the last update, so the tiles
+ * where a unit came, left or changed can be found from the arena's list of occupied
+ * tiles instead of a pass over the whole map. What counts as a change in a unit
+ * is up to the user, through the state it gives for each unit.
+ */
+class OccupancySnapshot
+{
+public:
+	/// Gets the part of a unit's state whose change counts as a change on its tile.
+	typedef int (*StateFunction)(BattleUnit *unit);
+private:
+	/// A unit standing on a tile, as it was at the last update.
+	struct Occupant
+	{
+		int index;
+		BattleUnit *unit;
+		int state;
+	};
+	StateFunction _state;
+	std::vector<Occupant> _occupants;
+public:
+	/// Creates an empty snapshot.
+	OccupancySnapshot(StateFunction state);
+	/// Takes a new snapshot and finds the tiles that changed since the last one.
+	void update(const TileArena *arena, std::vector<int> *changed);
+	/// Forgets the snapshot, so every occupied tile counts as changed at the next update.
+	void clear() { _occupants.clear(); }
+};
+
+}
+
+#endif
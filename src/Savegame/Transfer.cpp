@@ -23,6 +23,7 @@
 #include "ItemContainer.h"
 #include "../Engine/Language.h"
 #include "../Ruleset/Ruleset.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -119,6 +120,57 @@ void Transfer::save(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the transfer from binary.
+ * @param buffer Pointer to the transfer data.
+ * @param end End of the save data.
+ * @param base Destination base.
+ * @param rule Game ruleset.
+ */
+void Transfer::loadBinary(Uint8 **buffer, const Uint8 *end, Base *base, const Ruleset *rule)
+{
+	if (unserializeInt(buffer, end))
+	{
+		_soldier = new Soldier(rule->getSoldier("XCOM"), rule->getArmor("STR_NONE_UC"));
+		_soldier->loadBinary(buffer, end, rule);
+	}
+	if (unserializeInt(buffer, end))
+	{
+		_craft = new Craft(rule->getCraft(unserializeString(buffer, end)), base);
+		_craft->loadBinary(buffer, end, rule, 0);
+	}
+	_itemId = unserializeString(buffer, end);
+	_itemQty = unserializeInt(buffer, end);
+	_scientists = unserializeInt(buffer, end);
+	_engineers = unserializeInt(buffer, end);
+	_delivered = unserializeInt(buffer, end) != 0;
+}
+
+/**
+ * Saves the transfer to binary, its hours first
+ * for the loader to make it with.
+ * @param buffer Buffer to add the transfer to.
+ */
+void Transfer::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeInt(buffer, _hours);
+	serializeInt(buffer, _soldier != 0);
+	if (_soldier != 0)
+	{
+		_soldier->saveBinary(buffer);
+	}
+	serializeInt(buffer, _craft != 0);
+	if (_craft != 0)
+	{
+		_craft->saveBinary(buffer);
+	}
+	serializeString(buffer, _itemId);
+	serializeInt(buffer, _itemQty);
+	serializeInt(buffer, _scientists);
+	serializeInt(buffer, _engineers);
+	serializeInt(buffer, _delivered);
+}
+
 /**
  * Changes the soldier being transferred.
  * @param soldier Pointer to soldier.
@@ -20,6 +20,8 @@
 #define OPENXCOM_TRANSFER_H
 
 #include <string>
+#include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
 
 namespace OpenXcom
@@ -56,6 +58,10 @@ public:
 	void load(const YAML::Node& node, Base *base, const Ruleset *rule);
 	/// Saves the transfer to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads the transfer from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end, Base *base, const Ruleset *rule);
+	/// Saves the transfer to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Sets the soldier of the transfer.
 	void setSoldier(Soldier *soldier);
 	/// Sets the craft of the transfer.
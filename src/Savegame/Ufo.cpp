@@ -25,6 +25,7 @@
 #include "../Ruleset/UfoTrajectory.h"
 #include "SavedGame.h"
 #include "Waypoint.h"
+#include "SerializationHelper.h"
 #include <cmath>
 #include <sstream>
 #include <algorithm>
@@ -183,6 +184,81 @@ void Ufo::saveId(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the UFO from binary.
+ * @param buffer Pointer to the UFO data.
+ * @param end End of the save data.
+ * @param ruleset The game rules. Use to access the trajectory rules.
+ * @param game The game data. Used to find the UFO's mission.
+ */
+void Ufo::loadBinary(Uint8 **buffer, const Uint8 *end, const Ruleset &ruleset, SavedGame &game)
+{
+	MovingTarget::loadBinary(buffer, end);
+	double lon = unserializeDouble(buffer, end);
+	double lat = unserializeDouble(buffer, end);
+	_dest = new Waypoint();
+	_dest->setLongitude(lon);
+	_dest->setLatitude(lat);
+	_id = unserializeInt(buffer, end);
+	_damage = unserializeInt(buffer, end);
+	_altitude = unserializeString(buffer, end);
+	_direction = unserializeString(buffer, end);
+	_status = (UfoStatus)unserializeInt(buffer, end);
+	_detected = unserializeInt(buffer, end) != 0;
+	_hyperDetected = unserializeInt(buffer, end) != 0;
+	_secondsRemaining = unserializeInt(buffer, end);
+	_inBattlescape = unserializeInt(buffer, end) != 0;
+	int missionID = unserializeInt(buffer, end);
+	std::vector<AlienMission *>::const_iterator found = std::find_if(game.getAlienMissions().begin(), game.getAlienMissions().end(), matchMissionID(missionID));
+	if (found == game.getAlienMissions().end())
+	{
+		// Corrupt save file.
+		throw Exception("Unknown mission, save file is corrupt.");
+	}
+	_mission = *found;
+	_trajectory = ruleset.getUfoTrajectory(unserializeString(buffer, end));
+	_trajectoryPoint = unserializeInt(buffer, end);
+	if (_inBattlescape)
+		setSpeed(0);
+}
+
+/**
+ * Saves the UFO to binary, its type first for the loader to make
+ * it with. The destination is always a waypoint of the UFO's own,
+ * so only where it is gets saved.
+ * @param buffer Buffer to add the UFO to.
+ */
+void Ufo::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeString(buffer, _rules->getType());
+	MovingTarget::saveBinary(buffer);
+	serializeDouble(buffer, _dest != 0 ? _dest->getLongitude() : _lon);
+	serializeDouble(buffer, _dest != 0 ? _dest->getLatitude() : _lat);
+	serializeInt(buffer, _id);
+	serializeInt(buffer, _damage);
+	serializeString(buffer, _altitude);
+	serializeString(buffer, _direction);
+	serializeInt(buffer, _status);
+	serializeInt(buffer, _detected);
+	serializeInt(buffer, _hyperDetected);
+	serializeInt(buffer, _secondsRemaining);
+	serializeInt(buffer, _inBattlescape);
+	serializeInt(buffer, _mission->getId());
+	serializeString(buffer, _trajectory->getID());
+	serializeInt(buffer, _trajectoryPoint);
+}
+
+/**
+ * Saves the UFO's unique identifiers to binary.
+ * @param buffer Buffer to add the identifiers to.
+ */
+void Ufo::saveIdBinary(std::vector<Uint8> &buffer) const
+{
+	MovingTarget::saveIdBinary(buffer);
+	serializeString(buffer, "STR_UFO");
+	serializeInt(buffer, _id);
+}
+
 /**
  * Returns the ruleset for the UFO's type.
  * @return Pointer to ruleset.
@@ -68,6 +68,12 @@ public:
 	void save(YAML::Emitter& out) const;
 	/// Saves the UFO's ID to YAML.
 	void saveId(YAML::Emitter& out) const;
+	/// Loads the UFO from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end, const Ruleset &ruleset, SavedGame &game);
+	/// Saves the UFO to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
+	/// Saves the UFO's ID to binary.
+	void saveIdBinary(std::vector<Uint8> &buffer) const;
 	/// Gets the UFO's ruleset.
 	RuleUfo *getRules() const;
 	/// Gets the UFO's ID.
@@ -18,6 +18,7 @@
  */
 #include "Vehicle.h"
 #include "../Ruleset/RuleItem.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -59,6 +60,27 @@ void Vehicle::save(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the vehicle from binary.
+ * @param buffer Pointer to the vehicle data.
+ * @param end End of the save data.
+ */
+void Vehicle::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	_ammo = unserializeInt(buffer, end);
+}
+
+/**
+ * Saves the vehicle to binary, its type first
+ * for the loader to make it with.
+ * @param buffer Buffer to add the vehicle to.
+ */
+void Vehicle::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeString(buffer, _rules->getType());
+	serializeInt(buffer, _ammo);
+}
+
 /**
  * Returns the ruleset for the vehicle's type.
  * @return Pointer to ruleset.
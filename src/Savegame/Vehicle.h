@@ -20,6 +20,8 @@
 #define OPENXCOM_VEHICLE_H
 
 #include <string>
+#include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
 
 namespace OpenXcom
@@ -46,6 +48,10 @@ public:
 	void load(const YAML::Node& node);
 	/// Saves the vehicle to YAML.
 	void save(YAML::Emitter& out) const;
+	/// Loads the vehicle from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the vehicle to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 	/// Gets the vehicle's ruleset.
 	RuleItem *getRules() const;
 	/// Gets the vehicle's ammo.
@@ -19,6 +19,7 @@
 #include "Waypoint.h"
 #include <sstream>
 #include "../Engine/Language.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -70,6 +71,38 @@ void Waypoint::saveId(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Loads the waypoint from binary.
+ * @param buffer Pointer to the waypoint data.
+ * @param end End of the save data.
+ */
+void Waypoint::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	Target::loadBinary(buffer, end);
+	_id = unserializeInt(buffer, end);
+}
+
+/**
+ * Saves the waypoint to binary.
+ * @param buffer Buffer to add the waypoint to.
+ */
+void Waypoint::saveBinary(std::vector<Uint8> &buffer) const
+{
+	Target::saveBinary(buffer);
+	serializeInt(buffer, _id);
+}
+
+/**
+ * Saves the waypoint's unique identifiers to binary.
+ * @param buffer Buffer to add the identifiers to.
+ */
+void Waypoint::saveIdBinary(std::vector<Uint8> &buffer) const
+{
+	Target::saveIdBinary(buffer);
+	serializeString(buffer, "STR_WAYPOINT");
+	serializeInt(buffer, _id);
+}
+
 /**
  * Returns the waypoint's unique ID.
  * @return Unique ID.
@@ -44,6 +44,12 @@ public:
 	void save(YAML::Emitter& out) const;
 	/// Saves the waypoint's ID to YAML.
 	void saveId(YAML::Emitter& out) const;
+	/// Loads the waypoint from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Saves the waypoint to binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
+	/// Saves the waypoint's ID to binary.
+	void saveIdBinary(std::vector<Uint8> &buffer) const;
 	/// Gets the waypoint's ID.
 	int getId() const;
 	/// Sets the waypoint's ID.
@@ -18,6 +18,7 @@
  */
 #include "WeightedOptions.h"
 #include "../Engine/RNG.h"
+#include "SerializationHelper.h"
 
 namespace OpenXcom
 {
@@ -105,4 +106,35 @@ void WeightedOptions::save(YAML::Emitter &out) const
 	out << YAML::EndMap;
 }
 
+/**
+ * Add the weighted options saved by saveBinary to a WeightedOptions.
+ * Like with YAML, the list is not replaced, only added to / changed.
+ * @param buffer Pointer to the options.
+ * @param end End of the save data.
+ */
+void WeightedOptions::loadBinary(Uint8 **buffer, const Uint8 *end)
+{
+	int size = unserializeInt(buffer, end);
+	for (int i = 0; i < size; ++i)
+	{
+		std::string id = unserializeString(buffer, end);
+		unsigned w = unserializeInt(buffer, end);
+		set(id, w);
+	}
+}
+
+/**
+ * Send the WeightedOption contents to a binary buffer.
+ * @param buffer Buffer to add the options to.
+ */
+void WeightedOptions::saveBinary(std::vector<Uint8> &buffer) const
+{
+	serializeInt(buffer, _choices.size());
+	for (std::map<std::string, unsigned>::const_iterator ii = _choices.begin(); ii != _choices.end(); ++ii)
+	{
+		serializeString(buffer, ii->first);
+		serializeInt(buffer, ii->second);
+	}
+}
+
 }
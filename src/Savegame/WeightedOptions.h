@@ -21,6 +21,8 @@
 
 #include <string>
 #include <map>
+#include <vector>
+#include <SDL_types.h>
 #include <yaml-cpp/yaml.h>
 
 
@@ -48,6 +50,10 @@ public:
 	void load(const YAML::Node &node);
 	/// Store our list in YAML.
 	void save(YAML::Emitter &out) const;
+	/// Update our list with data from binary.
+	void loadBinary(Uint8 **buffer, const Uint8 *end);
+	/// Store our list in binary.
+	void saveBinary(std::vector<Uint8> &buffer) const;
 private:
 	std::map<std::string, unsigned> _choices; //!< Options and weights
 	unsigned _totalWeight; //!< The total weight of all options.
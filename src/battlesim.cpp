@@ -0,0 +1,447 @@
+/*
+ * Copyright 2010-2012 OpenXcom Developers.
+ *
+ * This file is part of OpenXcom.
+ *
+ * OpenXcom is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenXcom is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenXcom.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <exception>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <SDL.h>
+#include "Engine/Logger.h"
+#include "Engine/CrossPlatform.h"
+#include "Engine/Options.h"
+#include "Engine/RNG.h"
+#include "Resource/ResourcePack.h"
+#include "Ruleset/Ruleset.h"
+#include "Ruleset/MapDataSet.h"
+#include "Savegame/SavedGame.h"
+#include "Savegame/SavedBattleGame.h"
+#include "Savegame/BattleUnit.h"
+#include "Savegame/Tile.h"
+#include "Ruleset/Armor.h"
+#include "Battlescape/BattleSimulator.h"
+#include "Battlescape/TileEngine.h"
+#include "Battlescape/Pathfinding.h"
+
+using namespace OpenXcom;
+
+/**
+ * The little the battle needs from the game's resources without a screen or sound:
+ * the voxel shapes of the terrain. The map's own sprites come with its map data sets.
+ */
+class BattleSimResourcePack : public ResourcePack
+{
+public:
+	BattleSimResourcePack()
+	{
+		MapDataSet::loadLOFTEMPS(CrossPlatform::getDataFile("GEODATA/LOFTEMPS.DAT"), &_voxelData);
+	}
+};
+
+/**
+ * Gets a percentile of a set of sorted times.
+ * @param times Sorted times.
+ * @param percent Percentile to get.
+ * @return The time, in milliseconds.
+ */
+static double percentile(const std::vector<double> &times, int percent)
+{
+	if (times.empty())
+		return 0;
+	size_t i = (times.size() - 1) * percent / 100;
+	return times[i] * 1000;
+}
+
+/**
+ * Loads a battle save with its map, ready to play.
+ * @param save Name of the save.
+ * @param rules Pointer to the ruleset.
+ * @param res Pointer to the resources.
+ * @return The saved game, 0 if it holds no battle.
+ */
+static SavedGame *loadBattle(const std::string &save, Ruleset *rules, ResourcePack *res)
+{
+	SavedGame *game = new SavedGame();
+	game->load(save, rules);
+	if (game->getBattleGame() == 0)
+	{
+		std::cerr << save << " is not a battle save" << std::endl;
+		delete game;
+		return 0;
+	}
+	game->getBattleGame()->loadMapResources(res);
+	return game;
+}
+
+/**
+ * Traces random lines of fire between the voxels of a battle's map, once stepping over
+ * the tiles with nothing to hit and once walking every voxel while storing the trajectory,
+ * the way every line was traced before, and reports the rays per second of each.
+ * @param battle Pointer to the battle.
+ * @param rays Number of rays.
+ */
+static void benchmarkRays(SavedBattleGame *battle, int rays)
+{
+	TileEngine *engine = battle->getTileEngine();
+	// the same rays every run
+	RNG::init(0, 1);
+	std::vector<Position> origins, targets;
+	for (int i = 0; i < rays; ++i)
+	{
+		origins.push_back(Position(RNG::generate(0, battle->getMapSizeX() * 16 - 1), RNG::generate(0, battle->getMapSizeY() * 16 - 1), RNG::generate(0, battle->getMapSizeZ() * 24 - 1)));
+		targets.push_back(Position(RNG::generate(0, battle->getMapSizeX() * 16 - 1), RNG::generate(0, battle->getMapSizeY() * 16 - 1), RNG::generate(0, battle->getMapSizeZ() * 24 - 1)));
+	}
+
+	std::vector<int> results(rays);
+	double start = CrossPlatform::getTime();
+	for (int i = 0; i < rays; ++i)
+	{
+		results[i] = engine->calculateLine(origins[i], targets[i], false, 0, 0);
+	}
+	double stepped = CrossPlatform::getTime() - start;
+
+	std::vector<Position> trajectory;
+	int different = 0;
+	start = CrossPlatform::getTime();
+	for (int i = 0; i < rays; ++i)
+	{
+		trajectory.clear();
+		if (engine->calculateLine(origins[i], targets[i], true, &trajectory, 0) != results[i])
+			different++;
+	}
+	double walked = CrossPlatform::getTime() - start;
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "map:            " << battle->getMapSizeX() << "x" << battle->getMapSizeY() << "x" << battle->getMapSizeZ() << std::endl;
+	std::cout << "rays:           " << rays << " (" << different << " hit something else walking every voxel)" << std::endl;
+	std::cout << "rays/sec:       " << (stepped > 0 ? rays / stepped : 0) << std::endl;
+	std::cout << "voxel walk/sec: " << (walked > 0 ? rays / walked : 0) << std::endl;
+}
+
+/**
+ * Works out the tiles a player's unit discovers the way TileEngine::calculateFOV did
+ * before the ray fans: a line of its own to every tile in view, walked voxel by voxel.
+ * @param battle Pointer to the battle.
+ * @param unit The watcher.
+ * @param discovered Gets the parts of every tile discovered: 1 westwall, 2 northwall, 4 content+floor.
+ */
+static void calculateFOVByLines(SavedBattleGame *battle, BattleUnit *unit, std::vector<Uint8> *discovered)
+{
+	const int viewDistance = 20;
+	TileEngine *engine = battle->getTileEngine();
+	Position center = unit->getPosition();
+	int direction = battle->getStrafeSetting() && unit->getTurretType() > -1 ? unit->getTurretDirection() : unit->getDirection();
+	bool swap = (direction==0 || direction==4);
+	int signX[8] = { +1, +1, +1, +1, -1, -1, -1, -1 };
+	int signY[8] = { -1, -1, -1, +1, +1, +1, -1, -1 };
+	std::vector<Position> trajectory;
+
+	Position pos = center;
+	if ((unit->getHeight() + unit->getFloatHeight() + -battle->getTile(center)->getTerrainLevel()) >= 24 + 4)
+	{
+		++pos.z;
+	}
+	for (int x = 0; x <= viewDistance; ++x)
+	{
+		int y1 = direction%2 ? 0 : -x;
+		int y2 = direction%2 ? viewDistance : x;
+		for (int y = y1; y <= y2; ++y)
+		{
+			for (int z = 0; z < battle->getMapSizeZ(); z++)
+			{
+				if (int(floor(sqrt(float(x*x + y*y)) + 0.5)) > viewDistance)
+					continue;
+				Position test(center.x + signX[direction]*(swap?y:x), center.y + signY[direction]*(swap?x:y), z);
+				if (!battle->getTile(test))
+					continue;
+				// large units have "4 pair of eyes"
+				int size = unit->getArmor()->getSize();
+				for (int xo = 0; xo < size; xo++)
+				{
+					for (int yo = 0; yo < size; yo++)
+					{
+						trajectory.clear();
+						int tst = engine->calculateLine(pos + Position(xo,yo,0), test, true, &trajectory, unit, false);
+						size_t tsize = trajectory.size();
+						if (tst>127) --tsize; //last tile is blocked thus must be cropped
+						for (size_t i = 0; i < tsize; i++)
+						{
+							Position posi = trajectory[i];
+							(*discovered)[battle->getTileIndex(posi)] |= 7;
+							// walls to the east or south of a visible tile, we see that too
+							if (battle->getTile(Position(posi.x + 1, posi.y, posi.z)))
+								(*discovered)[battle->getTileIndex(Position(posi.x + 1, posi.y, posi.z))] |= 1;
+							if (battle->getTile(Position(posi.x, posi.y + 1, posi.z)))
+								(*discovered)[battle->getTileIndex(Position(posi.x, posi.y + 1, posi.z))] |= 2;
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Works out what every player's unit in a battle sees, once along the ray fans and once
+ * with a line to every tile the way it was done before, and reports how long each took
+ * and how many tiles they disagree on.
+ * @param battle Pointer to the battle.
+ * @param rounds Number of times to look around with every unit.
+ */
+static void benchmarkFOV(SavedBattleGame *battle, int rounds)
+{
+	TileEngine *engine = battle->getTileEngine();
+	std::vector<BattleUnit*> units;
+	for (std::vector<BattleUnit*>::iterator i = battle->getUnits()->begin(); i != battle->getUnits()->end(); ++i)
+	{
+		if ((*i)->getFaction() == FACTION_PLAYER && !(*i)->isOut())
+			units.push_back(*i);
+	}
+
+	std::vector<Uint8> expected(battle->getMapSizeXYZ());
+	double fans = 0, lines = 0;
+	int different = 0;
+	for (int r = 0; r < rounds; ++r)
+	{
+		for (std::vector<BattleUnit*>::iterator i = units.begin(); i != units.end(); ++i)
+		{
+			for (int t = 0; t < battle->getMapSizeXYZ(); ++t)
+			{
+				for (int part = 0; part < 3; ++part)
+				{
+					battle->setTileDiscovered(battle->getTiles()[t], false, part);
+				}
+			}
+			// nothing is taken from what was traced before
+			engine->invalidateFOVCache();
+			double start = CrossPlatform::getTime();
+			engine->calculateFOV(*i);
+			fans += CrossPlatform::getTime() - start;
+
+			std::fill(expected.begin(), expected.end(), 0);
+			start = CrossPlatform::getTime();
+			calculateFOVByLines(battle, *i, &expected);
+			lines += CrossPlatform::getTime() - start;
+
+			if (r == 0)
+			{
+				for (int t = 0; t < battle->getMapSizeXYZ(); ++t)
+				{
+					Uint8 discovered = 0;
+					for (int part = 0; part < 3; ++part)
+					{
+						if (battle->isTileDiscovered(battle->getTiles()[t]->getPosition(), part))
+							discovered |= 1 << part;
+					}
+					if (discovered != expected[t])
+						different++;
+				}
+			}
+		}
+	}
+
+	int traces = rounds * units.size();
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "map:            " << battle->getMapSizeX() << "x" << battle->getMapSizeY() << "x" << battle->getMapSizeZ() << std::endl;
+	std::cout << "fov traces:     " << traces << " (" << units.size() << " units, " << different << " tiles seen differently)" << std::endl;
+	std::cout << "ray fans ms:    " << (traces > 0 ? fans * 1000 / traces : 0) << std::endl;
+	std::cout << "lines ms:       " << (traces > 0 ? lines * 1000 / traces : 0) << std::endl;
+	std::cout << "speedup:        " << (fans > 0 ? lines / fans : 0) << std::endl;
+}
+
+/**
+ * Replays the A* requests recorded with the battleRecordPaths option on the battle
+ * they were recorded on, and reports how long they took.
+ * @param battle Pointer to the battle.
+ * @param save Name of the save the battle was loaded from.
+ * @param log Path of the recorded requests.
+ * @return False if the log wasn't recorded on this battle.
+ */
+static bool benchmarkPaths(SavedBattleGame *battle, const std::string &save, const std::string &log)
+{
+	std::ifstream file(log.c_str());
+	int turn;
+	std::string recorded;
+	if (!(file >> turn) || !std::getline(file >> std::ws, recorded))
+	{
+		std::cerr << log << " is not a paths log" << std::endl;
+		return false;
+	}
+	if (recorded != save || turn != battle->getTurn())
+	{
+		std::cerr << log << " was recorded on " << recorded << " turn " << turn << ", not on " << save << " turn " << battle->getTurn() << std::endl;
+		return false;
+	}
+
+	int paths, found;
+	int time = battle->getPathfinding()->replayPaths(file, &paths, &found);
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "map:            " << battle->getMapSizeX() << "x" << battle->getMapSizeY() << "x" << battle->getMapSizeZ() << std::endl;
+	std::cout << "paths:          " << paths << " (" << found << " found)" << std::endl;
+	std::cout << "paths ms:       " << time << std::endl;
+	std::cout << "path ms:        " << (paths > 0 ? double(time) / paths : 0) << std::endl;
+	return true;
+}
+
+// Plays saved battles with the AI on every side and no screen, and reports how long it took.
+// usage: openxcom-battlesim [-data PATH] [-user PATH] SAVE [BATTLES [TURNS]]
+//        openxcom-battlesim [-data PATH] [-user PATH] rays SAVE [RAYS]
+//        openxcom-battlesim [-data PATH] [-user PATH] fov SAVE [ROUNDS]
+//        openxcom-battlesim [-data PATH] [-user PATH] paths SAVE LOG
+// SAVE is the name of a battle save in the user folder, without the .sav
+// "rays" times random lines of fire across the save's map instead of playing it.
+// "fov" times the player's units looking around against the old line per tile,
+// best on a 60x60x4 map such as a medium ufo crash site.
+// "paths" replays the A* requests recorded to LOG with the battleRecordPaths option,
+// which only works on the save and turn they were recorded on.
+int main(int argc, char** args)
+{
+	Logger::reportingLevel() = LOG_WARNING;
+	std::vector<std::string> params;
+	for (int i = 1; i < argc; ++i)
+	{
+		// dashed options take a value, everything else is ours
+		if (args[i][0] == '-')
+			++i;
+		else
+			params.push_back(args[i]);
+	}
+	if (params.empty())
+	{
+		std::cerr << "usage: " << args[0] << " [-data PATH] [-user PATH] SAVE [BATTLES [TURNS]]" << std::endl;
+		std::cerr << "       " << args[0] << " [-data PATH] [-user PATH] rays SAVE [RAYS]" << std::endl;
+		std::cerr << "       " << args[0] << " [-data PATH] [-user PATH] fov SAVE [ROUNDS]" << std::endl;
+		std::cerr << "       " << args[0] << " [-data PATH] [-user PATH] paths SAVE LOG" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::string mode;
+	if ((params[0] == "rays" || params[0] == "fov" || params[0] == "paths") && params.size() > 1)
+	{
+		mode = params[0];
+		params.erase(params.begin());
+	}
+	std::string save = params[0];
+	int battles = params.size() > 1 ? std::max(1, atoi(params[1].c_str())) : 10;
+	int turns = params.size() > 2 ? std::max(1, atoi(params[2].c_str())) : 40;
+	int rays = params.size() > 1 ? std::max(1, atoi(params[1].c_str())) : 1000000;
+	int rounds = params.size() > 1 ? std::max(1, atoi(params[1].c_str())) : 10;
+	if (mode == "paths" && params.size() < 2)
+	{
+		std::cerr << "usage: " << args[0] << " [-data PATH] [-user PATH] paths SAVE LOG" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	try
+	{
+		if (!Options::init(argc, args))
+			return EXIT_SUCCESS;
+		// no video or audio, just the timer and threads the battle uses
+		if (SDL_Init(SDL_INIT_TIMER) < 0)
+		{
+			std::cerr << SDL_GetError() << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		Ruleset *rules = new Ruleset();
+		std::vector<std::string> rulesets = Options::getRulesets();
+		for (std::vector<std::string>::iterator i = rulesets.begin(); i != rulesets.end(); ++i)
+		{
+			rules->load(*i);
+		}
+		ResourcePack *res = new BattleSimResourcePack();
+
+		if (!mode.empty())
+		{
+			SavedGame *game = loadBattle(save, rules, res);
+			if (game == 0)
+				return EXIT_FAILURE;
+			bool ok = true;
+			if (mode == "rays")
+				benchmarkRays(game->getBattleGame(), rays);
+			else if (mode == "fov")
+				benchmarkFOV(game->getBattleGame(), rounds);
+			else
+				ok = benchmarkPaths(game->getBattleGame(), save, params[1]);
+			delete game;
+			delete res;
+			delete rules;
+			SDL_Quit();
+			return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+
+		std::vector<double> turnTimes;
+		double total = 0, ai = 0, pathfinding = 0, fov = 0, explosions = 0;
+		int finished = 0, plans = 0, planHits = 0, planMisses = 0;
+		for (int b = 0; b < battles; ++b)
+		{
+			// the save brings its own random seed, so every run plays out the same
+			SavedGame *game = loadBattle(save, rules, res);
+			if (game == 0)
+				return EXIT_FAILURE;
+			SavedBattleGame *battle = game->getBattleGame();
+
+			BattleSimulator sim(battle, rules, res, game->getDifficulty());
+			double start = CrossPlatform::getTime();
+			sim.run(turns);
+			total += CrossPlatform::getTime() - start;
+			turnTimes.insert(turnTimes.end(), sim.getTurnTimes().begin(), sim.getTurnTimes().end());
+			ai += sim.getAITime();
+			pathfinding += sim.getPathfindingTime();
+			fov += sim.getFOVTime();
+			explosions += sim.getExplosionTime();
+			int p, h, m;
+			sim.getPlanCounts(&p, &h, &m);
+			plans += p;
+			planHits += h;
+			planMisses += m;
+			if (sim.isOver())
+				finished++;
+			delete game;
+		}
+		std::sort(turnTimes.begin(), turnTimes.end());
+
+		std::cout << std::fixed << std::setprecision(3);
+		std::cout << "battles:        " << battles << " (" << finished << " fought to the end, " << turnTimes.size() << " side turns)" << std::endl;
+		std::cout << "battles/sec:    " << (total > 0 ? battles / total : 0) << std::endl;
+		std::cout << "turn ms p50:    " << percentile(turnTimes, 50) << std::endl;
+		std::cout << "turn ms p90:    " << percentile(turnTimes, 90) << std::endl;
+		std::cout << "turn ms p99:    " << percentile(turnTimes, 99) << std::endl;
+		std::cout << "turn ms max:    " << percentile(turnTimes, 100) << std::endl;
+		std::cout << "total s:        " << total << std::endl;
+		std::cout << "ai s:           " << ai << std::endl;
+		std::cout << "pathfinding s:  " << pathfinding << std::endl;
+		std::cout << "fov s:          " << fov << std::endl;
+		std::cout << "explosions s:   " << explosions << std::endl;
+		std::cout << "plans:          " << plans << " (" << planHits << " used, " << planMisses << " worked out again)" << std::endl;
+
+		delete res;
+		delete rules;
+		SDL_Quit();
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}